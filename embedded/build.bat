@@ -2,8 +2,11 @@ cd %~dp0
 cmd.exe /c npm install
 cmd.exe /c gulp package
 cmd.exe /c bin2c -o nofile.h -m tool.html.gz
+for /f %%i in ('md5sum tool.html.gz ^| cut -c1-8') do set PAGE_ETAG=%%i
 cat header.txt > out.h
 cat nofile.h >> out.h
+echo //md5 of tool.html.gz, changes each time page is generated so browsers reload it>> out.h
+echo #define PAGE_NOFILES_ETAG "\"%PAGE_ETAG%\"">> out.h
 cat footer.txt >> out.h
 sed -i "s/tool_html_gz_size/PAGE_NOFILES_SIZE/g" ./out.h
 sed -i "s/const unsigned char tool_html_gz/const char PAGE_NOFILES/g" ./out.h
@@ -448,4 +448,6 @@ const char PAGE_NOFILES[6714] PROGMEM = {
     0xCF, 0xBF, 0x1B, 0x1D, 0x1F, 0xA9, 0x63, 0xE4, 0xC7, 0x47, 0xEA, 0xD7, 0x2B, 0xF4, 0x6F, 0x47,
     0xFF, 0x2F, 0x1A, 0xAA, 0x4C, 0x85, 0x42, 0x5A, 0x00, 0x00
 };
+//md5 of tool.html.gz, changes each time page is generated so browsers reload it
+#define PAGE_NOFILES_ETAG "\"5f0c944e\""
 #endif //__nofile_h
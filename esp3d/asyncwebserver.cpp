@@ -46,6 +46,17 @@
 #include "GenLinkedList.h"
 #include "command.h"
 #include "espcom.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "gcode_stream.h"
+#include "marlin_binary.h"
+#include "cmdqueue.h"
+#include "telemetry.h"
+#endif
+#include "jsonwriter.h"
+#include "fsindex.h"
+#ifdef CONFIG_JOURNAL_FEATURE
+#include "configjournal.h"
+#endif
 
 #ifdef SSDP_FEATURE
 #ifdef ARDUINO_ARCH_ESP32
@@ -72,6 +83,12 @@ const uint8_t PAGE_CAPTIVE [] PROGMEM = "<HTML>\n<HEAD>\n<title>Captive Portal</
 //filter to intercept command line on root
 bool filterOnRoot (AsyncWebServerRequest *request)
 {
+#ifdef CONFIG_JOURNAL_FEATURE
+    //journal has all settings, passwords included
+    if (CONFIG_JOURNAL::is_journal (request->url().c_str()) ) {
+        return false;
+    }
+#endif
     if (request->hasArg ("forcefallback") ) {
         String stmp = request->arg ("forcefallback");
         //to use all case
@@ -199,26 +216,21 @@ void handleFileList (AsyncWebServerRequest *request)
             filename.replace ("//", "/");
             if (!SPIFFS.exists (filename) ) {
                 status = shortname + F (" does not exists!");
+#ifdef CONFIG_JOURNAL_FEATURE
+            } else if (CONFIG_JOURNAL::is_journal (filename.c_str() ) ) {
+                status = shortname + F (" does not exists!");
+#endif
             } else {
                 if (SPIFFS.remove (filename) ) {
                     status = shortname + F (" deleted");
+                    FS_INDEX::update (filename.c_str() );
                     //what happen if no "/." and no other subfiles ?
-#ifdef ARDUINO_ARCH_ESP8266
-                    FS_DIR dir = SPIFFS.openDir (path);
-                    if (!dir.next() ) {
-#else
-                    String ptmp = path;
-                    if ( (path != "/") && (path[path.length() - 1] = '/') ) {
-                        ptmp = path.substring (0, path.length() - 1);
-                    }
-                    FS_FILE dir = SPIFFS.open (ptmp);
-                    FS_FILE dircontent = dir.openNextFile();
-                    if (!dircontent) {
-#endif
+                    if (FS_INDEX::is_empty (path) ) {
                         //keep directory alive even empty
                         FS_FILE r = SPIFFS.open (path + "/.", SPIFFS_FILE_WRITE);
                         if (r) {
                             r.close();
+                            FS_INDEX::update ( (path + "/.").c_str() );
                         }
                     }
                 } else {
@@ -251,12 +263,21 @@ void handleFileList (AsyncWebServerRequest *request)
                         String fullpath = dir.fileName();
 #else
                         String fullpath = file2deleted.name();
+#endif
+#ifdef CONFIG_JOURNAL_FEATURE
+                        if (CONFIG_JOURNAL::is_journal (fullpath.c_str() ) ) {
+#ifdef ARDUINO_ARCH_ESP32
+                            file2deleted = dir.openNextFile();
+#endif
+                            continue;
+                        }
 #endif
                         if (!SPIFFS.remove (fullpath) ) {
                             delete_error = true;
                             status = F ("Cannot deleted ") ;
                             status += fullpath;
                         }
+                        FS_INDEX::update (fullpath.c_str() );
 #ifdef ARDUINO_ARCH_ESP32
                         file2deleted = dir.openNextFile();
 #endif
@@ -284,87 +305,21 @@ void handleFileList (AsyncWebServerRequest *request)
                     status += shortname ;
                 } else {
                     r.close();
+                    FS_INDEX::update (filename.c_str() );
                     status = shortname + F (" created");
                 }
             }
         }
     }
-    String jsonfile = "{";
-#ifdef ARDUINO_ARCH_ESP8266
-    FS_DIR dir = SPIFFS.openDir (path);
-#else
-    String ptmp = path;
-    if ( (path != "/") && (path[path.length() - 1] = '/') ) {
-        ptmp = path.substring (0, path.length() - 1);
-    }
-    FS_FILE dir = SPIFFS.open (ptmp);
-#endif
-    jsonfile += "\"files\":[";
-    bool firstentry = true;
-    String subdirlist = "";
-#ifdef ARDUINO_ARCH_ESP8266
-    while (dir.next() ) {
-        String filename = dir.fileName();
-#else
-    File fileparsed = dir.openNextFile();
-    while (fileparsed) {
-        String filename = fileparsed.name();
-#endif
-        String size = "";
-        bool addtolist = true;
-        //remove path from name
-        filename = filename.substring (path.length(), filename.length() );
-        //check if file or subfile
-        if (filename.indexOf ("/") > -1) {
-            //Do not rely on "/." to define directory as SPIFFS upload won't create it but directly files
-            //and no need to overload SPIFFS if not necessary to create "/." if no need
-            //it will reduce SPIFFS available space so limit it to creation
-            filename = filename.substring (0, filename.indexOf ("/") );
-            String tag = "*";
-            tag += filename + "*";
-            if (subdirlist.indexOf (tag) > -1 || filename.length() == 0) { //already in list
-                addtolist = false; //no need to add
-            } else {
-                size = "-1"; //it is subfile so display only directory, size will be -1 to describe it is directory
-                if (subdirlist.length() == 0) {
-                    subdirlist += "*";
-                }
-                subdirlist += filename + "*"; //add to list
-            }
-        } else {
-            //do not add "." file
-            if (! ( (filename == ".") || (filename == "") ) ) {
-#ifdef ARDUINO_ARCH_ESP8266
-                size = CONFIG::formatBytes (dir.fileSize() );
-#else
-                size = CONFIG::formatBytes (fileparsed.size() );
-#endif
-
-            } else {
-                addtolist = false;
-            }
-        }
-        if (addtolist) {
-            if (!firstentry) {
-                jsonfile += ",";
-            } else {
-                firstentry = false;
-            }
-            jsonfile += "{";
-            jsonfile += "\"name\":\"";
-            jsonfile += filename;
-            jsonfile += "\",\"size\":\"";
-            jsonfile += size;
-            jsonfile += "\"";
-            jsonfile += "}";
-        }
-#ifdef ARDUINO_ARCH_ESP32
-        fileparsed = dir.openNextFile();
-#endif
-    }
-    jsonfile += "],";
-    jsonfile += "\"path\":\"" + path + "\",";
-    jsonfile += "\"status\":\"" + status + "\",";
+    AsyncResponseStream  *response = request->beginResponseStream ("application/json");
+    response->addHeader ("Cache-Control", "no-cache");
+    JSON_WRITER writer (WEB_PIPE, response);
+    writer.print (F ("{\"files\":[") );
+    FS_INDEX::list (path, writer);
+    writer.print (F ("],\"path\":\"") );
+    writer.print (path);
+    writer.print (F ("\",\"status\":\"") );
+    writer.print (status);
     size_t totalBytes;
     size_t usedBytes;
 #ifdef ARDUINO_ARCH_ESP8266
@@ -376,16 +331,14 @@ void handleFileList (AsyncWebServerRequest *request)
     totalBytes = SPIFFS.totalBytes();
     usedBytes = SPIFFS.usedBytes();
 #endif
-    jsonfile += "\"total\":\"" + CONFIG::formatBytes (totalBytes) + "\",";
-    jsonfile += "\"used\":\"" + CONFIG::formatBytes (usedBytes) + "\",";
-    jsonfile.concat (F ("\"occupation\":\"") );
-    jsonfile += CONFIG::intTostr (100 * usedBytes / totalBytes);
-    jsonfile += "\"";
-    jsonfile += "}";
-    path = "";
-    AsyncResponseStream  *response = request->beginResponseStream ("application/json");
-    response->addHeader ("Cache-Control", "no-cache");
-    response->print (jsonfile.c_str() );
+    writer.print (F ("\",\"total\":\"") );
+    writer.print (CONFIG::formatBytes (totalBytes) );
+    writer.print (F ("\",\"used\":\"") );
+    writer.print (CONFIG::formatBytes (usedBytes) );
+    writer.print (F ("\",\"occupation\":\"") );
+    writer.print (CONFIG::intTostr (100 * usedBytes / totalBytes) );
+    writer.print (F ("\"}") );
+    writer.flush();
     request->send (response);
     web_interface->_upload_status = UPLOAD_STATUS_NONE;
 }
@@ -417,6 +370,14 @@ void SPIFFSFileupload (AsyncWebServerRequest *request, String filename, size_t i
         String filename = upload_filename;
         upload_filename = "/user" + filename;
     }
+#ifdef CONFIG_JOURNAL_FEATURE
+    if (CONFIG_JOURNAL::is_journal (upload_filename.c_str() ) ) {
+        web_interface->_upload_status = UPLOAD_STATUS_FAILED;
+        LOG ("Upload rejected\r\n");
+        request->client()->abort();
+        return;
+    }
+#endif
     //Upload start
     //**************
     if (!index) {
@@ -463,6 +424,9 @@ void SPIFFSFileupload (AsyncWebServerRequest *request, String filename, size_t i
                 SPIFFS.remove (upload_filename);
             }
         }
+        FS_INDEX::update (upload_filename.c_str() );
+        //web files validator is ready for first request
+        FS_INDEX::etag (upload_filename.c_str() );
         LOG ("Close file\n")
         if (web_interface->_upload_status == UPLOAD_STATUS_ONGOING) {
             web_interface->_upload_status = UPLOAD_STATUS_SUCCESSFUL;
@@ -594,8 +558,14 @@ void handle_not_found (AsyncWebServerRequest *request)
 {
     //if we are here it means no index.html
     if (request->url() == "/") {
+        if (request->hasHeader ("If-None-Match") && (request->getHeader ("If-None-Match")->value().indexOf (PAGE_NOFILES_ETAG) != -1) ) {
+            request->send (304);
+            return;
+        }
         AsyncWebServerResponse * response = request->beginResponse_P (200, CONTENT_TYPE_HTML, PAGE_NOFILES, PAGE_NOFILES_SIZE);
         response->addHeader ("Content-Encoding", "gzip");
+        response->addHeader ("ETag", PAGE_NOFILES_ETAG);
+        response->addHeader ("Cache-Control", WEB_CACHE_CONTROL);
         request->send (response);
     } else {
         String path = F ("/404.htm");
@@ -628,6 +598,7 @@ void handle_not_found (AsyncWebServerRequest *request)
 //Handle web command query and send answer//////////////////////////////
 void handle_web_command (AsyncWebServerRequest *request)
 {
+    uint32_t start_us = micros();
     //to save time if already disconnected
     if (request->hasArg ("PAGEID") ) {
         if (request->arg ("PAGEID").length() > 0 ) {
@@ -696,6 +667,15 @@ void handle_web_command (AsyncWebServerRequest *request)
             request->send (401, "text/plain", "Authentication failed!\n");
             return;
         }
+        //emergency and grbl real time commands must not wait
+        if (ESPCOM::is_urgent (cmd.c_str())) {
+            if (ESPCOM::send_urgent (cmd.c_str(), start_us)) {
+                request->send (200, "text/plain", "ok");
+            } else {
+                request->send (200, "text/plain", "Serial is busy, retry later!");
+            }
+            return;
+        }
         //send command to serial as no need to transfer ESP command
         //to avoid any pollution if Uploading file to SDCard
         if ( (web_interface->blockserial) == false) {
@@ -713,9 +693,14 @@ void handle_web_command (AsyncWebServerRequest *request)
             request->onDisconnect([request]() {
                 can_process_serial = true;
             });
-            //send command
+            //send command when printer has free slot
             LOG ("Send Command\r\n")
-            ESPCOM::println (cmd, DEFAULT_PRINTER_PIPE);
+            if (!CMD_QUEUE::send (cmd.c_str(), ORIGIN_WEB)) {
+                can_process_serial = true;
+                web_interface->blockserial = false;
+                request->send (200, "text/plain", "Printer is busy, retry later!");
+                return;
+            }
             CONFIG::wait (1);
             AsyncWebServerResponse *response = request->beginChunkedResponse ("text/plain", [] (uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
                 static bool  finish_check;
@@ -799,6 +784,7 @@ void handle_web_command (AsyncWebServerRequest *request)
                         //read full buffer instead of read char by char
                         //so it give time to refill when processing
                         ESPCOM::readBytes (DEFAULT_PRINTER_PIPE, &active_serial_buffer[active_serial_buffer_size], len);
+                        ESPCOM::process_answers (&active_serial_buffer[active_serial_buffer_size], len);
                         //new size of current buffer
                         active_serial_buffer_size += len;
                     }
@@ -981,6 +967,7 @@ void handle_web_command (AsyncWebServerRequest *request)
 //Handle web command query and sent ack or fail instead of answer///////
 void handle_web_command_silent (AsyncWebServerRequest *request)
 {
+    uint32_t start_us = micros();
     //to save time if already disconnected
     if (request->hasArg ("PAGEID") ) {
         if (request->arg ("PAGEID").length() > 0 ) {
@@ -1048,14 +1035,25 @@ void handle_web_command_silent (AsyncWebServerRequest *request)
             //if not is not a valid [ESPXXX] command
         }
     } else {
+        //emergency and grbl real time commands must not wait
+        if (ESPCOM::is_urgent (cmd.c_str())) {
+            if (ESPCOM::send_urgent (cmd.c_str(), start_us)) {
+                request->send (200, "text/plain", "ok");
+            } else {
+                request->send (200, "text/plain", "Serial is busy, retry later!");
+            }
+            return;
+        }
         //send command to serial as no need to transfer ESP command
         //to avoid any pollution if Uploading file to SDCard
         if ( (web_interface->blockserial) == false) {
             LOG ("Send Command\r\n")
-            //send command
-            ESPCOM::println (cmd, DEFAULT_PRINTER_PIPE);
-
-            request->send (200, "text/plain", "ok");
+            //send command when printer has free slot
+            if (CMD_QUEUE::send (cmd.c_str(), ORIGIN_WEB)) {
+                request->send (200, "text/plain", "ok");
+            } else {
+                request->send (200, "text/plain", "Printer is busy, retry later!");
+            }
         } else {
             request->send (200, "text/plain", "Serial is busy, retry later!");
         }
@@ -1063,6 +1061,19 @@ void handle_web_command_silent (AsyncWebServerRequest *request)
 }
 
 //serial SD files list//////////////////////////////////////////////////
+//Printer telemetry from cached values
+void handle_telemetry (AsyncWebServerRequest *request)
+{
+    if (web_interface->is_authenticated() == LEVEL_GUEST) {
+        request->send (401, "application/json", "{\"status\":\"Authentication failed!\"}");
+        return;
+    }
+    AsyncResponseStream  *response = request->beginResponseStream ("application/json");
+    response->addHeader ("Cache-Control", "no-cache");
+    response->print (TELEMETRY::json().c_str() );
+    request->send (response);
+}
+
 void handle_serial_SDFileList (AsyncWebServerRequest *request)
 {
     //this is only for admin and user
@@ -1160,14 +1171,19 @@ void SDFile_serial_upload (AsyncWebServerRequest *request, String filename, size
         //besure nothing left again
         purge_serial();
         command = "M28 " + current_filename;
-        //send start upload
+        //use binary transfer if firmware supports it, else send start upload
         //no correction allowed because it means reset numbering was failed
-        if (sendLine2Serial(command, lineNb, NULL)) {
+        if (MARLIN_BINARY::begin (current_filename.c_str())) {
+            web_interface->_upload_status= UPLOAD_STATUS_ONGOING;
+            LOG("Binary creation Ok\r\n")
+        } else if (sendLine2Serial(command, lineNb, NULL)) {
             CONFIG::wait(1200);
             //additional purge, in case it is slow to answer
             purge_serial();
             web_interface->_upload_status= UPLOAD_STATUS_ONGOING;
             LOG("Creation Ok\r\n")
+            //now lines are streamed without waiting each ok
+            GCODE_STREAM::begin(lineNb + 1);
 
         } else  {
             web_interface->_upload_status= UPLOAD_STATUS_FAILED;
@@ -1176,6 +1192,30 @@ void SDFile_serial_upload (AsyncWebServerRequest *request, String filename, size
     }
     //Upload write
     //**************
+    //binary transfer sends file as it is
+    if (MARLIN_BINARY::is_active()) {
+        if (len && !MARLIN_BINARY::write (data, len)) {
+            LOG ("Error sending binary data\n")
+            MARLIN_BINARY::abort();
+            lineNb++;
+            CloseSerialUpload (true, current_filename, lineNb);
+            request->client()->abort();
+            return;
+        }
+        if (final) {
+            if (MARLIN_BINARY::end()) {
+                LOG ("Binary upload finished\n")
+                ESPCOM::println (F ("SD upload done"), PRINTER_PIPE);
+                web_interface->_upload_status = UPLOAD_STATUS_SUCCESSFUL;
+                web_interface->blockserial = false;
+            } else {
+                lineNb++;
+                CloseSerialUpload (true, current_filename, lineNb);
+                request->client()->abort();
+            }
+        }
+        return;
+    }
     if ( ( web_interface->_upload_status = UPLOAD_STATUS_ONGOING) && len) {
         LOG ("Writing to serial\n")
         for (int pos = 0; pos < len; pos++) { //parse full post data
@@ -1193,9 +1233,9 @@ void SDFile_serial_upload (AsyncWebServerRequest *request, String filename, size
                 if (current_line.length() < 126) {
                     //do we have something in buffer ?
                     if (current_line.length() > 0 ) {
-                        lineNb++;
-                        if (!sendLine2Serial (current_line, lineNb, NULL) ) {
+                        if (!GCODE_STREAM::push (current_line.c_str()) ) {
                             LOG ("Error sending line\n")
+                            lineNb = GCODE_STREAM::end();
                             CloseSerialUpload (true, current_filename,lineNb);
                             request->client()->abort();
                             return;
@@ -1209,7 +1249,7 @@ void SDFile_serial_upload (AsyncWebServerRequest *request, String filename, size
                 } else {
                     //error buffer overload
                     LOG ("Error over buffer\n")
-                    lineNb++;
+                    lineNb = GCODE_STREAM::end();
                     CloseSerialUpload (true, current_filename, lineNb);
                     request->client()->abort();
                     return;
@@ -1219,7 +1259,7 @@ void SDFile_serial_upload (AsyncWebServerRequest *request, String filename, size
                     current_line += char (data[pos]);  //copy current char to buffer to send/resend
                 } else {
                     LOG ("Error over buffer\n")
-                    lineNb++;
+                    lineNb = GCODE_STREAM::end();
                     CloseSerialUpload (true, current_filename, lineNb);
                     request->client()->abort();
                     return;
@@ -1237,17 +1277,24 @@ void SDFile_serial_upload (AsyncWebServerRequest *request, String filename, size
         LOG ("Final is reached\n")
         //if last part does not have '\n'
         if (current_line.length()  > 0) {
-            lineNb++;
-            if (!sendLine2Serial (current_line, lineNb, NULL) ) {
+            if (!GCODE_STREAM::push (current_line.c_str()) ) {
                 LOG ("Error sending buffer\n")
-                lineNb++;
+                lineNb = GCODE_STREAM::end();
                 CloseSerialUpload (true, current_filename, lineNb);
                 request->client()->abort();
                 return;
             }
         }
+        //wait for all lines in flight to be acknowledged
+        if (!GCODE_STREAM::flush()) {
+            LOG ("Error flushing stream\n")
+            lineNb = GCODE_STREAM::end();
+            CloseSerialUpload (true, current_filename, lineNb);
+            request->client()->abort();
+            return;
+        }
         LOG ("Upload finished ");
-        lineNb++;
+        lineNb = GCODE_STREAM::end();
         CloseSerialUpload (false, current_filename, lineNb);
     }
     LOG ("Exit fn\n")
@@ -0,0 +1,111 @@
+/*
+  authcache.cpp - ESP3D credentials cache class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifdef AUTHENTICATION_FEATURE
+#include "authcache.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include "mbedtls/md.h"
+#else
+#include <Hash.h>
+#endif
+
+uint8_t AUTH_CACHE::_salt[AUTH_SALT_SIZE];
+uint8_t AUTH_CACHE::_admin[AUTH_HASH_SIZE];
+uint8_t AUTH_CACHE::_user[AUTH_HASH_SIZE];
+bool AUTH_CACHE::_loaded = false;
+
+//sha1 of salt + password
+bool AUTH_CACHE::hash (const char * pwd, size_t len, uint8_t * out)
+{
+    uint8_t buf[AUTH_SALT_SIZE + MAX_LOCAL_PASSWORD_LENGTH];
+    if (len > MAX_LOCAL_PASSWORD_LENGTH) {
+        return false;
+    }
+    memcpy (buf, _salt, AUTH_SALT_SIZE);
+    memcpy (&buf[AUTH_SALT_SIZE], pwd, len);
+#if defined(ARDUINO_ARCH_ESP32)
+    mbedtls_md (mbedtls_md_info_from_type (MBEDTLS_MD_SHA1), buf, AUTH_SALT_SIZE + len, out);
+#else
+    sha1 (buf, AUTH_SALT_SIZE + len, out);
+#endif
+    memset (buf, 0, sizeof (buf));
+    return true;
+}
+
+void AUTH_CACHE::load()
+{
+    String spwd;
+    //new salt each time passwords are loaded
+    for (uint8_t i = 0; i < AUTH_SALT_SIZE; i += 4) {
+#if defined(ARDUINO_ARCH_ESP32)
+        uint32_t r = esp_random();
+#else
+        uint32_t r = RANDOM_REG32;
+#endif
+        memcpy (&_salt[i], &r, 4);
+    }
+    if (!CONFIG::read_string (EP_ADMIN_PWD, spwd, MAX_LOCAL_PASSWORD_LENGTH) ) {
+        LOG ("ERROR getting admin\r\n")
+        spwd = FPSTR (DEFAULT_ADMIN_PWD);
+    }
+    hash (spwd.c_str(), spwd.length(), _admin);
+    if (!CONFIG::read_string (EP_USER_PWD, spwd, MAX_LOCAL_PASSWORD_LENGTH) ) {
+        LOG ("ERROR getting user\r\n")
+        spwd = FPSTR (DEFAULT_USER_PWD);
+    }
+    hash (spwd.c_str(), spwd.length(), _user);
+    _loaded = true;
+}
+
+//time does not depend on how many bytes match
+bool AUTH_CACHE::check (const uint8_t * ref, const char * pwd, size_t len)
+{
+    uint8_t h[AUTH_HASH_SIZE];
+    if (!_loaded) {
+        load();
+    }
+    if (!hash (pwd, len, h)) {
+        return false;
+    }
+    uint8_t diff = 0;
+    for (uint8_t i = 0; i < AUTH_HASH_SIZE; i++) {
+        diff |= h[i] ^ ref[i];
+    }
+    return diff == 0;
+}
+
+bool AUTH_CACHE::is_admin (const char * pwd, size_t len)
+{
+    return check (_admin, pwd, len);
+}
+
+//user password only, caller checks admin password if needed
+bool AUTH_CACHE::is_user (const char * pwd, size_t len)
+{
+    return check (_user, pwd, len);
+}
+
+void AUTH_CACHE::invalidate()
+{
+    _loaded = false;
+}
+
+#endif
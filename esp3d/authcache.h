@@ -0,0 +1,47 @@
+/*
+  authcache.h - ESP3D credentials cache class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef AUTHCACHE_H
+#define AUTHCACHE_H
+#include <Arduino.h>
+#include "config.h"
+
+#define AUTH_SALT_SIZE 8
+#define AUTH_HASH_SIZE 20
+
+//passwords are read once from EEPROM and only salted hashes are kept in RAM
+//cache is cleared when a password is written
+class AUTH_CACHE
+{
+public:
+    static bool is_admin (const char * pwd, size_t len);
+    static bool is_user (const char * pwd, size_t len);
+    static void invalidate();
+private:
+    static uint8_t _salt[AUTH_SALT_SIZE];
+    static uint8_t _admin[AUTH_HASH_SIZE];
+    static uint8_t _user[AUTH_HASH_SIZE];
+    static bool _loaded;
+    static void load();
+    static bool hash (const char * pwd, size_t len, uint8_t * out);
+    static bool check (const uint8_t * ref, const char * pwd, size_t len);
+};
+
+#endif
@@ -0,0 +1,191 @@
+/*
+  autoreport.cpp - ESP3D printer auto report subscriptions class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#if !defined (USE_AS_UPDATER_ONLY) && !defined (ASYNCWEBSERVER)
+#include "autoreport.h"
+#include "espcom.h"
+#include "webinterface.h"
+#include "syncwebserver.h"
+#include "cmdqueue.h"
+#include "gcode_stream.h"
+#include "marlin_binary.h"
+#include "telemetry.h"
+#include "grblcom.h"
+
+uint32_t AUTOREPORT::_interval[MAX_WS_CLIENTS];
+uint32_t AUTOREPORT::_next[MAX_WS_CLIENTS];
+uint8_t AUTOREPORT::_caps = 0;
+bool AUTOREPORT::_caps_known = false;
+uint32_t AUTOREPORT::_probe_time = 0;
+uint32_t AUTOREPORT::_applied = 0;
+uint32_t AUTOREPORT::_last_poll = 0;
+
+void AUTOREPORT::subscribe (uint8_t id, uint32_t interval)
+{
+    if (id >= MAX_WS_CLIENTS) {
+        return;
+    }
+    if ((interval > 0) && (interval < AUTOREPORT_MIN_INTERVAL)) {
+        interval = AUTOREPORT_MIN_INTERVAL;
+    }
+    _interval[id] = interval;
+    //first report as soon as possible
+    _next[id] = millis();
+}
+
+uint8_t AUTOREPORT::subscribers()
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+        if (_interval[i] > 0) {
+            n++;
+        }
+    }
+    return n;
+}
+
+//fastest rate asked, 0 if nobody listens
+uint32_t AUTOREPORT::get_interval()
+{
+    uint32_t interval = 0;
+    for (uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+        if ((_interval[i] > 0) && ((interval == 0) || (_interval[i] < interval))) {
+            interval = _interval[i];
+        }
+    }
+    return interval;
+}
+
+//Cap:AUTOREPORT_TEMP:1
+void AUTOREPORT::parse (const char * line, size_t len)
+{
+    if ((len < 4) || (strncmp (line, "Cap:", 4) != 0)) {
+        return;
+    }
+    _caps_known = true;
+    bool enabled = (line[len - 1] == '1');
+    uint8_t cap = 0;
+    if (strncmp (line, "Cap:AUTOREPORT_TEMP:", 20) == 0) {
+        cap = AUTOREPORT_CAP_TEMP;
+    } else if (strncmp (line, "Cap:AUTOREPORT_POS:", 19) == 0) {
+        cap = AUTOREPORT_CAP_POS;
+    } else if (strncmp (line, "Cap:AUTOREPORT_SD_STATUS:", 25) == 0) {
+        cap = AUTOREPORT_CAP_SD;
+    }
+    if (enabled) {
+        _caps |= cap;
+    } else {
+        _caps &= ~cap;
+    }
+}
+
+//upload or binary transfer own the serial
+bool AUTOREPORT::serial_free()
+{
+    return !web_interface->blockserial && !GCODE_STREAM::is_active() && !MARLIN_BINARY::is_active();
+}
+
+//do not wait for printer credits, try again next loop
+bool AUTOREPORT::send (const char * cmd)
+{
+    return CMD_QUEUE::send (cmd, ORIGIN_ESP, 0, NULL, NULL, NULL, 0);
+}
+
+void AUTOREPORT::apply (uint32_t seconds)
+{
+    String s = " S" + String (seconds);
+    String cmd;
+    if (_caps & AUTOREPORT_CAP_TEMP) {
+        cmd = "M155" + s;
+        if (!send (cmd.c_str())) {
+            return;
+        }
+    }
+    if (_caps & AUTOREPORT_CAP_POS) {
+        cmd = "M154" + s;
+        if (!send (cmd.c_str())) {
+            return;
+        }
+    }
+    if (_caps & AUTOREPORT_CAP_SD) {
+        cmd = "M27" + s;
+        if (!send (cmd.c_str())) {
+            return;
+        }
+    }
+    //only when all were sent, else all are sent again next loop
+    _applied = seconds;
+    log_esp3d ("Auto report every %d s", seconds);
+}
+
+void AUTOREPORT::handle()
+{
+    uint32_t interval = get_interval();
+    uint32_t now = millis();
+    byte fw = CONFIG::GetFirmwareTarget();
+    if (serial_free()) {
+        if (fw == GRBL) {
+            //grbl status is a real time command, it does not use any buffer
+            if ((interval > 0) && ((now - _last_poll) >= interval)) {
+                GRBLCOM::send_realtime ('?');
+                _last_poll = now;
+            }
+        } else if ((interval > 0) && !_caps_known) {
+            //ask capabilities once
+            if (_probe_time == 0) {
+                if (send ("M115")) {
+                    _probe_time = now;
+                }
+            } else if ((now - _probe_time) > AUTOREPORT_CAP_TIMEOUT) {
+                _caps_known = true;
+            }
+        } else if (_caps_known) {
+            uint32_t seconds = (interval + 999) / 1000;
+            if (seconds != _applied) {
+                apply (seconds);
+            }
+            //no auto report for temperatures, so poll once for everybody
+            if (!(_caps & AUTOREPORT_CAP_TEMP) && (interval > 0) && ((now - _last_poll) >= interval)) {
+                if (send ("M105")) {
+                    _last_poll = now;
+                }
+            }
+        }
+    }
+    if (interval == 0) {
+        return;
+    }
+    //push values to each subscriber at its rate
+    String s;
+    for (uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+        if ((_interval[i] == 0) || ((int32_t) (now - _next[i]) < 0)) {
+            continue;
+        }
+        if (s.length() == 0) {
+            //grbl output is not parsed by telemetry, its status report is sent instead
+            s = "TELEMETRY:" + ((fw == GRBL) ? GRBLCOM::json() : TELEMETRY::json());
+        }
+        socket_server->sendTXT (i, s);
+        _next[i] = now + _interval[i];
+    }
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+  autoreport.h - ESP3D printer auto report subscriptions class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef AUTOREPORT_H
+#define AUTOREPORT_H
+#include <Arduino.h>
+#include "config.h"
+
+//fastest rate a subscriber can ask (ms)
+#define AUTOREPORT_MIN_INTERVAL 1000
+//time to wait M115 capabilities before using polling
+#define AUTOREPORT_CAP_TIMEOUT 3000
+
+//printer capabilities from M115
+#define AUTOREPORT_CAP_TEMP 1
+#define AUTOREPORT_CAP_POS 2
+#define AUTOREPORT_CAP_SD 4
+
+//websocket clients ask telemetry at their own rate (TELEMETRY:<ms>, 0 to stop)
+//printer auto reports (M155, M154, M27 S) are set once at the fastest rate asked
+//and turned off when nobody listens, so no client needs to poll the printer
+class AUTOREPORT
+{
+public:
+    static void subscribe (uint8_t id, uint32_t interval);
+    static void parse (const char * line, size_t len);
+    static void handle();
+    static uint8_t subscribers();
+    static uint32_t get_interval();
+private:
+    static uint32_t _interval[MAX_WS_CLIENTS];
+    static uint32_t _next[MAX_WS_CLIENTS];
+    static uint8_t _caps;
+    static bool _caps_known;
+    static uint32_t _probe_time;
+    static uint32_t _applied;
+    static uint32_t _last_poll;
+    static bool serial_free();
+    static bool send (const char * cmd);
+    static void apply (uint32_t seconds);
+};
+
+#endif
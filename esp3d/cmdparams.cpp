@@ -0,0 +1,145 @@
+/*
+  cmdparams.cpp - ESP3D [ESPxxx] parameters parser class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "cmdparams.h"
+
+CMD_PARAMS::CMD_PARAMS (const char * params, size_t len)
+{
+    _params = params;
+    _len = len;
+    _count = 0;
+    _overflow = false;
+    for (size_t i = 0; i < len; i++) {
+        if ((params[i] != ' ') && ((i == 0) || (params[i - 1] == ' '))) {
+            if (_count == CMD_PARAMS_MAX_TOKENS) {
+                _overflow = true;
+                break;
+            }
+            _tokens[_count++] = i;
+        }
+    }
+}
+
+//first token starting after pos and beginning by id, -1 if none
+int CMD_PARAMS::find (const char * id, size_t idlen, int pos) const
+{
+    for (uint8_t t = 0; t < _count; t++) {
+        if ((_tokens[t] > pos) && (_tokens[t] + idlen <= _len) && (strncmp (&_params[_tokens[t]], id, idlen) == 0)) {
+            return _tokens[t];
+        }
+    }
+    if (_overflow) {
+        size_t i = _tokens[_count - 1] + 1;
+        if ((int) i <= pos) {
+            i = pos + 1;
+        }
+        for (; i + idlen <= _len; i++) {
+            if ((_params[i - 1] == ' ') && (strncmp (&_params[i], id, idlen) == 0)) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+bool CMD_PARAMS::get (const char * id, bool withspace, const char *& value, size_t & len) const
+{
+    size_t idlen = strlen (id);
+    int start = (idlen == 0) ? 0 : find (id, idlen, -1);
+    value = _params + _len;
+    len = 0;
+    if (start == -1) {
+        return false;
+    }
+    size_t end = _len;
+    //if no space expected use space as delimiter
+    if (!withspace) {
+        const char * p = (const char *) memchr (&_params[start], ' ', _len - start);
+        if (p) {
+            end = p - _params;
+        }
+    }
+#ifdef AUTHENTICATION_FEATURE
+    //if space expected only one parameter but additional password may be present
+    else if (strcmp (id, " pwd=") != 0) {
+        int pos = find ("pwd=", 4, start);
+        if (pos != -1) {
+            end = pos - 1;
+        }
+    }
+#endif
+    size_t begin = start + idlen;
+    //be sure no extra space
+    while ((begin < end) && isspace ((uint8_t) _params[begin])) {
+        begin++;
+    }
+    while ((end > begin) && isspace ((uint8_t) _params[end - 1])) {
+        end--;
+    }
+    if (begin < end) {
+        value = &_params[begin];
+        len = end - begin;
+    }
+    return true;
+}
+
+String CMD_PARAMS::get_string (const char * id, bool withspace) const
+{
+    const char * value;
+    size_t len;
+    String s;
+    get (id, withspace, value, len);
+    s.reserve (len);
+    for (size_t i = 0; i < len; i++) {
+        s += value[i];
+    }
+    return s;
+}
+
+//same as String::toInt()
+long CMD_PARAMS::get_int (const char * id) const
+{
+    const char * value;
+    size_t len;
+    get (id, false, value, len);
+    char buf[16];
+    if (len >= sizeof (buf)) {
+        len = sizeof (buf) - 1;
+    }
+    memcpy (buf, value, len);
+    buf[len] = 0;
+    return atol (buf);
+}
+
+bool CMD_PARAMS::has_value (const char * id) const
+{
+    const char * value;
+    size_t len;
+    get (id, false, value, len);
+    return len > 0;
+}
+
+bool CMD_PARAMS::equals (const char * id, const char * expected, bool withspace) const
+{
+    const char * value;
+    size_t len;
+    get (id, withspace, value, len);
+    return (strlen (expected) == len) && (strncmp (value, expected, len) == 0);
+}
@@ -0,0 +1,51 @@
+/*
+  cmdparams.h - ESP3D [ESPxxx] parameters parser class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef CMDPARAMS_H
+#define CMDPARAMS_H
+#include <Arduino.h>
+#include "config.h"
+
+//tokens positions kept, more tokens are found by scanning
+#define CMD_PARAMS_MAX_TOKENS 16
+
+//split [ESPxxx] parameters in space separated tokens in one pass
+//key is matched at token start, value ends at next space, or at pwd= / end of line if spaces are allowed
+//values point inside parameters string, which must stay unchanged while parser is used
+class CMD_PARAMS
+{
+public:
+    CMD_PARAMS (const char * params, size_t len);
+    //empty id is first part of parameters
+    bool get (const char * id, bool withspace, const char *& value, size_t & len) const;
+    String get_string (const char * id, bool withspace = false) const;
+    long get_int (const char * id) const;
+    bool has_value (const char * id) const;
+    bool equals (const char * id, const char * expected, bool withspace = false) const;
+private:
+    const char * _params;
+    size_t _len;
+    uint16_t _tokens[CMD_PARAMS_MAX_TOKENS];
+    uint8_t _count;
+    bool _overflow;
+    int find (const char * id, size_t idlen, int pos) const;
+};
+
+#endif
@@ -0,0 +1,258 @@
+/*
+  cmdqueue.cpp - ESP3D printer command queue class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "cmdqueue.h"
+#include "gcode_stream.h"
+
+cmd_entry_t CMD_QUEUE::_queue[CMD_QUEUE_SIZE];
+uint8_t CMD_QUEUE::_head = 0;
+uint8_t CMD_QUEUE::_count = 0;
+uint16_t CMD_QUEUE::_last_ticket = 0;
+uint32_t CMD_QUEUE::_last_answer = 0;
+cmd_origin_t CMD_QUEUE::_origin = ORIGIN_ESP;
+uint8_t CMD_QUEUE::_client = 0;
+uint16_t CMD_QUEUE::_ticket = 0;
+cmd_answer_cb CMD_QUEUE::_cb = NULL;
+void * CMD_QUEUE::_ctx = NULL;
+bool CMD_QUEUE::_raw_line[MAX_SRV_CLIENTS];
+bool CMD_QUEUE::_raw_comment[MAX_SRV_CLIENTS];
+
+bool CMD_QUEUE::send (const char * cmd, cmd_origin_t origin, uint8_t client, cmd_answer_cb cb, void * ctx, uint16_t * ticket, uint32_t timeout)
+{
+    //0 means no ticket
+    _last_ticket++;
+    if (_last_ticket == 0) {
+        _last_ticket++;
+    }
+    //lines sent now belong to this origin
+    _origin = origin;
+    _client = client;
+    _ticket = _last_ticket;
+    _cb = cb;
+    _ctx = ctx;
+    bool res = GCODE_STREAM::send_line (cmd, timeout);
+    _origin = ORIGIN_ESP;
+    _client = 0;
+    _ticket = 0;
+    _cb = NULL;
+    _ctx = NULL;
+    if (ticket) {
+        //no ticket if nothing is waiting for ack
+        *ticket = is_pending (_last_ticket) ? _last_ticket : 0;
+    }
+    return res;
+}
+
+void CMD_QUEUE::add_line()
+{
+    add (_origin, _client, _ticket, _cb, _ctx, true);
+}
+
+void CMD_QUEUE::add_urgent()
+{
+    add (ORIGIN_ESP, 0, 0, NULL, NULL, true);
+}
+
+bool CMD_QUEUE::can_add_line()
+{
+    return has_room (_origin, _client, _ticket, true);
+}
+
+bool CMD_QUEUE::can_add_raw (cmd_origin_t origin, uint8_t client)
+{
+    return has_room (origin, client, 0, false);
+}
+
+//line goes in tail entry if it is same command, else it needs a free entry
+//last free entry is kept for urgent lines, which cannot wait
+bool CMD_QUEUE::has_room (uint8_t origin, uint8_t client, uint16_t ticket, bool credit)
+{
+    if (_count < (CMD_QUEUE_SIZE - 1)) {
+        return true;
+    }
+    cmd_entry_t * tail = &_queue[(_head + _count - 1) & (CMD_QUEUE_SIZE - 1)];
+    return (tail->origin == origin) && (tail->client == client) && (tail->ticket == ticket) && (tail->credit == credit);
+}
+
+//a line is counted if there is something before end of line and comment, as printer ignores others
+void CMD_QUEUE::add_raw (cmd_origin_t origin, uint8_t client, const uint8_t * data, size_t len)
+{
+    if (client >= MAX_SRV_CLIENTS) {
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if ((c == '\n') || (c == '\r')) {
+            if (_raw_line[client]) {
+                //tcp host does its own flow control, no credit is used
+                add (origin, client, 0, NULL, NULL, false);
+            }
+            _raw_line[client] = false;
+            _raw_comment[client] = false;
+        } else if (c == ';') {
+            _raw_comment[client] = true;
+        } else if (!_raw_comment[client] && (c > ' ')) {
+            _raw_line[client] = true;
+        }
+    }
+}
+
+//consecutive lines of same origin and ticket share one entry
+//senders check has_room before sending, so queue is never full here
+void CMD_QUEUE::add (uint8_t origin, uint8_t client, uint16_t ticket, cmd_answer_cb cb, void * ctx, bool credit)
+{
+    if (_count == 0) {
+        _last_answer = millis();
+    }
+    if (_count > 0) {
+        cmd_entry_t * tail = &_queue[(_head + _count - 1) & (CMD_QUEUE_SIZE - 1)];
+        if ((tail->origin == origin) && (tail->client == client) && (tail->ticket == ticket) && (tail->credit == credit)) {
+            tail->pending++;
+            return;
+        }
+    }
+    if (_count == CMD_QUEUE_SIZE) {
+        //should not happen, oldest ack is considered lost like on timeout
+        log_esp3d ("Command queue full");
+        pop();
+    }
+    cmd_entry_t * entry = &_queue[(_head + _count) & (CMD_QUEUE_SIZE - 1)];
+    entry->origin = origin;
+    entry->client = client;
+    entry->ticket = ticket;
+    entry->pending = 1;
+    entry->credit = credit;
+    entry->cb = cb;
+    entry->ctx = ctx;
+    _count++;
+}
+
+void CMD_QUEUE::pop()
+{
+    if (_count > 0) {
+        _head = (_head + 1) & (CMD_QUEUE_SIZE - 1);
+        _count--;
+    }
+}
+
+bool CMD_QUEUE::is_ack (const char * line, size_t len)
+{
+    if ((len >= 2) && (line[0] == 'o') && (line[1] == 'k')) {
+        return true;
+    }
+    //grbl answers error instead of ok
+    if ((CONFIG::GetFirmwareTarget() == GRBL) && (len >= 5) && (strncmp (line, "error", 5) == 0)) {
+        return true;
+    }
+    return false;
+}
+
+//line is a complete printer answer line, without end of line
+bool CMD_QUEUE::on_answer (const char * line, size_t len)
+{
+    _last_answer = millis();
+    if (_count == 0) {
+        return false;
+    }
+    byte fw = CONFIG::GetFirmwareTarget();
+    //repetier has nothing left to process
+    if (((fw == REPETIER) || (fw == REPETIER4DV)) && (len == 4) && (strncmp (line, "wait", 4) == 0)) {
+        clear();
+        return false;
+    }
+    //grbl status report is not a command answer
+    if ((fw == GRBL) && (len > 0) && (line[0] == '<')) {
+        return false;
+    }
+    cmd_entry_t * entry = &_queue[_head];
+    if (entry->cb) {
+        entry->cb (entry->ctx, line, len);
+    }
+    if (!is_ack (line, len)) {
+        return false;
+    }
+    bool credit = entry->credit;
+    entry->pending--;
+    if (entry->pending == 0) {
+        pop();
+    }
+    return credit;
+}
+
+bool CMD_QUEUE::is_pending (uint16_t ticket)
+{
+    if (ticket == 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_queue[(_head + i) & (CMD_QUEUE_SIZE - 1)].ticket == ticket) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CMD_QUEUE::release (uint16_t ticket)
+{
+    if (ticket == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        cmd_entry_t * entry = &_queue[(_head + i) & (CMD_QUEUE_SIZE - 1)];
+        if (entry->ticket == ticket) {
+            entry->cb = NULL;
+            entry->ctx = NULL;
+        }
+    }
+}
+
+void CMD_QUEUE::release_ctx (void * ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        cmd_entry_t * entry = &_queue[(_head + i) & (CMD_QUEUE_SIZE - 1)];
+        if (entry->ctx == ctx) {
+            entry->cb = NULL;
+            entry->ctx = NULL;
+        }
+    }
+}
+
+void CMD_QUEUE::clear()
+{
+    _head = 0;
+    _count = 0;
+}
+
+//printer is silent for too long, oldest command ack is considered lost
+void CMD_QUEUE::poll()
+{
+    if ((_count > 0) && ((millis() - _last_answer) > CMD_QUEUE_TIMEOUT)) {
+        log_esp3d ("Command ack lost");
+        pop();
+        _last_answer = millis();
+    }
+}
+
+#endif //USE_AS_UPDATER_ONLY
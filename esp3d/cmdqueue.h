@@ -0,0 +1,102 @@
+/*
+  cmdqueue.h - ESP3D printer command queue class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef CMDQUEUE_H
+#define CMDQUEUE_H
+#include <Arduino.h>
+#include "config.h"
+
+//number of commands groups waiting for printer ack, must be a power of 2
+//a full credit window (MAX_STREAM_WINDOW) mixed with tcp clients lines fits in it
+#define CMD_QUEUE_SIZE 16
+//time without any answer from printer before dropping oldest command
+#define CMD_QUEUE_TIMEOUT 10000
+
+typedef enum {
+    ORIGIN_ESP = 0,
+    ORIGIN_WEB = 1,
+    ORIGIN_TCP = 2,
+    ORIGIN_WS = 3,
+    ORIGIN_MACRO = 4
+} cmd_origin_t;
+
+//called for each printer answer line of a command, ack line included
+typedef void (*cmd_answer_cb) (void * ctx, const char * line, size_t len);
+
+typedef struct {
+    uint8_t origin;
+    uint8_t client;
+    uint16_t ticket;
+    uint16_t pending;
+    //lines were sent by ESP3D and hold a printer credit
+    bool credit;
+    cmd_answer_cb cb;
+    void * ctx;
+} cmd_entry_t;
+
+//printer acks commands in order, so each ack belongs to the oldest command sent
+//lines received before an ack are answers of this command
+class CMD_QUEUE
+{
+public:
+    //send command lines to printer tagged with their origin, ticket allows to follow answers
+    static bool send (const char * cmd, cmd_origin_t origin, uint8_t client = 0, cmd_answer_cb cb = NULL, void * ctx = NULL, uint16_t * ticket = NULL, uint32_t timeout = 2000);
+    //a line was sent to printer (by GCODE_STREAM)
+    static void add_line();
+    //raw data sent to printer (tcp), count lines inside
+    static void add_raw (cmd_origin_t origin, uint8_t client, const uint8_t * data, size_t len);
+    //emergency line sent to printer, it can use the entry kept free
+    static void add_urgent();
+    //a line can be tracked without mixing it with another command, else it must wait
+    static bool can_add_line();
+    static bool can_add_raw (cmd_origin_t origin, uint8_t client);
+    //return true if line is the ack of a line which holds a printer credit
+    static bool on_answer (const char * line, size_t len);
+    static bool is_pending (uint16_t ticket);
+    //answers of this ticket are no more wanted
+    static void release (uint16_t ticket);
+    //answers given to this context are no more wanted, whatever the ticket
+    static void release_ctx (void * ctx);
+    static void clear();
+    static void poll();
+    static uint8_t count()
+    {
+        return _count;
+    };
+private:
+    static cmd_entry_t _queue[CMD_QUEUE_SIZE];
+    static uint8_t _head;
+    static uint8_t _count;
+    static uint16_t _last_ticket;
+    static uint32_t _last_answer;
+    static cmd_origin_t _origin;
+    static uint8_t _client;
+    static uint16_t _ticket;
+    static cmd_answer_cb _cb;
+    static void * _ctx;
+    static bool _raw_line[MAX_SRV_CLIENTS];
+    static bool _raw_comment[MAX_SRV_CLIENTS];
+    static void add (uint8_t origin, uint8_t client, uint16_t ticket, cmd_answer_cb cb, void * ctx, bool credit);
+    static bool has_room (uint8_t origin, uint8_t client, uint16_t ticket, bool credit);
+    static void pop();
+    static bool is_ack (const char * line, size_t len);
+};
+
+#endif
@@ -22,23 +22,24 @@
 #define COMMAND_h
 #include <Arduino.h>
 #include "espcom.h"
+#include "cmdparams.h"
 
 
 class COMMAND
 {
 public:
-    static String buffer_serial;
-    static String buffer_tcp;
     static void read_buffer_serial (uint8_t *b, size_t len);
     static void read_buffer_serial (uint8_t b);
 #ifdef TCP_IP_DATA_FEATURE
     static void read_buffer_tcp (uint8_t b);
+    static void read_buffer_tcp (const uint8_t *b, size_t len);
 #endif
     static bool check_command (String buffer, tpipe output, bool handlelockserial = true, bool executecmd = true);
+    static bool check_command (const char * line, size_t len, tpipe output, bool handlelockserial = true, bool executecmd = true);
     static bool execute_command (int cmd, String cmd_params, tpipe output, level_authenticate_type auth_level = LEVEL_GUEST, ESPResponseStream  *espresponse = NULL);
     static String get_param (String & cmd_params, const char * id, bool withspace = false);
-    static bool isadmin (String & cmd_params);
-    static bool isuser (String & cmd_params);
+    static bool isadmin (const CMD_PARAMS & params);
+    static bool isuser (const CMD_PARAMS & params);
 };
 
 #endif
@@ -0,0 +1,259 @@
+/*
+  command_device.cpp - ESP3D pins and screen commands
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "config.h"
+#include "command.h"
+#include "command_handlers.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#define MAX_GPIO 37
+int ChannelAttached2Pin[16]= {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1};
+#else
+#define MAX_GPIO 16
+#endif
+#ifdef ESP_OLED_FEATURE
+#include "esp_oled.h"
+#endif
+
+#ifndef USE_AS_UPDATER_ONLY
+#ifdef DIRECT_PIN_FEATURE
+//Get/Set pin value
+//[ESP201]P<pin> V<value> [PULLUP=YES RAW=YES ANALOG=NO ANALOG_RANGE=255 CLEARCHANNELS=NO]pwd=<admin password>
+bool esp_cmd_201 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    //check if have pin
+    if (!params.has_value ("P")) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    } else {
+        int pin = params.get_int ("P");
+        LOG ("Pin:")
+        LOG (String (pin).c_str() )
+        LOG ("\r\n")
+        //check pin is valid
+        if ((pin >= 0) && (pin <= MAX_GPIO)) {
+            //check if analog or digital
+            bool isdigital = true;
+
+            if (params.equals ("ANALOG=", "YES")) {
+                LOG ("Set as analog\r\n")
+                isdigital=false;
+#ifdef ARDUINO_ARCH_ESP32
+                if (params.equals ("CLEARCHANNELS=", "YES")) {
+                    for (uint8_t p = 0; p < 16; p++) {
+                        if(ChannelAttached2Pin[p] != -1) {
+                            ledcDetachPin(ChannelAttached2Pin[p]);
+                            ChannelAttached2Pin[p] = -1;
+                        }
+                    }
+                }
+#endif
+            }
+            //check if is set or get
+            //it is a get
+            if (!params.has_value ("V")) {
+                int value = 0;
+                if(isdigital) {
+                    //this is to not set pin mode
+                    if (params.equals ("RAW=", "NO")) {
+                        if (params.equals ("PULLUP=", "NO")) {
+                            LOG ("Set as input\r\n")
+                            pinMode (pin, INPUT);
+                        } else {
+                            //GPIO16 is different than others
+                            if (pin < MAX_GPIO) {
+                                LOG ("Set as input pull up\r\n")
+                                pinMode (pin, INPUT_PULLUP);
+                            }
+#ifdef ARDUINO_ARCH_ESP8266
+                            else {
+                                LOG ("Set as input pull down 16\r\n")
+                                pinMode (pin, INPUT_PULLDOWN_16);
+                            }
+#endif
+                        }
+                    }
+                    value = digitalRead (pin);
+                } else {
+#ifdef ARDUINO_ARCH_ESP8266 //only one ADC on ESP8266 A0
+                    value = analogRead (A0);
+#else
+                    value = analogRead (pin);
+#endif
+                }
+                LOG ("Read:");
+                LOG (String (value).c_str() )
+                LOG ("\n");
+                ESPCOM::println (String (value).c_str(), output, espresponse);
+            } else {
+                //it is a set
+                int value = params.get_int ("V");
+                if (isdigital) {
+                    //verify it is a 0 or a 1
+                    if ( (value == 0) || (value == 1) ) {
+                        pinMode (pin, OUTPUT);
+                        LOG ("Set:")
+                        LOG (String ( (value == 0) ? LOW : HIGH) )
+                        LOG ("\r\n")
+                        digitalWrite (pin, (value == 0) ? LOW : HIGH);
+                        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+                    } else {
+                        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+                        response = false;
+                    }
+                } else {
+                    int analog_range= 255;
+                    if (params.has_value ("ANALOG_RANGE=")) {
+                        analog_range = params.get_int ("ANALOG_RANGE=");
+                    }
+                    LOG ("Range ")
+                    LOG(String (analog_range).c_str() )
+                    LOG ("\r\n")
+                    if ( (value >= 0) || (value <= analog_range+1) ) {
+                        LOG ("Set:")
+                        LOG (String ( value) )
+                        LOG ("\r\n")
+#ifdef ARDUINO_ARCH_ESP8266
+
+                        analogWriteRange(analog_range);
+                        pinMode(pin, OUTPUT);
+                        analogWrite(pin, value);
+#else
+                        int channel  = -1;
+                        for (uint8_t p = 0; p < 16; p++) {
+                            if(ChannelAttached2Pin[p] == pin) {
+                                channel = p;
+                            }
+                        }
+                        if (channel==-1) {
+                            for (uint8_t p = 0; p < 16; p++) {
+                                if(ChannelAttached2Pin[p] == -1) {
+                                    channel = p;
+                                    ChannelAttached2Pin[p] = pin;
+                                    p  = 16;
+                                }
+                            }
+                        }
+                        uint8_t resolution = 0;
+                        analog_range++;
+                        switch(analog_range) {
+                        case 8191:
+                            resolution=13;
+                            break;
+                        case 1024:
+                            resolution=10;
+                            break;
+                        case 2047:
+                            resolution=11;
+                            break;
+                        case 4095:
+                            resolution=12;
+                            break;
+                        default:
+                            resolution=8;
+                            analog_range = 255;
+                            break;
+                        }
+                        if ((channel==-1) || (value > (analog_range-1))) {
+                            ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+                            return false;
+                        }
+                        ledcSetup(channel, 1000, resolution);
+                        ledcAttachPin(pin, channel);
+                        ledcWrite(channel, value);
+#endif
+                    } else {
+                        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+                        response = false;
+                    }
+                }
+            }
+        } else {
+            ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+            response = false;
+        }
+    }
+    return response;
+}
+#endif
+#ifdef ESP_OLED_FEATURE
+//Output to oled
+//[ESP210]<Text>
+bool esp_cmd_210 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    int c = params.get_int ("C=");
+    int l = params.get_int ("L=");
+    parameter = params.get_string ("T=", true);
+    OLED_DISPLAY::setCursor(c, l);
+    ESPCOM::print(parameter.c_str(), OLED_PIPE);
+    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    return true;
+}
+
+//Output to oled line 1
+//[ESP211]<Text>
+bool esp_cmd_211 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    OLED_DISPLAY::setCursor(0, 0);
+    ESPCOM::print(parameter.c_str(), OLED_PIPE);
+    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    return true;
+}
+
+//Output to oled line 2
+//[ESP212]<Text>
+bool esp_cmd_212 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    OLED_DISPLAY::setCursor(0, 16);
+    ESPCOM::print(parameter.c_str(), OLED_PIPE);
+    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    return true;
+}
+
+//Output to oled line 3
+//[ESP213]<Text>
+bool esp_cmd_213 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    OLED_DISPLAY::setCursor(0, 32);
+    ESPCOM::print(parameter.c_str(), OLED_PIPE);
+    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    return true;
+}
+
+//Output to oled line 4
+//[ESP214]<Text>
+bool esp_cmd_214 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    OLED_DISPLAY::setCursor(0, 48);
+    ESPCOM::print(parameter.c_str(), OLED_PIPE);
+    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    return true;
+}
+#endif
+//Command delay
+bool esp_cmd_290 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    if (parameter.length() != 0) {
+        ESPCOM::println ("Pause", output, espresponse);
+        CONFIG::wait(parameter.toInt());
+    }
+    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    return true;
+}
+#endif
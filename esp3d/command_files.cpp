@@ -0,0 +1,147 @@
+/*
+  command_files.cpp - ESP3D local files commands
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "config.h"
+#include "command.h"
+#include "command_handlers.h"
+#include "webinterface.h"
+#ifndef FS_NO_GLOBALS
+#define FS_NO_GLOBALS
+#endif
+#include <FS.h>
+#if defined(ARDUINO_ARCH_ESP32)
+#include "SPIFFS.h"
+#endif
+#ifndef USE_AS_UPDATER_ONLY
+#include "gcode_stream.h"
+#include "cmdqueue.h"
+#endif
+#ifdef CONFIG_JOURNAL_FEATURE
+#include "configjournal.h"
+#endif
+#include "fsindex.h"
+
+#ifndef USE_AS_UPDATER_ONLY
+//[ESP700]<filename>
+//read local file
+bool esp_cmd_700 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    //be sure serial is locked
+    if ( (web_interface->blockserial) ) {
+        return response;
+    }
+    cmd_params.trim() ;
+    if ( (cmd_params.length() > 0) && (cmd_params[0] != '/') ) {
+        cmd_params = "/" + cmd_params;
+    }
+    FS_FILE currentfile = SPIFFS.open (cmd_params, SPIFFS_FILE_READ);
+    if (currentfile) {//if file open success
+        //flush to be sure send buffer is empty
+        ESPCOM::flush (DEFAULT_PRINTER_PIPE);
+        //until no line in file
+        while (currentfile.available()) {
+            String currentline = currentfile.readStringUntil('\n');
+            currentline.replace("\n","");
+            currentline.replace("\r","");
+            if (currentline.length() > 0) {
+                int ESPpos = currentline.indexOf ("[ESP");
+                if (ESPpos > -1) {
+                    //is there the second part?
+                    int ESPpos2 = currentline.indexOf ("]", ESPpos);
+                    if (ESPpos2 > -1) {
+                        //Split in command and parameters
+                        String cmd_part1 = currentline.substring (ESPpos + 4, ESPpos2);
+                        String cmd_part2 = "";
+                        //is there space for parameters?
+                        if (ESPpos2 < currentline.length() ) {
+                            cmd_part2 = currentline.substring (ESPpos2 + 1);
+                        }
+                        //if command is a valid number then execute command
+                        if(cmd_part1.toInt()!=0) {
+                            COMMAND::execute_command (cmd_part1.toInt(),cmd_part2,NO_PIPE, auth_type, espresponse);
+                        }
+                        //if not is not a valid [ESPXXX] command ignore it
+                    }
+                } else {
+                    //send line to serial when printer has free slot
+                    if (!CMD_QUEUE::send (currentline.c_str(), ORIGIN_MACRO, 0, NULL, NULL, NULL, CREDIT_TIMEOUT)) {
+                        response = false;
+                        break;
+                    }
+                }
+                CONFIG::wait (1);
+            }
+        }
+        currentfile.close();
+        if (response) {
+            ESPCOM::println (OK_CMD_MSG, output, espresponse);
+        } else {
+            ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        }
+    } else {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    return response;
+}
+
+//Format SPIFFS
+//[ESP710]FORMAT pwd=<admin password>
+bool esp_cmd_710 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (parameter == "FORMAT") {
+        ESPCOM::print (F ("Formating"), output, espresponse);
+        SPIFFS.format();
+#ifdef CONFIG_JOURNAL_FEATURE
+        //journal is gone, save current settings again
+        CONFIG_JOURNAL::compact();
+#endif
+        //files list is empty now (or only journal)
+        FS_INDEX::begin();
+        ESPCOM::println (F ("...Done"), output, espresponse);
+    } else {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    return response;
+}
+
+//SPIFFS total size and used size
+//[ESP720]<header answer>
+bool esp_cmd_720 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    ESPCOM::print (cmd_params, output, espresponse);
+#ifdef ARDUINO_ARCH_ESP8266
+    fs::FSInfo info;
+    SPIFFS.info (info);
+    ESPCOM::print ("SPIFFS Total:", output, espresponse);
+    ESPCOM::print (CONFIG::formatBytes (info.totalBytes).c_str(), output, espresponse);
+    ESPCOM::print (" Used:", output, espresponse);
+    ESPCOM::println (CONFIG::formatBytes (info.usedBytes).c_str(), output, espresponse);
+#else
+    ESPCOM::print ("SPIFFS  Total:", output, espresponse);
+    ESPCOM::print (CONFIG::formatBytes (SPIFFS.totalBytes() ).c_str(), output, espresponse);
+    ESPCOM::print (" Used:", output, espresponse);
+    ESPCOM::println (CONFIG::formatBytes (SPIFFS.usedBytes() ).c_str(), output, espresponse);
+#endif
+    return true;
+}
+#endif
@@ -0,0 +1,108 @@
+/*
+  command_handlers.h - ESP3D [ESPxxx] commands handlers
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef COMMAND_HANDLERS_h
+#define COMMAND_HANDLERS_h
+#include <Arduino.h>
+#include "config.h"
+#include "espcom.h"
+#include "cmdparams.h"
+
+#define ERROR_CMD_MSG (output == WEB_PIPE)?F("Error: Wrong Command"):F("Cmd Error")
+#define INCORRECT_CMD_MSG (output == WEB_PIPE)?F("Error: Incorrect Command"):F("Incorrect Cmd")
+#define OK_CMD_MSG (output == WEB_PIPE)?F("ok"):F("Cmd Ok")
+
+//first parameter (spaces allowed) is extracted before calling handler
+#define CMD_PARAM 1
+//handler checks authentication level by itself
+#define CMD_AUTH 2
+
+typedef bool (*esp_cmd_handler_t) (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+
+//command descriptor, level is the minimum level needed to run the command
+typedef struct {
+    uint16_t id;
+    uint8_t level;
+    uint8_t flags;
+    esp_cmd_handler_t handler;
+} esp_cmd_t;
+
+bool esp_cmd_100 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_101 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_102 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_103 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_104 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#ifndef USE_AS_UPDATER_ONLY
+bool esp_cmd_105 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_106 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_107 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_110 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_111 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_112 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#if defined(TIMESTAMP_FEATURE)
+bool esp_cmd_114 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_115 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+#ifdef DIRECT_PIN_FEATURE
+bool esp_cmd_201 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+#ifdef ESP_OLED_FEATURE
+bool esp_cmd_210 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_211 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_212 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_213 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_214 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+bool esp_cmd_290 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_300 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_400 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_401 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_402 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_410 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+bool esp_cmd_420 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#ifndef USE_AS_UPDATER_ONLY
+bool esp_cmd_430 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+bool esp_cmd_444 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#ifndef USE_AS_UPDATER_ONLY
+bool esp_cmd_500 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_501 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_502 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_503 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#ifdef AUTHENTICATION_FEATURE
+bool esp_cmd_555 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+#ifdef NOTIFICATION_FEATURE
+bool esp_cmd_600 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_610 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+bool esp_cmd_700 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_710 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_720 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+bool esp_cmd_800 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#ifndef USE_AS_UPDATER_ONLY
+bool esp_cmd_801 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_810 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+bool esp_cmd_900 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse);
+#endif
+
+#endif
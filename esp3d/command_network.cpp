@@ -0,0 +1,406 @@
+/*
+  command_network.cpp - ESP3D network commands
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "config.h"
+#include "command.h"
+#include "command_handlers.h"
+#include "wificonf.h"
+#include "webinterface.h"
+#include "jsonwriter.h"
+#ifdef TIMESTAMP_FEATURE
+#include <time.h>
+#endif
+#ifdef ESP_OLED_FEATURE
+#include "esp_oled.h"
+#endif
+
+//STA SSID
+//[ESP100]<SSID>[pwd=<admin password>]
+bool esp_cmd_100 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (!CONFIG::isSSIDValid (parameter.c_str() ) ) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+    }
+    if (!CONFIG::write_string (EP_STA_SSID, parameter.c_str() ) ) {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    } else {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    }
+    return response;
+}
+
+//STA Password
+//[ESP101]<Password>[pwd=<admin password>]
+bool esp_cmd_101 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (!CONFIG::isPasswordValid (parameter.c_str() ) ) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if (!CONFIG::write_string (EP_STA_PASSWORD, parameter.c_str() ) ) {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    } else {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    }
+    return response;
+}
+
+//Hostname
+//[ESP102]<hostname>[pwd=<admin password>]
+bool esp_cmd_102 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (!CONFIG::isHostnameValid (parameter.c_str() ) ) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if (!CONFIG::write_string (EP_HOSTNAME, parameter.c_str() ) ) {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    } else {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    }
+    return response;
+}
+
+//Wifi mode (STA/AP)
+//[ESP103]<mode>[pwd=<admin password>]
+bool esp_cmd_103 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    byte mode = 254;
+    if (parameter == "STA") {
+        mode = CLIENT_MODE;
+    } else if (parameter == "AP") {
+        mode = AP_MODE;
+    } else {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if ( (mode == CLIENT_MODE) || (mode == AP_MODE) ) {
+        if (!CONFIG::write_byte (EP_WIFI_MODE, mode) ) {
+            ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+            response = false;
+        } else {
+            ESPCOM::println (OK_CMD_MSG, output, espresponse);
+        }
+    }
+    return response;
+}
+
+//STA IP mode (DHCP/STATIC)
+//[ESP104]<mode>[pwd=<admin password>]
+bool esp_cmd_104 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    byte mode = 254;
+    if (parameter == "STATIC") {
+        mode = STATIC_IP_MODE;
+    } else if (parameter == "DHCP") {
+        mode = DHCP_MODE;
+    } else {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if ( (mode == STATIC_IP_MODE) || (mode == DHCP_MODE) ) {
+        if (!CONFIG::write_byte (EP_STA_IP_MODE, mode) ) {
+            ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+            response = false;
+        } else {
+            ESPCOM::println (OK_CMD_MSG, output, espresponse);
+        }
+    }
+    return response;
+}
+
+#ifndef USE_AS_UPDATER_ONLY
+//AP SSID
+//[ESP105]<SSID>[pwd=<admin password>]
+bool esp_cmd_105 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (!CONFIG::isSSIDValid (parameter.c_str() ) ) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if (!CONFIG::write_string (EP_AP_SSID, parameter.c_str() ) ) {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    } else {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    }
+    return response;
+}
+
+//AP Password
+//[ESP106]<Password>[pwd=<admin password>]
+bool esp_cmd_106 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (!CONFIG::isPasswordValid (parameter.c_str() ) ) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if (!CONFIG::write_string (EP_AP_PASSWORD, parameter.c_str() ) ) {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    } else {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    }
+    return response;
+}
+
+//AP IP mode (DHCP/STATIC)
+//[ESP107]<mode>[pwd=<admin password>]
+bool esp_cmd_107 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    byte mode = 254;
+    if (parameter == "STATIC") {
+        mode = STATIC_IP_MODE;
+    } else if (parameter == "DHCP") {
+        mode = DHCP_MODE;
+    } else {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if ( (mode == STATIC_IP_MODE) || (mode == DHCP_MODE) ) {
+        if (!CONFIG::write_byte (EP_AP_IP_MODE, mode) ) {
+            ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+            response = false;
+        } else {
+            ESPCOM::println (OK_CMD_MSG, output, espresponse);
+        }
+    }
+    return response;
+}
+
+// Set wifi on/off
+//[ESP110]<state>[pwd=<admin password>]
+bool esp_cmd_110 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    byte mode = 254;
+    if (parameter == "ON") {
+        mode = 1;
+    } else if (parameter == "OFF") {
+        mode = 0;
+    } else if (parameter == "RESTART") {
+        mode = 2;
+    } else {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    if (response) {
+        if (mode == 0) {
+            if ((WiFi.getMode() != WIFI_OFF)  || wifi_config.WiFi_on) {
+                //disable wifi
+                ESPCOM::println ("Disabling Wifi", output, espresponse);
+#ifdef ESP_OLED_FEATURE
+                OLED_DISPLAY::display_signal(-1);
+                OLED_DISPLAY::setCursor(0, 0);
+                ESPCOM::print("", OLED_PIPE);
+                OLED_DISPLAY::setCursor(0, 16);
+                ESPCOM::print("", OLED_PIPE);
+                OLED_DISPLAY::setCursor(0, 48);
+                ESPCOM::print("Wifi disabled", OLED_PIPE);
+#endif
+                WiFi.disconnect(true);
+                WiFi.enableSTA (false);
+                WiFi.enableAP (false);
+                WiFi.mode (WIFI_OFF);
+                wifi_config.WiFi_on = false;
+                wifi_config.Disable_servers();
+                return response;
+            } else {
+                ESPCOM::println ("Wifi already off", output, espresponse);
+            }
+        } else if (mode == 1) { //restart device is the best way to start everything clean
+            if ((WiFi.getMode() == WIFI_OFF) || !wifi_config.WiFi_on) {
+                ESPCOM::println ("Enabling Wifi", output, espresponse);
+                web_interface->restartmodule = true;
+            } else {
+                ESPCOM::println ("Wifi already on", output, espresponse);
+            }
+        } else  { //restart wifi and restart is the best way to start everything clean
+            ESPCOM::println ("Enabling Wifi", output, espresponse);
+            web_interface->restartmodule = true;
+        }
+    }
+    return response;
+}
+
+//Get current IP
+//[ESP111]<header answer>
+bool esp_cmd_111 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    String currentIP ;
+    if (WiFi.getMode() == WIFI_STA) {
+        currentIP = WiFi.localIP().toString();
+    } else {
+        currentIP = WiFi.softAPIP().toString();
+    }
+    ESPCOM::print (cmd_params, output, espresponse);
+    ESPCOM::println (currentIP, output, espresponse);
+    LOG (cmd_params)
+    LOG (currentIP)
+    LOG ("\r\n")
+    return true;
+}
+
+//Get hostname
+//[ESP112]<header answer>
+bool esp_cmd_112 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    String shost ;
+    if (!CONFIG::read_string (EP_HOSTNAME, shost, MAX_HOSTNAME_LENGTH) ) {
+        shost = wifi_config.get_default_hostname();
+    }
+    ESPCOM::print (cmd_params, output, espresponse);
+    ESPCOM::println (shost, output, espresponse);
+    LOG (cmd_params)
+    LOG (shost)
+    LOG ("\r\n")
+    return true;
+}
+
+#if defined(TIMESTAMP_FEATURE)
+//restart time client
+bool esp_cmd_114 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    CONFIG::init_time_client();
+    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    LOG ("restart time client\r\n")
+    return true;
+}
+
+//get time client
+bool esp_cmd_115 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    struct tm  tmstruct;
+    time_t now;
+    String stmp = "";
+    time(&now);
+    localtime_r(&now, &tmstruct);
+    stmp = String((tmstruct.tm_year)+1900) + "-";
+    if (((tmstruct.tm_mon)+1) < 10) {
+        stmp +="0";
+    }
+    stmp += String(( tmstruct.tm_mon)+1) + "-";
+    if (tmstruct.tm_mday < 10) {
+        stmp +="0";
+    }
+    stmp += String(tmstruct.tm_mday) + " ";
+    if (tmstruct.tm_hour < 10) {
+        stmp +="0";
+    }
+    stmp += String(tmstruct.tm_hour) + ":";
+    if (tmstruct.tm_min < 10) {
+        stmp +="0";
+    }
+    stmp += String(tmstruct.tm_min) + ":";
+    if (tmstruct.tm_sec < 10) {
+        stmp +="0";
+    }
+    stmp += String(tmstruct.tm_sec);
+    ESPCOM::println(stmp.c_str(), output, espresponse);
+    return true;
+}
+#endif
+//Get available AP list (limited to 30)
+//output is JSON or plain text according parameter
+//[ESP410]<plain>
+bool esp_cmd_410 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool plain = (parameter == "plain");
+    JSON_WRITER writer (output, espresponse);
+
+#if defined(ASYNCWEBSERVER)
+    if (!plain) {
+        writer.print (F ("{\"AP_LIST\":["));
+    }
+    int n = WiFi.scanComplete();
+    if (n == -2) {
+        WiFi.scanNetworks (ESP_USE_ASYNC);
+    } else if (n) {
+#else
+    int n =  WiFi.scanNetworks ();
+    if (!plain) {
+        writer.print (F ("{\"AP_LIST\":["));
+    }
+#endif
+
+        for (int i = 0; i < n; ++i) {
+            if (i > 0) {
+                if (!plain) {
+                    writer.print (F (","));
+                } else {
+                    writer.print (F ("\n"));
+                }
+            }
+            if (!plain) {
+                writer.print (F ("{\"SSID\":\""));
+                writer.escaped (WiFi.SSID (i).c_str());
+            } else writer.print (WiFi.SSID (i).c_str());
+            if (!plain) {
+                writer.print (F ("\",\"SIGNAL\":\""));
+            } else {
+                writer.print (F ("\t"));
+            }
+            writer.number (wifi_config.getSignal (WiFi.RSSI (i) ) );
+            //ESPCOM::print(F("%"), output, espresponse);
+            if (!plain) {
+                writer.print (F ("\",\"IS_PROTECTED\":\""));
+            }
+            if (WiFi.encryptionType (i) == ENC_TYPE_NONE) {
+                if (!plain) {
+                    writer.print (F ("0"));
+                } else {
+                    writer.print (F ("\tOpen"));
+                }
+            } else {
+                if (!plain) {
+                    writer.print (F ("1"));
+                } else {
+                    writer.print (F ("\tSecure"));
+                }
+            }
+            if (!plain) {
+                writer.print (F ("\"}"));
+            }
+        }
+        WiFi.scanDelete();
+#if defined(ASYNCWEBSERVER)
+        if (WiFi.scanComplete() == -2) {
+            WiFi.scanNetworks (ESP_USE_ASYNC);
+        }
+    }
+#endif
+    if (!plain) {
+        writer.print (F ("]}"));
+    } else {
+        writer.print (F ("\n"));
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,134 @@
+/*
+  command_notification.cpp - ESP3D notification commands
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "config.h"
+#include "command.h"
+#include "command_handlers.h"
+#ifdef NOTIFICATION_FEATURE
+#include "notifications_service.h"
+#endif
+
+#ifndef USE_AS_UPDATER_ONLY
+#ifdef NOTIFICATION_FEATURE
+//Send Notification
+//[ESP600]msg [pwd=<admin password>]
+bool esp_cmd_600 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (parameter.length() == 0) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        return false;
+    }
+    if (notificationsservice.sendMSG("ESP3D Notification", parameter.c_str())) {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    } else {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    return response;
+}
+
+//Set/Get Notification settings
+//[ESP610]type=<NONE/PUSHOVER/EMAIL/LINE> T1=<token1> T2=<token2> TS=<Settings> [pwd=<admin password>]
+//Get will give type and settings only not the protected T1/T2
+bool esp_cmd_610 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    //get
+    if (!params.has_value ("")) {
+        uint8_t Ntype =  0;
+        if (!CONFIG::read_byte (ESP_NOTIFICATION_TYPE, &Ntype ) ) {
+            Ntype =0;
+        }
+        char sbuf[MAX_DATA_LENGTH + 1];
+        static String tmp;
+        tmp = (Ntype == ESP_PUSHOVER_NOTIFICATION)?"PUSHOVER":(Ntype == ESP_EMAIL_NOTIFICATION)?"EMAIL":(Ntype == ESP_LINE_NOTIFICATION)?"LINE":"NONE";
+        if (CONFIG::read_string (ESP_NOTIFICATION_SETTINGS, sbuf, MAX_NOTIFICATION_SETTINGS_LENGTH) ) {
+            tmp+= " ";
+            tmp += sbuf;
+        }
+        ESPCOM::println (tmp.c_str(), output, espresponse);
+    } else {
+        response = false;
+        //type
+        parameter = params.get_string ("type=");
+        if (parameter.length() > 0) {
+            uint8_t Ntype;
+            parameter.toUpperCase();
+            if (parameter == "NONE") {
+                Ntype = 0;
+            } else if (parameter == "PUSHOVER") {
+                Ntype = ESP_PUSHOVER_NOTIFICATION;
+            } else if (parameter == "EMAIL") {
+                Ntype = ESP_EMAIL_NOTIFICATION;
+            } else if (parameter == "LINE") {
+                Ntype = ESP_LINE_NOTIFICATION;
+            } else {
+                ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+                return false;
+            }
+            if (!CONFIG::write_byte (ESP_NOTIFICATION_TYPE, Ntype) ) {
+                ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+                return false;
+            } else {
+                response = true;
+            }
+        }
+        //Settings
+        parameter = params.get_string ("TS=");
+        if (parameter.length() > 0) {
+            if (!CONFIG::write_string (ESP_NOTIFICATION_SETTINGS, parameter.c_str() ) ) {
+                ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+                return false;
+            } else {
+                response = true;
+            }
+        }
+        //Token1
+        parameter = params.get_string ("T1=");
+        if (parameter.length() > 0) {
+            if (!CONFIG::write_string (ESP_NOTIFICATION_TOKEN1, parameter.c_str() ) ) {
+                ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+                return false;
+            } else {
+                response = true;
+            }
+        }
+        //Token2
+        parameter = params.get_string ("T2=");
+        if (parameter.length() > 0) {
+            if (!CONFIG::write_string (ESP_NOTIFICATION_TOKEN2, parameter.c_str() ) ) {
+                ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+                return false;
+            } else {
+                response = true;
+            }
+        }
+        if (response) {
+            //Restart service
+            notificationsservice.begin();
+            ESPCOM::println (OK_CMD_MSG, output, espresponse);
+        } else {
+            ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        }
+    }
+    return response;
+}
+#endif
+#endif
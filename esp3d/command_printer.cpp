@@ -0,0 +1,166 @@
+/*
+  command_printer.cpp - ESP3D printer commands
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "config.h"
+#include "command.h"
+#include "command_handlers.h"
+#include "webinterface.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "telemetry.h"
+#endif
+
+extern uint8_t Checksum(const char * line, uint16_t lineSize);
+extern bool sendLine2Serial (String &  line, int32_t linenb, int32_t* newlinenb);
+
+#ifndef USE_AS_UPDATER_ONLY
+//Get printer telemetry (temperatures, position, SD progress, state) from printer output
+//[ESP430]<plain>
+bool esp_cmd_430 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    TELEMETRY::print (output, (parameter == "plain"), espresponse);
+    return true;
+}
+
+//[ESP500]<gcode>
+//send GCode with check sum caching right line numbering
+bool esp_cmd_500 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    //be sure serial is locked
+    if ( (web_interface->blockserial) ) {
+        return true;
+    }
+    int32_t linenb = 1;
+    cmd_params.trim() ;
+    if (sendLine2Serial (cmd_params, linenb,  &linenb)) {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    } else { //it may failed because of skip if repetier so let's reset numbering first
+        if ( ( CONFIG::GetFirmwareTarget() == REPETIER4DV) || (CONFIG::GetFirmwareTarget() == REPETIER) ) {
+            //reset numbering
+            String cmd = "M110 N0";
+            if (sendLine2Serial (cmd, -1,  NULL)) {
+                linenb = 1;
+                //if success let's try again to send the command
+                if (sendLine2Serial (cmd_params, linenb,  &linenb)) {
+                    ESPCOM::println (OK_CMD_MSG, output, espresponse);
+                } else {
+                    ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+                    response = false;
+                }
+            } else {
+                ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+                response = false;
+            }
+        } else {
+
+            ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+            response = false;
+        }
+    }
+    return response;
+}
+
+//[ESP501]<line>
+//send line checksum
+bool esp_cmd_501 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    cmd_params.trim();
+    int8_t chk = Checksum(cmd_params.c_str(),cmd_params.length());
+    String schecksum = "Checksum: " + String(chk);
+    ESPCOM::println (schecksum, output, espresponse);
+    return true;
+}
+
+//Send line to printer by emergency lane, even if serial is busy
+//[ESP502]<line>
+bool esp_cmd_502 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    uint32_t start_us = micros();
+    if (ESPCOM::send_urgent (parameter.c_str(), start_us)) {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    } else {
+        ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    return response;
+}
+
+//Get / Reset emergency lane latency (time until command is out of UART)
+//[ESP503]<RESET>
+bool esp_cmd_503 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    if (parameter == "RESET") {
+        ESPCOM::urgent_count = 0;
+        ESPCOM::urgent_last_us = 0;
+        ESPCOM::urgent_max_us = 0;
+        ESPCOM::urgent_total_us = 0;
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+        return true;
+    }
+    ESPCOM::print (F ("Urgent: "), output, espresponse);
+    ESPCOM::print (String (ESPCOM::urgent_count).c_str(), output, espresponse);
+    ESPCOM::print (F (", last: "), output, espresponse);
+    ESPCOM::print (String (ESPCOM::urgent_last_us).c_str(), output, espresponse);
+    ESPCOM::print (F (" us, max: "), output, espresponse);
+    ESPCOM::print (String (ESPCOM::urgent_max_us).c_str(), output, espresponse);
+    ESPCOM::print (F (" us, avg: "), output, espresponse);
+    ESPCOM::print (String (ESPCOM::urgent_count ? (ESPCOM::urgent_total_us / ESPCOM::urgent_count) : 0).c_str(), output, espresponse);
+    ESPCOM::println (F (" us"), output, espresponse);
+    return true;
+}
+
+//Release serial lock
+//[ESP810]
+bool esp_cmd_810 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    web_interface->blockserial = false;
+    return true;
+}
+
+//Get/Set serial communication state
+//[ESP900]<ENABLE/DISABLE>[pwd=<admin password>]
+bool esp_cmd_900 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (parameter.length() == 0) {
+        if (CONFIG::is_com_enabled) {
+            ESPCOM::print (F ("ENABLED"), output, espresponse);
+        } else {
+            ESPCOM::print (F ("DISABLED"), output, espresponse);
+        }
+    } else {
+        if (parameter == "ENABLE") {
+            CONFIG::DisableSerial();
+             if (!CONFIG::InitBaudrate()){
+                 ESPCOM::print (F ("Cannot enable serial communication"), output, espresponse);
+             } else {
+                 ESPCOM::print (F ("Enable serial communication"), output, espresponse);
+             }
+        } else if (parameter == "DISABLE") {
+            ESPCOM::print (F ("Disable serial communication"), output, espresponse);
+            CONFIG::DisableSerial();
+        } else {
+            ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+            response = false;
+        }
+    }
+    return response;
+}
+#endif
@@ -0,0 +1,498 @@
+/*
+  command_settings.cpp - ESP3D settings commands
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "config.h"
+#include "command.h"
+#include "command_handlers.h"
+#include "wificonf.h"
+#include "webinterface.h"
+#include "configtable.h"
+#include "jsonwriter.h"
+#ifdef NOTIFICATION_FEATURE
+#include "notifications_service.h"
+#endif
+#ifndef USE_AS_UPDATER_ONLY
+#include "gcode_stream.h"
+#include "telemetry.h"
+#endif
+
+#ifndef USE_AS_UPDATER_ONLY
+//display ESP3D EEPROM version detected
+bool esp_cmd_300 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    uint8_t v = CONFIG::get_EEPROM_version();
+    ESPCOM::println (String(v).c_str(), output, espresponse);
+    return true;
+}
+
+//print one [ESP400] entry from its descriptor
+static void print_setting (const setting_t & setting, JSON_WRITER & writer)
+{
+    char sbuf[MAX_DATA_LENGTH + 1];
+    if (setting.flags & SETTING_PRINTER) {
+        writer.print (F ("{\"F\":\"printer\",\"P\":\""));
+    } else {
+        writer.print (F ("{\"F\":\"network\",\"P\":\""));
+    }
+    writer.number (setting.pos);
+    writer.print (F ("\",\"T\":\""));
+    writer.print (setting.type);
+    writer.print (F ("\",\"V\":\""));
+    if (!CONFIG_TABLE::get_value (setting, sbuf, sizeof (sbuf)) ) {
+        writer.print (F ("???"));
+    } else if (setting.flags & SETTING_SECRET) {
+        writer.print (F ("********"));
+    } else if (setting.type == 'S') {
+        writer.escaped (sbuf);
+    } else {
+        writer.print (sbuf);
+    }
+    writer.print (F ("\",\"H\":\""));
+    writer.print (setting.label);
+    if ((setting.options_nb > 0) || (setting.flags & SETTING_RANGE)) {
+        setting_option_t option;
+        writer.print (F ("\",\"O\":["));
+        for (uint8_t i = 0; CONFIG_TABLE::get_option (setting, i, option); i++) {
+            if (i > 0) {
+                writer.print (',');
+            }
+            writer.print (F ("{\""));
+            writer.print (option.label);
+            writer.print (F ("\":\""));
+            writer.number (option.value);
+            writer.print (F ("\"}"));
+        }
+        writer.print (F ("]}"));
+    } else if ((setting.type == 'S') || (setting.type == 'I')) {
+        writer.print (F ("\",\"S\":\""));
+        writer.number (setting.max);
+        writer.print (F ("\",\"M\":\""));
+        writer.number (setting.min);
+        writer.print (F ("\"}"));
+    } else {
+        writer.print (F ("\"}"));
+    }
+}
+
+//Get full EEPROM settings content
+//[ESP400]<network/printer>
+bool esp_cmd_400 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool network = (cmd_params == "network" || cmd_params == "");
+    bool printer = (cmd_params == "printer" || cmd_params == "");
+    bool first = true;
+    setting_t setting;
+    JSON_WRITER writer (output, espresponse);
+    //Start JSON
+    writer.println (F ("{\"EEPROM\":["));
+    for (uint8_t i = 0; i < CONFIG_TABLE::count(); i++) {
+        CONFIG_TABLE::get (i, setting);
+        if ((setting.flags & SETTING_HIDDEN) || !((setting.flags & SETTING_PRINTER) ? printer : network)) {
+            continue;
+        }
+        if (!first) {
+            writer.println (F (","));
+        }
+        first = false;
+        print_setting (setting, writer);
+    }
+    //end JSON
+    writer.println (F ("\n]}"));
+    return true;
+}
+
+//subsystems to refresh when a setting changes
+#define SETTING_HOOK_OUTPUT 0x01
+#define SETTING_HOOK_TARGET_FW 0x02
+#define SETTING_HOOK_STREAM 0x04
+#define SETTING_HOOK_DHT 0x08
+#define SETTING_HOOK_NOTIFICATION 0x10
+#define SETTING_HOOK_TIME 0x20
+
+static uint8_t setting_hooks (int pos)
+{
+    switch (pos) {
+    case EP_OUTPUT_FLAG:
+        return SETTING_HOOK_OUTPUT;
+    case EP_TARGET_FW:
+        return SETTING_HOOK_TARGET_FW | SETTING_HOOK_STREAM;
+    case EP_STREAM_WINDOW:
+        return SETTING_HOOK_STREAM;
+    case EP_DHT_TYPE:
+    case EP_DHT_INTERVAL:
+        return SETTING_HOOK_DHT;
+    case ESP_AUTO_NOTIFICATION:
+        return SETTING_HOOK_NOTIFICATION;
+    case EP_TIMEZONE:
+    case EP_TIME_ISDST:
+    case EP_TIME_SERVER1:
+    case EP_TIME_SERVER2:
+    case EP_TIME_SERVER3:
+        return SETTING_HOOK_TIME;
+    default:
+        break;
+    }
+    return 0;
+}
+
+//dynamique refresh is better than restart the board
+static void run_setting_hooks (uint8_t hooks)
+{
+    byte bbuf = 0;
+    if (hooks & SETTING_HOOK_OUTPUT) {
+        if (CONFIG::read_byte (EP_OUTPUT_FLAG, &bbuf)) {
+            CONFIG::output_flag = bbuf;
+        }
+    }
+    if (hooks & SETTING_HOOK_TARGET_FW) {
+        CONFIG::InitFirmwareTarget();
+    }
+#ifndef USE_AS_UPDATER_ONLY
+    if (hooks & SETTING_HOOK_STREAM) {
+        GCODE_STREAM::init_credit();
+    }
+    //values of previous printer are no more valid
+    if (hooks & SETTING_HOOK_TARGET_FW) {
+        TELEMETRY::clear();
+    }
+#endif
+#ifdef DHT_FEATURE
+    if (hooks & SETTING_HOOK_DHT) {
+        //reload type and interval from settings
+        CONFIG::InitDHT();
+    }
+#endif
+#ifdef NOTIFICATION_FEATURE
+    if (hooks & SETTING_HOOK_NOTIFICATION) {
+        if (CONFIG::read_byte (ESP_AUTO_NOTIFICATION, &bbuf)) {
+            notificationsservice.setAutonotification ((bbuf == 0)? false: true);
+        }
+    }
+#endif
+#if defined(TIMESTAMP_FEATURE)
+    if (hooks & SETTING_HOOK_TIME) {
+        CONFIG::init_time_client();
+    }
+#endif
+}
+
+//check position, type, value and authentication of one setting change
+static bool check_setting (String & spos, String & styp, String & sval, level_authenticate_type auth_type, setting_t & setting)
+{
+    int pos = spos.toInt();
+    if ( (pos == 0 && spos != "0") || !CONFIG_TABLE::find (pos, setting) ) {
+        return false;
+    }
+    if ( (styp.length() != 1) || !CONFIG_TABLE::is_type (setting, styp[0]) || !CONFIG_TABLE::is_valid (setting, sval.c_str()) ) {
+        return false;
+    }
+#ifdef AUTHENTICATION_FEATURE
+    if ( (setting.level == LEVEL_ADMIN && auth_type == LEVEL_USER) || (auth_type == LEVEL_GUEST) ) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+//Set EEPROM setting
+//[ESP401]P=<position> T=<type> V=<value> pwd=<user/admin password>
+bool esp_cmd_401 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    setting_t setting;
+    String spos = params.get_string ("P=");
+    String styp = params.get_string ("T=");
+    String sval = params.get_string ("V=", true);
+    sval.trim();
+    bool response = check_setting (spos, styp, sval, auth_type, setting) && CONFIG_TABLE::set_value (setting, sval.c_str());
+    if (response) {
+        run_setting_hooks (setting_hooks (setting.pos));
+    }
+    if (!response) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+    } else {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    }
+    return response;
+}
+
+//read next P=<position> T=<type> V=<value> group
+//value goes until next " P=" or " pwd=", returns 0 at end, -1 if malformed
+static int next_setting (const char * & p, String & spos, String & styp, String & sval)
+{
+    while (*p == ' ') {
+        p++;
+    }
+    if ((*p == 0) || (strncmp (p, "pwd=", 4) == 0)) {
+        return 0;
+    }
+    if (strncmp (p, "P=", 2) != 0) {
+        return -1;
+    }
+    p += 2;
+    const char * start = p;
+    while (*p && *p != ' ') {
+        p++;
+    }
+    spos = String (start).substring (0, p - start);
+    while (*p == ' ') {
+        p++;
+    }
+    styp = "";
+    if (strncmp (p, "T=", 2) == 0) {
+        p += 2;
+        start = p;
+        while (*p && *p != ' ') {
+            p++;
+        }
+        styp = String (start).substring (0, p - start);
+        while (*p == ' ') {
+            p++;
+        }
+    }
+    if (strncmp (p, "V=", 2) != 0) {
+        return -1;
+    }
+    p += 2;
+    start = p;
+    while (*p && !((*p == ' ') && ((strncmp (p + 1, "P=", 2) == 0) || (strncmp (p + 1, "pwd=", 4) == 0)))) {
+        p++;
+    }
+    sval = String (start).substring (0, p - start);
+    sval.trim();
+    return 1;
+}
+
+//Set several EEPROM settings at once, all or nothing, one flash commit
+//[ESP402]P=<position> T=<type> V=<value> P=<position> T=<type> V=<value> ... pwd=<user/admin password>
+bool esp_cmd_402 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    setting_t setting;
+    String spos, styp, sval;
+    uint8_t hooks = 0;
+    int nb = 0;
+    int res;
+    bool response = true;
+    //check all changes first
+    const char * p = cmd_params.c_str();
+    while ((res = next_setting (p, spos, styp, sval)) == 1) {
+        //type is optional here, table knows it
+        if (styp.length() == 0) {
+            if (!CONFIG_TABLE::find (spos.toInt(), setting)) {
+                response = false;
+                break;
+            }
+            styp = String (setting.type);
+        }
+        if (!check_setting (spos, styp, sval, auth_type, setting)) {
+            LOG ("Rejected setting ")
+            LOG (spos)
+            LOG ("\r\n")
+            response = false;
+            break;
+        }
+        hooks |= setting_hooks (setting.pos);
+        nb++;
+    }
+    if ((res == -1) || (nb == 0)) {
+        response = false;
+    }
+    //then write them and commit once
+    if (response) {
+        //copy of settings RAM image, put back if any write fails so nothing is kept
+        byte * image = new byte[LAST_EEPROM_ADDRESS];
+        bool saved = (image != NULL) && CONFIG::read_buffer (0, image, LAST_EEPROM_ADDRESS);
+        if (!saved) {
+            response = false;
+        }
+        p = cmd_params.c_str();
+        while (response && (next_setting (p, spos, styp, sval) == 1)) {
+            CONFIG_TABLE::find (spos.toInt(), setting);
+            if (!CONFIG_TABLE::set_value (setting, sval.c_str())) {
+                LOG ("Failed setting ")
+                LOG (spos)
+                LOG ("\r\n")
+                response = false;
+            }
+        }
+        if (response && !CONFIG::commit_settings()) {
+            response = false;
+        }
+        if (response) {
+            run_setting_hooks (hooks);
+        } else if (saved) {
+            CONFIG::write_buffer (0, image, LAST_EEPROM_ADDRESS);
+        }
+        if (image) {
+            delete[] image;
+        }
+    }
+    if (!response) {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+    } else {
+        ESPCOM::println (OK_CMD_MSG, output, espresponse);
+    }
+    return response;
+}
+#endif
+//Get ESP current status in plain or JSON
+//[ESP420]<plain>
+bool esp_cmd_420 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    CONFIG::print_config (output, (parameter == "plain"), espresponse);
+    return true;
+}
+
+//Set ESP mode
+//cmd is RESET, SAFEMODE, RESTART
+//[ESP444]<cmd>pwd=<admin password>
+bool esp_cmd_444 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (parameter == "RESET") {
+        CONFIG::reset_config();
+        ESPCOM::println (F ("Reset done - restart needed"), output, espresponse);
+    } else if (parameter == "SAFEMODE") {
+        wifi_config.Safe_Setup();
+        ESPCOM::println (F ("Set Safe Mode  - restart needed"), output, espresponse);
+    } else  if (parameter == "RESTART") {
+        ESPCOM::println (F ("Restart started"), output, espresponse);
+        web_interface->restartmodule = true;
+    } else {
+        ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+        response = false;
+    }
+    return response;
+}
+
+#ifndef USE_AS_UPDATER_ONLY
+#ifdef AUTHENTICATION_FEATURE
+//Change / Reset user password
+//[ESP555]<password>pwd=<admin password>
+bool esp_cmd_555 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    bool response = true;
+    if (parameter.length() == 0) {
+        if (CONFIG::write_string (EP_USER_PWD, FPSTR (DEFAULT_USER_PWD) ) ) {
+            ESPCOM::println (OK_CMD_MSG, output, espresponse);
+        } else {
+            ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+            response = false;
+        }
+    } else {
+        if (CONFIG::isLocalPasswordValid (parameter.c_str() ) ) {
+            if (CONFIG::write_string (EP_USER_PWD, parameter.c_str() ) ) {
+                ESPCOM::println (OK_CMD_MSG, output, espresponse);
+            } else {
+                ESPCOM::println (ERROR_CMD_MSG, output, espresponse);
+                response = false;
+            }
+        } else {
+            ESPCOM::println (INCORRECT_CMD_MSG, output, espresponse);
+            response = false;
+        }
+    }
+    return response;
+}
+#endif
+#endif
+//get fw version firmare target and fw version
+//[ESP800]<header answer>
+bool esp_cmd_800 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    byte sd_dir = 0;
+    String shost ;
+    if (!CONFIG::read_string (EP_HOSTNAME, shost, MAX_HOSTNAME_LENGTH) ) {
+        shost = wifi_config.get_default_hostname();
+    }
+    ESPCOM::print (cmd_params, output, espresponse);
+    ESPCOM::print (F ("FW version:"), output, espresponse);
+    ESPCOM::print (FW_VERSION, output, espresponse);
+    ESPCOM::print (F (" # FW target:"), output, espresponse);
+    ESPCOM::print (CONFIG::GetFirmwareTargetShortName(), output, espresponse);
+    ESPCOM::print (F (" # FW HW:"), output, espresponse);
+    if (CONFIG::is_direct_sd) {
+        ESPCOM::print (F ("Direct SD"), output, espresponse);
+    } else {
+        ESPCOM::print (F ("Serial SD"), output, espresponse);
+    }
+    ESPCOM::print (F (" # primary sd:"), output, espresponse);
+    if (!CONFIG::read_byte (EP_PRIMARY_SD, &sd_dir ) ) {
+        sd_dir = DEFAULT_PRIMARY_SD;
+    }
+    if (sd_dir == SD_DIRECTORY) {
+        ESPCOM::print (F ("/sd/"), output, espresponse);
+    } else if (sd_dir == EXT_DIRECTORY) {
+        ESPCOM::print (F ("/ext/"), output, espresponse);
+    } else {
+        ESPCOM::print (F ("none"), output, espresponse);
+    }
+    ESPCOM::print (F (" # secondary sd:"), output, espresponse);
+    if (!CONFIG::read_byte (EP_SECONDARY_SD, &sd_dir ) ) {
+        sd_dir = DEFAULT_SECONDARY_SD;
+    }
+    if (sd_dir == SD_DIRECTORY) {
+        ESPCOM::print (F ("/sd/"), output, espresponse);
+    } else if (sd_dir == EXT_DIRECTORY) {
+        ESPCOM::print (F ("/ext/"), output, espresponse);
+    } else {
+        ESPCOM::print (F ("none"), output, espresponse);
+    }
+    ESPCOM::print (F (" # authentication:"), output, espresponse);
+#ifdef AUTHENTICATION_FEATURE
+    ESPCOM::print (F ("yes"), output, espresponse);
+#else
+    ESPCOM::print (F ("no"), output, espresponse);
+#endif
+    ESPCOM::print (F (" # webcommunication:"), output, espresponse);
+#if defined (ASYNCWEBSERVER)
+    ESPCOM::print (F ("Async"), output, espresponse);
+#else
+    ESPCOM::print (F ("Sync:"), output, espresponse);
+    String sp = String(wifi_config.iweb_port+1);
+    sp += ":";
+    if (WiFi.getMode() == WIFI_STA) {
+         sp += WiFi.localIP().toString();
+    } else if ((WiFi.getMode() == WIFI_AP) || (WiFi.getMode() == WIFI_AP_STA)) {
+         sp += WiFi.softAPIP().toString();
+    } else {
+         sp += "0.0.0.0";
+    }
+    ESPCOM::print (sp.c_str(), output, espresponse);
+#endif
+
+    ESPCOM::print (F (" # hostname:"), output, espresponse);
+    ESPCOM::print (shost, output, espresponse);
+    if (WiFi.getMode() == WIFI_AP) {
+        ESPCOM::print (F("(AP mode)"), output, espresponse);
+    }
+
+    ESPCOM::println ("", output, espresponse);
+    return true;
+}
+
+#ifndef USE_AS_UPDATER_ONLY
+//get fw target
+//[ESP801]<header answer>
+bool esp_cmd_801 (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse)
+{
+    ESPCOM::print (cmd_params, output, espresponse);
+    ESPCOM::println (CONFIG::GetFirmwareTargetShortName(), output, espresponse);
+    return true;
+}
+#endif
@@ -36,6 +36,14 @@ extern "C" {
 #include "esp_wifi.h"
 #endif
 #include "espcom.h"
+#include "configtable.h"
+#include "jsonwriter.h"
+#ifdef AUTHENTICATION_FEATURE
+#include "authcache.h"
+#endif
+#ifdef CONFIG_JOURNAL_FEATURE
+#include "configjournal.h"
+#endif
 #ifdef TIMESTAMP_FEATURE
 #include <time.h>
 #endif
@@ -48,8 +56,19 @@ extern DHTesp dht;
 #ifdef NOTIFICATION_FEATURE
 #include "notifications_service.h"
 #endif
+#ifndef USE_AS_UPDATER_ONLY
+#include "grblcom.h"
+#endif
 
 uint8_t CONFIG::FirmwareTarget = UNKNOWN_FW;
+//settings are mapped in RAM once and committed in batch
+bool CONFIG::eeprom_mapped = false;
+int CONFIG::dirty_start = -1;
+int CONFIG::dirty_end = -1;
+uint32_t CONFIG::last_write_time = 0;
+uint32_t CONFIG::ram_accesses = 0;
+uint32_t CONFIG::ram_writes = 0;
+uint32_t CONFIG::flash_commits = 0;
 byte CONFIG::output_flag = DEFAULT_OUTPUT_FLAG;
 bool  CONFIG::is_com_enabled = false;
 #ifdef DHT_FEATURE
@@ -252,6 +271,7 @@ bool CONFIG::InitExternalPorts()
 void CONFIG::esp_restart (bool async)
 {
     LOG ("Restarting\r\n")
+    commit_settings();
     ESPCOM::flush (DEFAULT_PRINTER_PIPE);
     SPIFFS.end();
     if (!async) {
@@ -600,7 +620,7 @@ bool CONFIG::read_string (int pos, char byte_buffer[], int size_max)
         LOG ("Error read string\r\n")
         return false;
     }
-    EEPROM.begin (EEPROM_SIZE);
+    map_eeprom();
     byte b = 13; // non zero for the while loop below
     int i = 0;
 
@@ -615,7 +635,6 @@ bool CONFIG::read_string (int pos, char byte_buffer[], int size_max)
     if (b != 0) {
         byte_buffer[i - 1] = 0x00;
     }
-    EEPROM.end();
 
     return true;
 }
@@ -631,7 +650,7 @@ bool CONFIG::read_string (int pos, String & sbuffer, int size_max)
     int i = 0;
     sbuffer = "";
 
-    EEPROM.begin (EEPROM_SIZE);
+    map_eeprom();
     //read until max size is reached or \0 is found
     while (i < size_max && b != 0) {
         b = EEPROM.read (pos + i);
@@ -640,7 +659,6 @@ bool CONFIG::read_string (int pos, String & sbuffer, int size_max)
         }
         i++;
     }
-    EEPROM.end();
 
     return true;
 }
@@ -654,13 +672,12 @@ bool CONFIG::read_buffer (int pos, byte byte_buffer[], int size_buffer)
         return false;
     }
     int i = 0;
-    EEPROM.begin (EEPROM_SIZE);
+    map_eeprom();
     //read until max size is reached
     while (i < size_buffer ) {
         byte_buffer[i] = EEPROM.read (pos + i);
         i++;
     }
-    EEPROM.end();
     return true;
 }
 
@@ -672,9 +689,8 @@ bool CONFIG::read_byte (int pos, byte * value)
         LOG ("Error read byte\r\n")
         return false;
     }
-    EEPROM.begin (EEPROM_SIZE);
+    map_eeprom();
     value[0] = EEPROM.read (pos);
-    EEPROM.end();
     return true;
 }
 
@@ -689,61 +705,35 @@ bool CONFIG::write_string (int pos, const char * byte_buffer)
 {
     int size_buffer;
     int maxsize = EEPROM_SIZE;
+    bool allow_empty = false;
+    setting_t setting;
     size_buffer = strlen (byte_buffer);
     //check if parameters are acceptable
-    switch (pos) {
-    case EP_ADMIN_PWD:
-    case EP_USER_PWD:
-        maxsize = MAX_LOCAL_PASSWORD_LENGTH;
-        break;
-    case EP_AP_SSID:
-    case EP_STA_SSID:
-        maxsize = MAX_SSID_LENGTH;
-        break;
-    case EP_AP_PASSWORD:
-    case EP_STA_PASSWORD:
-        maxsize = MAX_PASSWORD_LENGTH;
-        break;
-    case EP_HOSTNAME:
-        maxsize = MAX_HOSTNAME_LENGTH;
-        break;
-    case EP_TIME_SERVER1:
-    case EP_TIME_SERVER2:
-    case EP_TIME_SERVER3:
-        maxsize = MAX_DATA_LENGTH;
-        break;
-    case ESP_NOTIFICATION_TOKEN1:
-    case ESP_NOTIFICATION_TOKEN2:
-        maxsize = MAX_NOTIFICATION_TOKEN_LENGTH;
-        break;
-    case ESP_NOTIFICATION_SETTINGS:
-        maxsize = MAX_NOTIFICATION_SETTINGS_LENGTH;
-        break;
-    default:
-        maxsize = EEPROM_SIZE;
-        break;
+    if (CONFIG_TABLE::find (pos, setting) && (setting.type == 'S')) {
+        maxsize = setting.max;
+        allow_empty = (setting.flags & SETTING_EMPTY);
     }
     if ( pos + size_buffer + 1 > EEPROM_SIZE || size_buffer > maxsize  ) {
         LOG ("Error write string\r\n")
         return false;
     }
-
-    if (!((pos == EP_STA_PASSWORD) || (pos == EP_AP_PASSWORD))) {
-        if((size_buffer == 0 ) || (byte_buffer == NULL )) {
-            LOG ("Error write string\r\n")
-            return false;
-        }
+    if ((size_buffer == 0) && !allow_empty) {
+        LOG ("Error write string\r\n")
+        return false;
     }
-    //copy the value(s)
-    EEPROM.begin (EEPROM_SIZE);
+    //copy the value(s) with the 0 terminal, commit is deferred
+    map_eeprom();
     for (int i = 0; i < size_buffer; i++) {
-        EEPROM.write (pos + i, byte_buffer[i]);
+        write_ram (pos + i, byte_buffer[i]);
     }
-
-    //0 terminal
-    EEPROM.write (pos + size_buffer, 0x00);
-    EEPROM.commit();
-    EEPROM.end();
+    write_ram (pos + size_buffer, 0x00);
+    ram_writes++;
+#ifdef AUTHENTICATION_FEATURE
+    //cached credentials are no more valid
+    if ((pos == EP_ADMIN_PWD) || (pos == EP_USER_PWD)) {
+        AUTH_CACHE::invalidate();
+    }
+#endif
     return true;
 }
 
@@ -755,13 +745,12 @@ bool CONFIG::write_buffer (int pos, const byte * byte_buffer, int size_buffer)
         LOG ("Error write buffer\r\n")
         return false;
     }
-    EEPROM.begin (EEPROM_SIZE);
-    //copy the value(s)
+    //copy the value(s), commit is deferred
+    map_eeprom();
     for (int i = 0; i < size_buffer; i++) {
-        EEPROM.write (pos + i, byte_buffer[i]);
+        write_ram (pos + i, byte_buffer[i]);
     }
-    EEPROM.commit();
-    EEPROM.end();
+    ram_writes++;
     return true;
 }
 
@@ -773,244 +762,191 @@ bool CONFIG::write_byte (int pos, const byte value)
         LOG ("Error write byte\r\n")
         return false;
     }
-    EEPROM.begin (EEPROM_SIZE);
-    EEPROM.write (pos, value);
-    EEPROM.commit();
-    EEPROM.end();
+    map_eeprom();
+    write_ram (pos, value);
+    ram_writes++;
     return true;
 }
 
-bool CONFIG::reset_config()
+//load the EEPROM image in RAM, only once
+void CONFIG::map_eeprom()
 {
-    if (!CONFIG::write_byte (EP_WIFI_MODE, DEFAULT_WIFI_MODE) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_BAUD_RATE, (const byte *) &DEFAULT_BAUD_RATE, INTEGER_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (EP_AP_SSID, FPSTR (DEFAULT_AP_SSID) ) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (EP_AP_PASSWORD, FPSTR (DEFAULT_AP_PASSWORD) ) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (EP_STA_SSID, FPSTR (DEFAULT_STA_SSID) ) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (EP_STA_PASSWORD, FPSTR (DEFAULT_STA_PASSWORD) ) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_AP_IP_MODE, DEFAULT_AP_IP_MODE) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_STA_IP_MODE, DEFAULT_STA_IP_MODE) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_STA_IP_VALUE, DEFAULT_IP_VALUE, IP_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_STA_MASK_VALUE, DEFAULT_MASK_VALUE, IP_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_STA_GATEWAY_VALUE, DEFAULT_GATEWAY_VALUE, IP_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_STA_PHY_MODE, DEFAULT_PHY_MODE) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_AP_IP_VALUE, DEFAULT_IP_VALUE, IP_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_AP_MASK_VALUE, DEFAULT_MASK_VALUE, IP_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_AP_GATEWAY_VALUE, DEFAULT_GATEWAY_VALUE, IP_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_AP_PHY_MODE, DEFAULT_PHY_MODE) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_SLEEP_MODE, DEFAULT_SLEEP_MODE) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_CHANNEL, DEFAULT_CHANNEL) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_AUTH_TYPE, DEFAULT_AUTH_TYPE) ) {
-        return false;
-    }
-    if (!CONFIG::write_byte (EP_SSID_VISIBLE, DEFAULT_SSID_VISIBLE) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_WEB_PORT, (const byte *) &DEFAULT_WEB_PORT, INTEGER_LENGTH) ) {
-        return false;
-    }
-    if (!CONFIG::write_buffer (EP_DATA_PORT, (const byte *) &DEFAULT_DATA_PORT, INTEGER_LENGTH) ) {
-        return false;
-    }
-
-    if (!CONFIG::write_string (EP_HOSTNAME, wifi_config.get_default_hostname() ) ) {
-        return false;
-    }
-
-    if (!CONFIG::write_string (EP_ADMIN_PWD, FPSTR (DEFAULT_ADMIN_PWD) ) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (EP_USER_PWD, FPSTR (DEFAULT_USER_PWD) ) ) {
-        return false;
-    }
-
-    if (!CONFIG::write_byte (EP_TARGET_FW, UNKNOWN_FW) ) {
-        return false;
-    }
-#if defined(TIMESTAMP_FEATURE)
-    if (!CONFIG::write_byte (EP_TIMEZONE, DEFAULT_TIME_ZONE) ) {
-        return false;
+    ram_accesses++;
+    if (eeprom_mapped) {
+        return;
     }
+    EEPROM.begin (EEPROM_SIZE);
+    eeprom_mapped = true;
+#ifdef CONFIG_JOURNAL_FEATURE
+    //latest settings are in journal if any
+    CONFIG_JOURNAL::begin();
+#endif
+}
 
-    if (!CONFIG::write_byte (EP_TIME_ISDST, DEFAULT_TIME_DST) ) {
-        return false;
+//update RAM image and extend dirty range if value changed
+void CONFIG::write_ram (int pos, byte value)
+{
+    if (EEPROM.read (pos) == value) {
+        return;
     }
-
-    if (!CONFIG::write_string (EP_TIME_SERVER1, FPSTR (DEFAULT_TIME_SERVER1) ) ) {
-        return false;
+    EEPROM.write (pos, value);
+    if (dirty_start == -1 || pos < dirty_start) {
+        dirty_start = pos;
     }
-
-    if (!CONFIG::write_string (EP_TIME_SERVER2, FPSTR (DEFAULT_TIME_SERVER2) ) ) {
-        return false;
+    if (pos > dirty_end) {
+        dirty_end = pos;
     }
+    last_write_time = millis();
+}
 
-    if (!CONFIG::write_string (EP_TIME_SERVER3, FPSTR (DEFAULT_TIME_SERVER3) ) ) {
-        return false;
+//write all pending changes in one flash commit
+bool CONFIG::commit_settings()
+{
+    if (dirty_start == -1) {
+        return true;
     }
+    LOG ("Commit settings ")
+    LOG (String (dirty_start))
+    LOG ("-")
+    LOG (String (dirty_end))
+    LOG ("\r\n")
+#ifdef CONFIG_JOURNAL_FEATURE
+    //once journal is used, EEPROM sector is no more updated
+    if (CONFIG_JOURNAL::started()) {
+        if (!CONFIG_JOURNAL::append (dirty_start, dirty_end - dirty_start + 1)) {
+            LOG ("Error commit settings\r\n")
+            return false;
+        }
+    } else
 #endif
+        if (!EEPROM.commit()) {
+            LOG ("Error commit settings\r\n")
+            return false;
+        }
+    flash_commits++;
+    dirty_start = -1;
+    dirty_end = -1;
+    return true;
+}
 
-    if (!CONFIG::write_byte (EP_OUTPUT_FLAG, DEFAULT_OUTPUT_FLAG) ) {
-        return false;
-    }
-#ifdef DHT_FEATURE
-    if (!CONFIG::write_buffer (EP_DHT_INTERVAL, (const byte *) &DEFAULT_DHT_INTERVAL, INTEGER_LENGTH) ) {
-        return false;
-    }
-
-    if (!CONFIG::write_byte (EP_DHT_TYPE, DEFAULT_DHT_TYPE) ) {
-        return false;
+//commit pending changes once settings are quiet
+void CONFIG::handle_settings()
+{
+    if ((dirty_start != -1) && ((millis() - last_write_time) >= CONFIG_COMMIT_DELAY)) {
+        commit_settings();
     }
+#ifdef CONFIG_JOURNAL_FEATURE
+    CONFIG_JOURNAL::handle();
 #endif
+}
 
-#ifdef NOTIFICATION_FEATURE
-    if (!CONFIG::write_byte (ESP_NOTIFICATION_TYPE, DEFAULT_NOTIFICATION_TYPE) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (ESP_NOTIFICATION_TOKEN1, DEFAULT_NOTIFICATION_TOKEN1 ) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (ESP_NOTIFICATION_TOKEN2, DEFAULT_NOTIFICATION_TOKEN2 ) ) {
-        return false;
-    }
-    if (!CONFIG::write_string (ESP_NOTIFICATION_SETTINGS, DEFAULT_NOTIFICATION_SETTINGS ) ) {
+bool CONFIG::reset_config()
+{
+    //defaults come from settings table
+    if (!CONFIG_TABLE::reset()) {
         return false;
     }
-    if (!CONFIG::write_byte (ESP_AUTO_NOTIFICATION, DEFAULT_AUTO_NOTIFICATION_STATE) ) {
+    if (!set_EEPROM_version(EEPROM_CURRENT_VERSION)) {
         return false;
     }
-#endif
-
-    return set_EEPROM_version(EEPROM_CURRENT_VERSION);
+    //all defaults in one flash write
+    return commit_settings();
 }
 
 void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *espresponse)
 {
+    //all output goes through one buffer
+    JSON_WRITER writer (output, espresponse);
     if (!plaintext) {
-        ESPCOM::print (F ("{\"chip_id\":\""), output, espresponse);
+        writer.print (F ("{\"chip_id\":\""));
     } else {
-        ESPCOM::print (F ("Chip ID: "), output, espresponse);
+        writer.print (F ("Chip ID: "));
     }
 #ifdef ARDUINO_ARCH_ESP8266
-    ESPCOM::print (String (ESP.getChipId() ).c_str(), output, espresponse);
+    writer.print (String (ESP.getChipId() ).c_str());
 #else
-    ESPCOM::print (String ( (uint16_t) (ESP.getEfuseMac() >> 32) ).c_str(), output, espresponse);
+    writer.print (String ( (uint16_t) (ESP.getEfuseMac() >> 32) ).c_str());
 #endif
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"cpu\":\""), output, espresponse);
+        writer.print (F ("\"cpu\":\""));
     } else {
-        ESPCOM::print (F ("CPU Frequency: "), output, espresponse);
+        writer.print (F ("CPU Frequency: "));
     }
-    ESPCOM::print (String (ESP.getCpuFreqMHz() ).c_str(), output, espresponse);
+    writer.print (String (ESP.getCpuFreqMHz() ).c_str());
     if (plaintext) {
-        ESPCOM::print (F ("Mhz"), output, espresponse);
+        writer.print (F ("Mhz"));
     }
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #ifdef ARDUINO_ARCH_ESP32
     if (!plaintext) {
-        ESPCOM::print (F ("\"cpu_temp\":\""), output, espresponse);
+        writer.print (F ("\"cpu_temp\":\""));
     } else {
-        ESPCOM::print (F ("CPU Temperature: "), output, espresponse);
+        writer.print (F ("CPU Temperature: "));
     }
-    ESPCOM::print (String (temperatureRead(), 1).c_str(), output, espresponse);
+    writer.print (String (temperatureRead(), 1).c_str());
     if (plaintext) {
-        ESPCOM::print (F ("C"), output, espresponse);
+        writer.print (F ("C"));
     }
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #endif
     if (!plaintext) {
-        ESPCOM::print (F ("\"freemem\":\""), output, espresponse);
+        writer.print (F ("\"freemem\":\""));
     } else {
-        ESPCOM::print (F ("Free memory: "), output, espresponse);
+        writer.print (F ("Free memory: "));
     }
-    ESPCOM::print (formatBytes (ESP.getFreeHeap() ).c_str(), output, espresponse);
+    writer.print (formatBytes (ESP.getFreeHeap() ).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\""), output, espresponse);
+        writer.print (F ("\""));
     }
-    ESPCOM::print (F ("SDK"), output, espresponse);
+    writer.print (F ("SDK"));
     if (!plaintext) {
-        ESPCOM::print (F ("\":\""), output, espresponse);
+        writer.print (F ("\":\""));
     } else {
-        ESPCOM::print (F (": "), output, espresponse);
+        writer.print (F (": "));
     }
-    ESPCOM::print (ESP.getSdkVersion(), output, espresponse);
+    writer.print (ESP.getSdkVersion());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"flash_size\":\""), output, espresponse);
+        writer.print (F ("\"flash_size\":\""));
     } else {
-        ESPCOM::print (F ("Flash Size: "), output, espresponse);
+        writer.print (F ("Flash Size: "));
     }
-    ESPCOM::print (formatBytes (ESP.getFlashChipSize() ).c_str(), output, espresponse);
+    writer.print (formatBytes (ESP.getFlashChipSize() ).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #ifdef ARDUINO_ARCH_ESP8266
     if (!plaintext) {
-        ESPCOM::print (F ("\"update_size\":\""), output, espresponse);
+        writer.print (F ("\"update_size\":\""));
     } else {
-        ESPCOM::print (F ("Available Size for update: "), output, espresponse);
+        writer.print (F ("Available Size for update: "));
     }
     uint32_t  flashsize = ESP.getFlashChipSize();
     fs::FSInfo info;
@@ -1021,33 +957,33 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
     } else {
         flashsize = flashsize - ESP.getSketchSize()-info.totalBytes-1024;
     }
-    ESPCOM::print(formatBytes(flashsize).c_str(), output, espresponse);
+    writer.print (formatBytes(flashsize).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
         if (flashsize > ( ESP.getSketchSize())) {
-            ESPCOM::println(F("(Ok)"), output, espresponse);
+            writer.println (F("(Ok)"));
         } else {
-            ESPCOM::println(F ("(Not enough)"), output, espresponse);
+            writer.println (F ("(Not enough)"));
         }
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"spiffs_size\":\""), output, espresponse);
+        writer.print (F ("\"spiffs_size\":\""));
     } else {
-        ESPCOM::print (F ("Available Size for SPIFFS: "), output, espresponse);
+        writer.print (F ("Available Size for SPIFFS: "));
     }
-    ESPCOM::print (formatBytes (info.totalBytes).c_str(), output, espresponse);
+    writer.print (formatBytes (info.totalBytes).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #else
     if (!plaintext) {
-        ESPCOM::print (F ("\"update_size\":\""), output, espresponse);
+        writer.print (F ("\"update_size\":\""));
     } else {
-        ESPCOM::print (F ("Available Size for update: "), output, espresponse);
+        writer.print (F ("Available Size for update: "));
     }
      size_t flashsize = 0;
     if (esp_ota_get_running_partition()) {
@@ -1056,45 +992,45 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
             flashsize = partition->size;
         }
     } 
-    ESPCOM::print (formatBytes (flashsize).c_str(), output, espresponse);
+    writer.print (formatBytes (flashsize).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
         if (flashsize  > 0x0) {
-            ESPCOM::println (F ("(Ok)"), output, espresponse);
+            writer.println (F ("(Ok)"));
         } else {
-            ESPCOM::print (F ("(Not enough)"), output, espresponse);
+            writer.print (F ("(Not enough)"));
         }
     }
     if (!plaintext) {
-        ESPCOM::print (F ("\"spiffs_size\":\""), output, espresponse);
+        writer.print (F ("\"spiffs_size\":\""));
     } else {
-        ESPCOM::print (F ("Available Size for SPIFFS: "), output, espresponse);
+        writer.print (F ("Available Size for SPIFFS: "));
     }
-    ESPCOM::print (formatBytes (SPIFFS.totalBytes() ).c_str(), output, espresponse);
+    writer.print (formatBytes (SPIFFS.totalBytes() ).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #endif
     if (!plaintext) {
-        ESPCOM::print (F ("\"baud_rate\":\""), output, espresponse);
+        writer.print (F ("\"baud_rate\":\""));
     } else {
-        ESPCOM::print (F ("Baud rate: "), output, espresponse);
+        writer.print (F ("Baud rate: "));
     }
     uint32_t br = ESPCOM::baudRate(DEFAULT_PRINTER_PIPE);
-    ESPCOM::print (String (br).c_str(), output, espresponse);
+    writer.print (String (br).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"sleep_mode\":\""), output, espresponse);
+        writer.print (F ("\"sleep_mode\":\""));
     } else {
-        ESPCOM::print (F ("Sleep mode: "), output, espresponse);
+        writer.print (F ("Sleep mode: "));
     }
 #ifdef ARDUINO_ARCH_ESP32
     wifi_ps_type_t ps_type;
@@ -1104,30 +1040,30 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
     ps_type = WiFi.getSleepMode();
 #endif
     if (ps_type == WIFI_NONE_SLEEP) {
-        ESPCOM::print (F ("None"), output, espresponse);
+        writer.print (F ("None"));
     } else if (ps_type == WIFI_LIGHT_SLEEP) {
-        ESPCOM::print (F ("Light"), output, espresponse);
+        writer.print (F ("Light"));
     } else if (ps_type == WIFI_MODEM_SLEEP) {
-        ESPCOM::print (F ("Modem"), output, espresponse);
+        writer.print (F ("Modem"));
     } else {
-        ESPCOM::print (F ("???"), output, espresponse);
+        writer.print (F ("???"));
     }
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"channel\":\""), output, espresponse);
+        writer.print (F ("\"channel\":\""));
     } else {
-        ESPCOM::print (F ("Channel: "), output, espresponse);
+        writer.print (F ("Channel: "));
     }
-    ESPCOM::print (String (WiFi.channel() ).c_str(), output, espresponse);
+    writer.print (String (WiFi.channel() ).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #ifdef ARDUINO_ARCH_ESP32
     uint8_t PhyMode;
@@ -1140,139 +1076,139 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
     WiFiPhyMode_t PhyMode = WiFi.getPhyMode();
 #endif
     if (!plaintext) {
-        ESPCOM::print (F ("\"phy_mode\":\""), output, espresponse);
+        writer.print (F ("\"phy_mode\":\""));
     } else {
-        ESPCOM::print (F ("Phy Mode: "), output, espresponse);
+        writer.print (F ("Phy Mode: "));
     }
     if (PhyMode == (WIFI_PHY_MODE_11G) ) {
-        ESPCOM::print (F ("11g"), output, espresponse);
+        writer.print (F ("11g"));
     } else if (PhyMode == (WIFI_PHY_MODE_11B) ) {
-        ESPCOM::print (F ("11b"), output, espresponse);
+        writer.print (F ("11b"));
     } else if (PhyMode == (WIFI_PHY_MODE_11N) ) {
-        ESPCOM::print (F ("11n"), output, espresponse);
+        writer.print (F ("11n"));
     } else {
-        ESPCOM::print (F ("???"), output, espresponse);
+        writer.print (F ("???"));
     }
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"web_port\":\""), output, espresponse);
+        writer.print (F ("\"web_port\":\""));
     } else {
-        ESPCOM::print (F ("Web port: "), output, espresponse);
+        writer.print (F ("Web port: "));
     }
-    ESPCOM::print (String (wifi_config.iweb_port).c_str(), output, espresponse);
+    writer.print (String (wifi_config.iweb_port).c_str());
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"data_port\":\""), output, espresponse);
+        writer.print (F ("\"data_port\":\""));
     } else {
-        ESPCOM::print (F ("Data port: "), output, espresponse);
+        writer.print (F ("Data port: "));
     }
 #ifdef TCP_IP_DATA_FEATURE
-    ESPCOM::print (String (wifi_config.idata_port).c_str(), output, espresponse);
+    writer.print (String (wifi_config.idata_port).c_str());
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext) {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (WiFi.getMode() == WIFI_STA || WiFi.getMode() == WIFI_AP_STA) {
         if (!plaintext) {
-            ESPCOM::print (F ("\"hostname\":\""), output, espresponse);
+            writer.print (F ("\"hostname\":\""));
         } else {
-            ESPCOM::print (F ("Hostname: "), output, espresponse);
+            writer.print (F ("Hostname: "));
         }
 #ifdef ARDUINO_ARCH_ESP32
-        ESPCOM::print (WiFi.getHostname(), output, espresponse);
+        writer.print (WiFi.getHostname());
 #else
-        ESPCOM::print (WiFi.hostname().c_str(), output, espresponse);
+        writer.print (WiFi.hostname().c_str());
 #endif
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
     }
 
     if (!plaintext) {
-        ESPCOM::print (F ("\"active_mode\":\""), output, espresponse);
+        writer.print (F ("\"active_mode\":\""));
     } else {
-        ESPCOM::print (F ("Active Mode: "), output, espresponse);
+        writer.print (F ("Active Mode: "));
     }
     if (WiFi.getMode() == WIFI_STA) {
-        ESPCOM::print (F ("STA ("), output, espresponse);
-        ESPCOM::print (WiFi.macAddress().c_str(), output, espresponse);
-        ESPCOM::print (F (")"), output, espresponse);
+        writer.print (F ("STA ("));
+        writer.print (WiFi.macAddress().c_str());
+        writer.print (F (")"));
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
         if (WiFi.isConnected() ) {
             if (!plaintext) {
-                ESPCOM::print (F ("\"connected_ssid\":\""), output, espresponse);
+                writer.print (F ("\"connected_ssid\":\""));
             } else {
-                ESPCOM::print (F ("Connected to: "), output, espresponse);
+                writer.print (F ("Connected to: "));
             }
-            ESPCOM::print (WiFi.SSID().c_str(), output, espresponse);
+            writer.print (WiFi.SSID().c_str());
             if (!plaintext) {
-                ESPCOM::print (F ("\","), output, espresponse);
+                writer.print (F ("\","));
             } else {
-                ESPCOM::print (F ("\n"), output, espresponse);
+                writer.print (F ("\n"));
             }
             if (!plaintext) {
-                ESPCOM::print (F ("\"connected_signal\":\""), output, espresponse);
+                writer.print (F ("\"connected_signal\":\""));
             } else {
-                ESPCOM::print (F ("Signal: "), output, espresponse);
+                writer.print (F ("Signal: "));
             }
-            ESPCOM::print (String (wifi_config.getSignal (WiFi.RSSI() ) ).c_str(), output, espresponse);
-            ESPCOM::print (F ("%"), output, espresponse);
+            writer.print (String (wifi_config.getSignal (WiFi.RSSI() ) ).c_str());
+            writer.print (F ("%"));
             if (!plaintext) {
-                ESPCOM::print (F ("\","), output, espresponse);
+                writer.print (F ("\","));
             } else {
-                ESPCOM::print (F ("\n"), output, espresponse);
+                writer.print (F ("\n"));
             }
         } else {
             if (!plaintext) {
-                ESPCOM::print (F ("\"connection_status\":\""), output, espresponse);
+                writer.print (F ("\"connection_status\":\""));
             } else {
-                ESPCOM::print (F ("Connection Status: "), output, espresponse);
+                writer.print (F ("Connection Status: "));
             }
-            ESPCOM::print (F ("Connection Status: "), output, espresponse);
+            writer.print (F ("Connection Status: "));
             if (WiFi.status() == WL_DISCONNECTED) {
-                ESPCOM::print (F ("Disconnected"), output, espresponse);
+                writer.print (F ("Disconnected"));
             } else if (WiFi.status() == WL_CONNECTION_LOST) {
-                ESPCOM::print (F ("Connection lost"), output, espresponse);
+                writer.print (F ("Connection lost"));
             } else if (WiFi.status() == WL_CONNECT_FAILED) {
-                ESPCOM::print (F ("Connection failed"), output, espresponse);
+                writer.print (F ("Connection failed"));
             } else if (WiFi.status() == WL_NO_SSID_AVAIL) {
-                ESPCOM::print (F ("No connection"), output, espresponse);
+                writer.print (F ("No connection"));
             } else if (WiFi.status() == WL_IDLE_STATUS   ) {
-                ESPCOM::print (F ("Idle"), output, espresponse);
+                writer.print (F ("Idle"));
             } else {
-                ESPCOM::print (F ("Unknown"), output, espresponse);
+                writer.print (F ("Unknown"));
             }
             if (!plaintext) {
-                ESPCOM::print (F ("\","), output, espresponse);
+                writer.print (F ("\","));
             } else {
-                ESPCOM::print (F ("\n"), output, espresponse);
+                writer.print (F ("\n"));
             }
         }
         if (!plaintext) {
-            ESPCOM::print (F ("\"ip_mode\":\""), output, espresponse);
+            writer.print (F ("\"ip_mode\":\""));
         } else {
-            ESPCOM::print (F ("IP Mode: "), output, espresponse);
+            writer.print (F ("IP Mode: "));
         }
 #ifdef ARDUINO_ARCH_ESP32
         tcpip_adapter_dhcp_status_t dhcp_status;
@@ -1282,86 +1218,86 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
         if (wifi_station_dhcpc_status() == DHCP_STARTED)
 #endif
         {
-            ESPCOM::print (F ("DHCP"), output, espresponse);
+            writer.print (F ("DHCP"));
         } else {
-            ESPCOM::print (F ("Static"), output, espresponse);
+            writer.print (F ("Static"));
         }
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"ip\":\""), output, espresponse);
+            writer.print (F ("\"ip\":\""));
         } else {
-            ESPCOM::print (F ("IP: "), output, espresponse);
+            writer.print (F ("IP: "));
         }
-        ESPCOM::print (WiFi.localIP().toString().c_str(), output, espresponse);
+        writer.print (WiFi.localIP().toString().c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"gw\":\""), output, espresponse);
+            writer.print (F ("\"gw\":\""));
         } else {
-            ESPCOM::print (F ("Gateway: "), output, espresponse);
+            writer.print (F ("Gateway: "));
         }
-        ESPCOM::print (WiFi.gatewayIP().toString().c_str(), output, espresponse);
+        writer.print (WiFi.gatewayIP().toString().c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"msk\":\""), output, espresponse);
+            writer.print (F ("\"msk\":\""));
         } else {
-            ESPCOM::print (F ("Mask: "), output, espresponse);
+            writer.print (F ("Mask: "));
         }
-        ESPCOM::print (WiFi.subnetMask().toString().c_str(), output, espresponse);
+        writer.print (WiFi.subnetMask().toString().c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"dns\":\""), output, espresponse);
+            writer.print (F ("\"dns\":\""));
         } else {
-            ESPCOM::print (F ("DNS: "), output, espresponse);
+            writer.print (F ("DNS: "));
         }
-        ESPCOM::print (WiFi.dnsIP().toString().c_str(), output, espresponse);
+        writer.print (WiFi.dnsIP().toString().c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"disabled_mode\":\""), output, espresponse);
+            writer.print (F ("\"disabled_mode\":\""));
         } else {
-            ESPCOM::print (F ("Disabled Mode: "), output, espresponse);
+            writer.print (F ("Disabled Mode: "));
         }
-        ESPCOM::print (F ("AP ("), output, espresponse);
-        ESPCOM::print (WiFi.softAPmacAddress().c_str(), output, espresponse);
-        ESPCOM::print (F (")"), output, espresponse);
+        writer.print (F ("AP ("));
+        writer.print (WiFi.softAPmacAddress().c_str());
+        writer.print (F (")"));
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
     } else if (WiFi.getMode() == WIFI_AP) {
-        ESPCOM::print (F ("AP ("), output, espresponse);
-        ESPCOM::print (WiFi.softAPmacAddress().c_str(), output, espresponse);
-        ESPCOM::print (F (")"), output, espresponse);
+        writer.print (F ("AP ("));
+        writer.print (WiFi.softAPmacAddress().c_str());
+        writer.print (F (")"));
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         //get current config
@@ -1377,71 +1313,71 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
         wifi_softap_get_config (&apconfig);
 #endif
         if (!plaintext) {
-            ESPCOM::print (F ("\"ap_ssid\":\""), output, espresponse);
+            writer.print (F ("\"ap_ssid\":\""));
         } else {
-            ESPCOM::print (F ("SSID: "), output, espresponse);
+            writer.print (F ("SSID: "));
         }
 #ifdef ARDUINO_ARCH_ESP32
-        ESPCOM::print ( (const char*) conf.ap.ssid, output, espresponse);
+        writer.print ( (const char*) conf.ap.ssid);
 #else
-        ESPCOM::print ( (const char*) apconfig.ssid, output, espresponse);
+        writer.print ( (const char*) apconfig.ssid);
 #endif
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"ssid_visible\":\""), output, espresponse);
+            writer.print (F ("\"ssid_visible\":\""));
         } else {
-            ESPCOM::print (F ("Visible: "), output, espresponse);
+            writer.print (F ("Visible: "));
         }
-        ESPCOM::print ( (apconfig.ssid_hidden == 0) ? F ("Yes") : F ("No"), output, espresponse);
+        writer.print ( (apconfig.ssid_hidden == 0) ? F ("Yes") : F ("No"));
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"ssid_authentication\":\""), output, espresponse);
+            writer.print (F ("\"ssid_authentication\":\""));
         } else {
-            ESPCOM::print (F ("Authentication: "), output, espresponse);
+            writer.print (F ("Authentication: "));
         }
         if (apconfig.authmode == AUTH_OPEN) {
-            ESPCOM::print (F ("None"), output, espresponse);
+            writer.print (F ("None"));
         } else if (apconfig.authmode == AUTH_WEP) {
-            ESPCOM::print (F ("WEP"), output, espresponse);
+            writer.print (F ("WEP"));
         } else if (apconfig.authmode == AUTH_WPA_PSK) {
-            ESPCOM::print (F ("WPA"), output, espresponse);
+            writer.print (F ("WPA"));
         } else if (apconfig.authmode == AUTH_WPA2_PSK) {
-            ESPCOM::print (F ("WPA2"), output, espresponse);
+            writer.print (F ("WPA2"));
         } else {
-            ESPCOM::print (F ("WPA/WPA2"), output, espresponse);
+            writer.print (F ("WPA/WPA2"));
         }
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"ssid_max_connections\":\""), output, espresponse);
+            writer.print (F ("\"ssid_max_connections\":\""));
         } else {
-            ESPCOM::print (F ("Max Connections: "), output, espresponse);
+            writer.print (F ("Max Connections: "));
         }
-        ESPCOM::print (String (apconfig.max_connection).c_str(), output, espresponse);
+        writer.print (String (apconfig.max_connection).c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"ssid_dhcp\":\""), output, espresponse);
+            writer.print (F ("\"ssid_dhcp\":\""));
         } else {
-            ESPCOM::print (F ("DHCP Server: "), output, espresponse);
+            writer.print (F ("DHCP Server: "));
         }
 #ifdef ARDUINO_ARCH_ESP32
         tcpip_adapter_dhcp_status_t dhcp_status;
@@ -1451,26 +1387,26 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
         if (wifi_softap_dhcps_status() == DHCP_STARTED)
 #endif
         {
-            ESPCOM::print (F ("Started"), output, espresponse);
+            writer.print (F ("Started"));
         } else {
-            ESPCOM::print (F ("Stopped"), output, espresponse);
+            writer.print (F ("Stopped"));
         }
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"ip\":\""), output, espresponse);
+            writer.print (F ("\"ip\":\""));
         } else {
-            ESPCOM::print (F ("IP: "), output, espresponse);
+            writer.print (F ("IP: "));
         }
-        ESPCOM::print (WiFi.softAPIP().toString().c_str(), output, espresponse);
+        writer.print (WiFi.softAPIP().toString().c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 #ifdef ARDUINO_ARCH_ESP32
         tcpip_adapter_ip_info_t ip;
@@ -1480,34 +1416,34 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
         wifi_get_ip_info (SOFTAP_IF, &ip);
 #endif
         if (!plaintext) {
-            ESPCOM::print (F ("\"gw\":\""), output, espresponse);
+            writer.print (F ("\"gw\":\""));
         } else {
-            ESPCOM::print (F ("Gateway: "), output, espresponse);
+            writer.print (F ("Gateway: "));
         }
-        ESPCOM::print (IPAddress (ip.gw.addr).toString().c_str(), output, espresponse);
+        writer.print (IPAddress (ip.gw.addr).toString().c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"msk\":\""), output, espresponse);
+            writer.print (F ("\"msk\":\""));
         } else {
-            ESPCOM::print (F ("Mask: "), output, espresponse);
+            writer.print (F ("Mask: "));
         }
-        ESPCOM::print (IPAddress (ip.netmask.addr).toString().c_str(), output, espresponse);
+        writer.print (IPAddress (ip.netmask.addr).toString().c_str());
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"connected_clients\":["), output, espresponse);
+            writer.print (F ("\"connected_clients\":["));
         } else {
-            ESPCOM::print (F ("Connected clients: "), output, espresponse);
+            writer.print (F ("Connected clients: "));
         }
         int client_counter = 0;
 #ifdef ARDUINO_ARCH_ESP32
@@ -1567,265 +1503,265 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
         wifi_softap_free_station_info();
 #endif
         if (!plaintext) {
-            ESPCOM::print (stmp.c_str(), output, espresponse);
-            ESPCOM::print (F ("],"), output, espresponse);
+            writer.print (stmp.c_str());
+            writer.print (F ("],"));
         } else {
             //display number of client
-            ESPCOM::println (String (client_counter).c_str(), output, espresponse);
+            writer.println (String (client_counter).c_str());
             //display list if any
             if (stmp.length() > 0) {
-                ESPCOM::println (stmp.c_str(), output, espresponse);
+                writer.println (stmp.c_str());
             }
         }
 
         if (!plaintext) {
-            ESPCOM::print (F ("\"disabled_mode\":\""), output, espresponse);
+            writer.print (F ("\"disabled_mode\":\""));
         } else {
-            ESPCOM::print (F ("Disabled Mode: "), output, espresponse);
+            writer.print (F ("Disabled Mode: "));
         }
-        ESPCOM::print (F ("STA ("), output, espresponse);
-        ESPCOM::print (WiFi.macAddress().c_str(), output, espresponse);
-        ESPCOM::print (F (") is disabled"), output, espresponse);
+        writer.print (F ("STA ("));
+        writer.print (WiFi.macAddress().c_str());
+        writer.print (F (") is disabled"));
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
 
     } else if (WiFi.getMode() == WIFI_AP_STA)
     {
-        ESPCOM::print (F ("Mixed"), output, espresponse);
+        writer.print (F ("Mixed"));
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
         if (!plaintext) {
-            ESPCOM::print (F ("\"active_mode\":\""), output, espresponse);
+            writer.print (F ("\"active_mode\":\""));
         } else {
-            ESPCOM::print (F ("Active Mode: "), output, espresponse);
-        }
-        ESPCOM::print (F ("AP ("), output, espresponse);
-        ESPCOM::print (WiFi.softAPmacAddress().c_str(), output, espresponse);
-        ESPCOM::println (F (")"), output, espresponse);
-        ESPCOM::print (F ("STA ("), output, espresponse);
-        ESPCOM::print (WiFi.macAddress().c_str(), output, espresponse);
-        ESPCOM::print (F (")"), output, espresponse);
+            writer.print (F ("Active Mode: "));
+        }
+        writer.print (F ("AP ("));
+        writer.print (WiFi.softAPmacAddress().c_str());
+        writer.println (F (")"));
+        writer.print (F ("STA ("));
+        writer.print (WiFi.macAddress().c_str());
+        writer.print (F (")"));
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
     } else
     {
-        ESPCOM::print ("Wifi Off", output, espresponse);
+        writer.print ("Wifi Off");
         if (!plaintext) {
-            ESPCOM::print (F ("\","), output, espresponse);
+            writer.print (F ("\","));
         } else {
-            ESPCOM::print (F ("\n"), output, espresponse);
+            writer.print (F ("\n"));
         }
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"captive_portal\":\""), output, espresponse);
+        writer.print (F ("\"captive_portal\":\""));
     } else
     {
-        ESPCOM::print (F ("Captive portal: "), output, espresponse);
+        writer.print (F ("Captive portal: "));
     }
 #ifdef CAPTIVE_PORTAL_FEATURE
-    ESPCOM::print (F ("Enabled"), output, espresponse);
+    writer.print (F ("Enabled"));
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"ssdp\":\""), output, espresponse);
+        writer.print (F ("\"ssdp\":\""));
     } else
     {
-        ESPCOM::print (F ("SSDP: "), output, espresponse);
+        writer.print (F ("SSDP: "));
     }
 #ifdef SSDP_FEATURE
-    ESPCOM::print (F ("Enabled"), output, espresponse);
+    writer.print (F ("Enabled"));
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"netbios\":\""), output, espresponse);
+        writer.print (F ("\"netbios\":\""));
     } else
     {
-        ESPCOM::print (F ("NetBios: "), output, espresponse);
+        writer.print (F ("NetBios: "));
     }
 #ifdef NETBIOS_FEATURE
-    ESPCOM::print (F ("Enabled"), output, espresponse);
+    writer.print (F ("Enabled"));
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"mdns\":\""), output, espresponse);
+        writer.print (F ("\"mdns\":\""));
     } else
     {
-        ESPCOM::print (F ("mDNS: "), output, espresponse);
+        writer.print (F ("mDNS: "));
     }
 #ifdef MDNS_FEATURE
-    ESPCOM::print (F ("Enabled"), output, espresponse);
+    writer.print (F ("Enabled"));
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"web_update\":\""), output, espresponse);
+        writer.print (F ("\"web_update\":\""));
     } else
     {
-        ESPCOM::print (F ("Web Update: "), output, espresponse);
+        writer.print (F ("Web Update: "));
     }
 #ifdef WEB_UPDATE_FEATURE
-    ESPCOM::print (F ("Enabled"), output, espresponse);
+    writer.print (F ("Enabled"));
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"pin recovery\":\""), output, espresponse);
+        writer.print (F ("\"pin recovery\":\""));
     } else
     {
-        ESPCOM::print (F ("Pin Recovery: "), output, espresponse);
+        writer.print (F ("Pin Recovery: "));
     }
 #ifdef RECOVERY_FEATURE
-    ESPCOM::print (F ("Enabled"), output, espresponse);
+    writer.print (F ("Enabled"));
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"autentication\":\""), output, espresponse);
+        writer.print (F ("\"autentication\":\""));
     } else
     {
-        ESPCOM::print (F ("Authentication: "), output, espresponse);
+        writer.print (F ("Authentication: "));
     }
 #ifdef AUTHENTICATION_FEATURE
-    ESPCOM::print (F ("Enabled"), output, espresponse);
+    writer.print (F ("Enabled"));
 #else
-    ESPCOM::print (F ("Disabled"), output, espresponse);
+    writer.print (F ("Disabled"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"target_fw\":\""), output, espresponse);
+        writer.print (F ("\"target_fw\":\""));
     } else
     {
-        ESPCOM::print (F ("Target Firmware: "), output, espresponse);
+        writer.print (F ("Target Firmware: "));
     }
-    ESPCOM::print (CONFIG::GetFirmwareTargetName(), output, espresponse);
+    writer.print (CONFIG::GetFirmwareTargetName());
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
     //flag M117
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"M117_output\":\""), output, espresponse);
+        writer.print (F ("\"M117_output\":\""));
     } else
     {
-        ESPCOM::print (F ("M117 output: "), output, espresponse);
+        writer.print (F ("M117 output: "));
     }
     if (!CONFIG::is_locked(FLAG_BLOCK_M117))
     {
-        ESPCOM::print (F ("Enabled"), output, espresponse);
+        writer.print (F ("Enabled"));
     } else
     {
-        ESPCOM::print (F ("Disabled"), output, espresponse);
+        writer.print (F ("Disabled"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #ifdef NOTIFICATION_FEATURE
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"Notifications\":\""), output, espresponse);
+        writer.print (F ("\"Notifications\":\""));
     } else
     {
-        ESPCOM::print (F ("Notifications: "), output, espresponse);
+        writer.print (F ("Notifications: "));
     }
     if (notificationsservice.started())
     {
-        ESPCOM::print (notificationsservice.getTypeString(), output, espresponse);
+        writer.print (notificationsservice.getTypeString());
     } else
     {
-        ESPCOM::print (F ("Disabled"), output, espresponse);
+        writer.print (F ("Disabled"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #endif
 
@@ -1833,158 +1769,216 @@ void CONFIG::print_config (tpipe output, bool plaintext, ESPResponseStream  *esp
 #ifdef ESP_OLED_FEATURE
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"Oled_output\":\""), output, espresponse);
+        writer.print (F ("\"Oled_output\":\""));
     } else
     {
-        ESPCOM::print (F ("Oled output: "), output, espresponse);
+        writer.print (F ("Oled output: "));
     }
     if (!CONFIG::is_locked(FLAG_BLOCK_OLED))
     {
-        ESPCOM::print (F ("Enabled"), output, espresponse);
+        writer.print (F ("Enabled"));
     } else
     {
-        ESPCOM::print (F ("Disabled"), output, espresponse);
+        writer.print (F ("Disabled"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #endif
 
     //flag serial
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"Serial_output\":\""), output, espresponse);
+        writer.print (F ("\"Serial_output\":\""));
     } else
     {
-        ESPCOM::print (F ("Serial output: "), output, espresponse);
+        writer.print (F ("Serial output: "));
     }
     if (!CONFIG::is_locked(FLAG_BLOCK_SERIAL))
     {
-        ESPCOM::print (F ("Enabled"), output, espresponse);
+        writer.print (F ("Enabled"));
     } else
     {
-        ESPCOM::print (F ("Disabled"), output, espresponse);
+        writer.print (F ("Disabled"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 
 #ifdef WS_DATA_FEATURE
     //flag websocket
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"Websocket_output\":\""), output, espresponse);
+        writer.print (F ("\"Websocket_output\":\""));
     } else
     {
-        ESPCOM::print (F ("Web socket  output: "), output, espresponse);
+        writer.print (F ("Web socket  output: "));
     }
     if (!CONFIG::is_locked(FLAG_BLOCK_WSOCKET))
     {
-        ESPCOM::print (F ("Enabled"), output, espresponse);
+        writer.print (F ("Enabled"));
     } else
     {
-        ESPCOM::print (F ("Disabled"), output, espresponse);
+        writer.print (F ("Disabled"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 #endif
 #ifdef TCP_IP_DATA_FEATURE
     //flag tcp
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"TCP_output\":\""), output, espresponse);
+        writer.print (F ("\"TCP_output\":\""));
     } else
     {
-        ESPCOM::print (F ("TCP output: "), output, espresponse);
+        writer.print (F ("TCP output: "));
     }
     if (!CONFIG::is_locked(FLAG_BLOCK_TCP))
     {
-        ESPCOM::print (F ("Enabled"), output, espresponse);
+        writer.print (F ("Enabled"));
     } else
     {
-        ESPCOM::print (F ("Disabled"), output, espresponse);
+        writer.print (F ("Disabled"));
     }
 
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
+    } else
+    {
+        writer.print (F ("\n"));
+    }
+#endif
+    //settings store
+    if (!plaintext)
+    {
+        writer.print (F ("\"settings_store\":\""));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("Settings store: "));
+    }
+    writer.print (F ("flash reads saved "));
+    writer.print (String ((ram_accesses > 0) ? (ram_accesses - 1) : 0).c_str());
+    writer.print (F (", flash writes saved "));
+    writer.print (String ((ram_writes > flash_commits) ? (ram_writes - flash_commits) : 0).c_str());
+    writer.print (F (", commits "));
+    writer.print (String (flash_commits).c_str());
+    if (dirty_start != -1) {
+        writer.print (F (", pending"));
+    }
+#ifdef CONFIG_JOURNAL_FEATURE
+    if (CONFIG_JOURNAL::started()) {
+        writer.print (F (", journal "));
+        writer.print (CONFIG::formatBytes (CONFIG_JOURNAL::size()).c_str());
+        writer.print (F (", appends "));
+        writer.print (String (CONFIG_JOURNAL::appends()).c_str());
+        writer.print (F (", compactions "));
+        writer.print (String (CONFIG_JOURNAL::compactions()).c_str());
     }
 #endif
+    if (!plaintext)
+    {
+        writer.print (F ("\","));
+    } else
+    {
+        writer.print (F ("\n"));
+    }
+
 #ifdef DEBUG_ESP3D
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"debug\":\""), output, espresponse);
+        writer.print (F ("\"debug\":\""));
     } else
     {
-        ESPCOM::print (F ("Debug: "), output, espresponse);
+        writer.print (F ("Debug: "));
     }
-    ESPCOM::print (F ("Debug Enabled :"), output, espresponse);
+    writer.print (F ("Debug Enabled :"));
 #ifdef DEBUG_OUTPUT_SPIFFS
-    ESPCOM::print (F ("SPIFFS"), output, espresponse);
+    writer.print (F ("SPIFFS"));
 #endif
 #ifdef DEBUG_OUTPUT_SD
-    ESPCOM::print (F ("SD"), output, espresponse);
+    writer.print (F ("SD"));
 #endif
 #ifdef DEBUG_OUTPUT_SERIAL
-    ESPCOM::print (F ("serial"), output, espresponse);
+    writer.print (F ("serial"));
 #endif
 #ifdef DEBUG_OUTPUT_TCP
-    ESPCOM::print (F ("TCP"), output, espresponse);
+    writer.print (F ("TCP"));
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\","), output, espresponse);
+        writer.print (F ("\","));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
+    }
+#endif
+#ifndef USE_AS_UPDATER_ONLY
+    //last grbl status report
+    if ((CONFIG::GetFirmwareTarget() == GRBL) && (GRBLCOM::status.last_update != 0)) {
+        if (!plaintext) {
+            writer.print (F ("\"machine\":\""));
+        } else {
+            writer.print (F ("Machine: "));
+        }
+        writer.print (GRBLCOM::status.state);
+        writer.print (F (" WPos:"));
+        for (uint8_t i = 0; i < GRBL_AXIS_NB; i++) {
+            if (i > 0) {
+                writer.print (F (","));
+            }
+            writer.print (String (GRBLCOM::status.wpos[i], 3).c_str());
+        }
+        writer.print (F (" F:"));
+        writer.print (String (GRBLCOM::status.feed, 0).c_str());
+        if (!plaintext) {
+            writer.print (F ("\","));
+        } else {
+            writer.print (F ("\n"));
+        }
     }
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"fw\":\""), output, espresponse);
+        writer.print (F ("\"fw\":\""));
     } else
     {
-        ESPCOM::print (F ("FW version: "), output, espresponse);
+        writer.print (F ("FW version: "));
     }
-    ESPCOM::print (FW_VERSION, output, espresponse);
+    writer.print (FW_VERSION);
 #ifdef ARDUINO_ARCH_ESP8266
-    ESPCOM::print (" ESP8266/8586", output, espresponse);
+    writer.print (" ESP8266/8586");
 #else
-    ESPCOM::print (" ESP32", output, espresponse);
+    writer.print (" ESP32");
 #endif
     if (!plaintext)
     {
-        ESPCOM::print (F ("\"}"), output, espresponse);
+        writer.print (F ("\"}"));
     } else
     {
-        ESPCOM::print (F ("\n"), output, espresponse);
+        writer.print (F ("\n"));
     }
 }
 
 #ifdef DEBUG_OUTPUT_SOCKET
 #if defined(ARDUINO_ARCH_ESP8266)
-#define NODEBUG_WEBSOCKETS
-#include <WebSocketsServer.h>
-extern WebSocketsServer * socket_server;
+#include "syncwebserver.h"
 const char * pathToFileName(const char * path)
 {
     size_t i = 0;
@@ -93,15 +93,31 @@
 
 //TIMESTAMP_FEATURE: Time stamp feature on direct SD  files
 //#define TIMESTAMP_FEATURE
+
+//CONFIG_JOURNAL_FEATURE: save settings changes in a crc protected journal on SPIFFS instead of rewriting EEPROM sector
+//warning: settings are lost if SPIFFS is erased by a SPIFFS image update
+//#define CONFIG_JOURNAL_FEATURE
+
+//FS_INDEX_FEATURE: keep SPIFFS files list in RAM so web listing does not scan all SPIFFS
+#define FS_INDEX_FEATURE
 #endif //USE_AS_UPDATER_ONLY
 //Extra features /////////////////////////////////////////////////////////////////////////
 
 //Workaround for Marlin 2.X coldstart
 //#define DISABLE_CONNECTING_MSG
 
+//Cache-Control of web files from SPIFFS, browser checks ETag and gets 304 if file did not change
+#define WEB_CACHE_CONTROL "no-cache"
+//files with content hash in name (name.<8 hex digits or more>.ext) never change
+#define WEB_CACHE_CONTROL_FINGERPRINT "max-age=31536000, immutable"
+
 //Serial rx buffer size is 256 but can be extended
 #define SERIAL_RX_BUFFER_SIZE 512
 
+//Serial data are copied once in a ring read by tcp, websocket and commands parser
+//size must be a power of 2
+#define SERIAL_RX_RING_SIZE 1024
+
 //Serial Parameters
 #define ESP_SERIAL_PARAM SERIAL_8N1
 
@@ -159,6 +175,8 @@
 //#define DEBUG_OUTPUT_SERIAL
 //#define DEBUG_OUTPUT_TCP
 //#define DEBUG_OUTPUT_SOCKET
+//compare SPIFFS index with SPIFFS after each change and log differences
+//#define FS_INDEX_CHECK
 
 //Sanity check
 #ifndef SDCARD_FEATURE
@@ -175,7 +193,19 @@
 #endif
 
 //number of clients allowed to use data port at once
-#define MAX_SRV_CLIENTS 1
+//each client reads printer output at its own pace
+#define MAX_SRV_CLIENTS 4
+//client which cannot take printer output for this time (ms) is disconnected
+#define SRV_CLIENT_STALL_TIMEOUT 5000
+//size of block read from tcp client and sent to printer
+#define TCP_READ_BUFFER_SIZE 256
+//tcp data kept per client during upload while looking for emergency lines, sent to printer after
+#define TCP_HOLD_SIZE 128
+//number of websocket clients receiving printer output (sync webserver)
+#define MAX_WS_CLIENTS 5
+//bytes which can be written without blocking once lwip reports an esp32 socket writable
+//lwip only does it when at least TCP_SNDLOWAT (about 2.9KB) is free
+#define ESP32_WRITABLE_ROOM 1024
 
 #ifdef ARDUINO_ARCH_ESP32
 #include "FS.h"
@@ -333,7 +363,7 @@ typedef enum {
 #define EP_DHT_INTERVAL         164//4  bytes = int
 #define ESP_NOTIFICATION_TYPE   168     //1 byte = flag
 #define ESP_AUTO_NOTIFICATION   170//1  bytes = flag
-#define EP_FREE_BYTE1           171//1  bytes = flag
+#define EP_STREAM_WINDOW        171//1  bytes = flag
 #define EP_FREE_INT3            172//4  bytes = int
 #define EP_ADMIN_PWD            176//21  bytes 20+1 = string  ; warning does not support multibyte char like chinese
 #define EP_USER_PWD         197//21  bytes 20+1 = string  ; warning does not support multibyte char like chinese
@@ -402,6 +432,9 @@ const char DEFAULT_TIME_SERVER3 []  PROGMEM =   "0.pool.ntp.org";
 #define DEFAULT_OUTPUT_FLAG 0
 #define DEFAULT_DHT_TYPE 255
 const int DEFAULT_DHT_INTERVAL = 30;
+//lines sent to printer without waiting "ok", should match printer BUFSIZE
+#define DEFAULT_STREAM_WINDOW 4
+#define MAX_STREAM_WINDOW 7
 
 
 #define MIN_NOTIFICATION_TOKEN_LENGTH 0
@@ -438,50 +471,6 @@ const int DEFAULT_DHT_INTERVAL = 30;
 #define DEFAULT_SDREADER_SPEED 4
 #endif
 
-const uint16_t Setting[][2] = {
-    {EP_WIFI_MODE, LEVEL_ADMIN},//0
-    {EP_STA_SSID, LEVEL_ADMIN},//1
-    {EP_STA_PASSWORD, LEVEL_ADMIN},//2
-    {EP_STA_IP_MODE, LEVEL_ADMIN},//3
-    {EP_STA_IP_VALUE, LEVEL_ADMIN},//4
-    {EP_STA_MASK_VALUE, LEVEL_ADMIN},//5
-    {EP_STA_GATEWAY_VALUE, LEVEL_ADMIN},//6
-    {EP_BAUD_RATE, LEVEL_ADMIN},//7
-    {EP_STA_PHY_MODE, LEVEL_ADMIN},//8
-    {EP_SLEEP_MODE, LEVEL_ADMIN},//9
-    {EP_CHANNEL, LEVEL_ADMIN},//10
-    {EP_AUTH_TYPE, LEVEL_ADMIN},//11
-    {EP_SSID_VISIBLE, LEVEL_ADMIN},//12
-    {EP_WEB_PORT, LEVEL_ADMIN},//13
-    {EP_DATA_PORT, LEVEL_ADMIN},//14
-    {EP_HOSTNAME, LEVEL_ADMIN},//15
-    {EP_ADMIN_PWD, LEVEL_ADMIN},//16
-    {EP_USER_PWD, LEVEL_USER},//17
-    {EP_AP_SSID, LEVEL_ADMIN},//18
-    {EP_AP_PASSWORD, LEVEL_ADMIN},//19
-    {EP_AP_IP_VALUE, LEVEL_ADMIN},//20
-    {EP_AP_MASK_VALUE, LEVEL_ADMIN},//21
-    {EP_AP_GATEWAY_VALUE, LEVEL_ADMIN},//22
-    {EP_AP_IP_MODE, LEVEL_ADMIN},//23
-    {EP_AP_PHY_MODE, LEVEL_ADMIN},//24
-    {EP_TARGET_FW, LEVEL_USER},//25
-    {EP_TIMEZONE, LEVEL_USER},//26
-    {EP_TIME_ISDST, LEVEL_USER},//27
-    {EP_TIME_SERVER1, LEVEL_USER},//28
-    {EP_TIME_SERVER2, LEVEL_USER},//29
-    {EP_TIME_SERVER3, LEVEL_USER},//30
-    {EP_IS_DIRECT_SD, LEVEL_USER},//31
-    {EP_PRIMARY_SD, LEVEL_USER},//32
-    {EP_SECONDARY_SD, LEVEL_USER},//33
-    {EP_DIRECT_SD_CHECK, LEVEL_USER}, //34
-    {EP_SD_CHECK_UPDATE_AT_BOOT, LEVEL_USER},//35
-    {EP_OUTPUT_FLAG, LEVEL_USER},//36
-    {EP_DHT_INTERVAL, LEVEL_USER},//37
-    {EP_DHT_TYPE, LEVEL_USER},//38
-    {EP_SD_SPEED_DIV, LEVEL_USER}//39
-};
-#define AUTH_ENTRY_NB 40
-
 #define FLAG_BLOCK_M117 0x01
 #define FLAG_BLOCK_OLED 0x02
 #define FLAG_BLOCK_SERIAL 0x04
@@ -498,6 +487,8 @@ const uint16_t Setting[][2] = {
 
 //sizes
 #define EEPROM_SIZE             1024 //max is 1024
+//quiet time (ms) before pending settings are committed to flash
+#define CONFIG_COMMIT_DELAY     2000
 #define MAX_SSID_LENGTH             32
 #define MIN_SSID_LENGTH             1
 #define MAX_PASSWORD_LENGTH             64
@@ -560,6 +551,8 @@ public:
     static bool write_string (int pos, const __FlashStringHelper *str);
     static bool write_buffer (int pos, const byte * byte_buffer, int size_buffer);
     static bool write_byte (int pos, const byte value);
+    static bool commit_settings();
+    static void handle_settings();
     static bool reset_config();
     static void print_config (tpipe output, bool plaintext, ESPResponseStream  *espresponse = NULL);
     static bool SetFirmwareTarget (uint8_t fw);
@@ -591,6 +584,15 @@ public:
 #endif
 private:
     static uint8_t FirmwareTarget;
+    static bool eeprom_mapped;
+    static int dirty_start;
+    static int dirty_end;
+    static uint32_t last_write_time;
+    static uint32_t ram_accesses;
+    static uint32_t ram_writes;
+    static uint32_t flash_commits;
+    static void map_eeprom();
+    static void write_ram (int pos, byte value);
 };
 
 
@@ -0,0 +1,316 @@
+/*
+  configjournal.cpp - ESP3D settings journal class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifdef CONFIG_JOURNAL_FEATURE
+#include <EEPROM.h>
+#ifndef FS_NO_GLOBALS
+#define FS_NO_GLOBALS
+#endif
+#include <FS.h>
+#if defined(ARDUINO_ARCH_ESP32)
+#include "SPIFFS.h"
+#endif
+#include "configjournal.h"
+#include "fsindex.h"
+
+#define CONFIG_JOURNAL_CHUNK 32
+
+bool CONFIG_JOURNAL::_started = false;
+uint8_t CONFIG_JOURNAL::_active = 0;
+uint32_t CONFIG_JOURNAL::_seq = 0;
+uint32_t CONFIG_JOURNAL::_size = 0;
+uint32_t CONFIG_JOURNAL::_appends = 0;
+uint32_t CONFIG_JOURNAL::_compactions = 0;
+
+const char * CONFIG_JOURNAL::filename (uint8_t index)
+{
+    return (index == 0) ? "/config0.jnl" : "/config1.jnl";
+}
+
+bool CONFIG_JOURNAL::is_journal (const char * path)
+{
+    return (strcmp (path, filename (0)) == 0) || (strcmp (path, filename (1)) == 0);
+}
+
+//CRC-16/CCITT
+uint16_t CONFIG_JOURNAL::crc16 (uint16_t crc, const uint8_t * data, size_t len)
+{
+    while (len--) {
+        crc ^= (uint16_t) (*data++) << 8;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+//check a journal file, valid_size is the size of the part that can be replayed
+//file is valid only if it starts with a full snapshot
+bool CONFIG_JOURNAL::scan (uint8_t index, uint32_t & seq, uint32_t & valid_size, uint32_t & file_size)
+{
+    valid_size = 0;
+    file_size = 0;
+    if (!SPIFFS.exists (filename (index))) {
+        return false;
+    }
+    FS_FILE f = SPIFFS.open (filename (index), SPIFFS_FILE_READ);
+    if (!f) {
+        return false;
+    }
+    file_size = f.size();
+    uint8_t buf[CONFIG_JOURNAL_CHUNK];
+    if (f.read (buf, CONFIG_JOURNAL_HEADER_SIZE) != CONFIG_JOURNAL_HEADER_SIZE || buf[0] != CONFIG_JOURNAL_MAGIC
+            || crc16 (0xFFFF, buf, 5) != (uint16_t) (buf[5] | (buf[6] << 8))) {
+        f.close();
+        return false;
+    }
+    seq = buf[1] | (buf[2] << 8) | ((uint32_t) buf[3] << 16) | ((uint32_t) buf[4] << 24);
+    uint32_t offset = CONFIG_JOURNAL_HEADER_SIZE;
+    bool first = true;
+    while (offset + CONFIG_JOURNAL_RECORD_SIZE <= file_size) {
+        if (f.read (buf, 4) != 4) {
+            break;
+        }
+        uint16_t pos = buf[0] | (buf[1] << 8);
+        uint16_t len = buf[2] | (buf[3] << 8);
+        if (len == 0 || pos + len > EEPROM_SIZE || (first && (pos != 0 || len != EEPROM_SIZE))) {
+            break;
+        }
+        uint16_t crc = crc16 (0xFFFF, buf, 4);
+        uint16_t remaining = len;
+        while (remaining > 0) {
+            uint16_t n = (remaining > CONFIG_JOURNAL_CHUNK) ? CONFIG_JOURNAL_CHUNK : remaining;
+            if (f.read (buf, n) != n) {
+                break;
+            }
+            crc = crc16 (crc, buf, n);
+            remaining -= n;
+        }
+        if (remaining > 0 || f.read (buf, 2) != 2 || crc != (uint16_t) (buf[0] | (buf[1] << 8))) {
+            //torn record
+            break;
+        }
+        offset += CONFIG_JOURNAL_RECORD_SIZE + len;
+        valid_size = offset;
+        first = false;
+    }
+    f.close();
+    return !first;
+}
+
+//apply records of a checked journal to RAM image of settings
+void CONFIG_JOURNAL::replay (uint8_t index, uint32_t valid_size)
+{
+    FS_FILE f = SPIFFS.open (filename (index), SPIFFS_FILE_READ);
+    if (!f) {
+        return;
+    }
+    uint8_t buf[CONFIG_JOURNAL_CHUNK];
+    uint32_t offset = CONFIG_JOURNAL_HEADER_SIZE;
+    f.seek (offset, SeekSet);
+    while (offset < valid_size) {
+        f.read (buf, 4);
+        uint16_t pos = buf[0] | (buf[1] << 8);
+        uint16_t len = buf[2] | (buf[3] << 8);
+        uint16_t done = 0;
+        while (done < len) {
+            uint16_t n = ((len - done) > CONFIG_JOURNAL_CHUNK) ? CONFIG_JOURNAL_CHUNK : (len - done);
+            f.read (buf, n);
+            for (uint16_t i = 0; i < n; i++) {
+                EEPROM.write (pos + done + i, buf[i]);
+            }
+            done += n;
+        }
+        //skip crc
+        f.read (buf, 2);
+        offset += CONFIG_JOURNAL_RECORD_SIZE + len;
+    }
+    f.close();
+}
+
+//load latest valid journal over EEPROM image already in RAM
+//if there is none, current image becomes the first snapshot
+bool CONFIG_JOURNAL::begin()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (!SPIFFS.begin (true)) {
+#else
+    if (!SPIFFS.begin()) {
+#endif
+        LOG ("Journal: no SPIFFS\r\n")
+        return false;
+    }
+    uint32_t seq[2] = {0, 0};
+    uint32_t valid_size[2];
+    uint32_t file_size[2];
+    bool valid[2];
+    for (uint8_t i = 0; i < 2; i++) {
+        valid[i] = scan (i, seq[i], valid_size[i], file_size[i]);
+    }
+    //the most recent valid file wins, sequence can wrap
+    int8_t best = -1;
+    if (valid[0] && valid[1]) {
+        best = ((int32_t) (seq[1] - seq[0]) > 0) ? 1 : 0;
+    } else if (valid[0]) {
+        best = 0;
+    } else if (valid[1]) {
+        best = 1;
+    }
+    if (best == -1) {
+        LOG ("Journal: create\r\n")
+        _active = 1;
+        _seq = 0;
+        return compact();
+    }
+    replay (best, valid_size[best]);
+    _active = best;
+    _seq = seq[best];
+    _size = valid_size[best];
+    _started = true;
+    LOG ("Journal: loaded ")
+    LOG (String (_size))
+    LOG ("\r\n")
+    //a torn tail or an older file left by an interrupted compaction: start clean
+    if (valid_size[best] != file_size[best] || SPIFFS.exists (filename (best ^ 1))) {
+        return compact();
+    }
+    return true;
+}
+
+bool CONFIG_JOURNAL::started()
+{
+    return _started;
+}
+
+bool CONFIG_JOURNAL::write_record (FS_FILE & f, uint16_t pos, uint16_t len)
+{
+    uint8_t buf[CONFIG_JOURNAL_CHUNK];
+    buf[0] = pos & 0xFF;
+    buf[1] = pos >> 8;
+    buf[2] = len & 0xFF;
+    buf[3] = len >> 8;
+    uint16_t crc = crc16 (0xFFFF, buf, 4);
+    if (f.write (buf, 4) != 4) {
+        return false;
+    }
+    uint16_t done = 0;
+    while (done < len) {
+        uint16_t n = ((len - done) > CONFIG_JOURNAL_CHUNK) ? CONFIG_JOURNAL_CHUNK : (len - done);
+        for (uint16_t i = 0; i < n; i++) {
+            buf[i] = EEPROM.read (pos + done + i);
+        }
+        crc = crc16 (crc, buf, n);
+        if (f.write (buf, n) != n) {
+            return false;
+        }
+        done += n;
+    }
+    buf[0] = crc & 0xFF;
+    buf[1] = crc >> 8;
+    return (f.write (buf, 2) == 2);
+}
+
+//append a range of RAM image to active journal
+bool CONFIG_JOURNAL::append (int pos, int len)
+{
+    if (!_started || pos < 0 || len <= 0 || pos + len > EEPROM_SIZE) {
+        return false;
+    }
+    FS_FILE f = SPIFFS.open (filename (_active), "a");
+    if (!f) {
+        return false;
+    }
+    bool res = write_record (f, pos, len);
+    f.close();
+    FS_INDEX::update (filename (_active));
+    if (!res) {
+        LOG ("Journal: append failed\r\n")
+        //record may be torn, rewrite all in a new file
+        return compact();
+    }
+    _size += CONFIG_JOURNAL_RECORD_SIZE + len;
+    _appends++;
+    return true;
+}
+
+//write a snapshot of RAM image in the other file, then remove current one
+bool CONFIG_JOURNAL::compact()
+{
+    uint8_t next = _active ^ 1;
+    uint32_t next_seq = _seq + 1;
+    FS_FILE f = SPIFFS.open (filename (next), SPIFFS_FILE_WRITE);
+    if (!f) {
+        return false;
+    }
+    uint8_t header[CONFIG_JOURNAL_HEADER_SIZE];
+    header[0] = CONFIG_JOURNAL_MAGIC;
+    header[1] = next_seq & 0xFF;
+    header[2] = (next_seq >> 8) & 0xFF;
+    header[3] = (next_seq >> 16) & 0xFF;
+    header[4] = (next_seq >> 24) & 0xFF;
+    uint16_t crc = crc16 (0xFFFF, header, 5);
+    header[5] = crc & 0xFF;
+    header[6] = crc >> 8;
+    bool res = (f.write (header, CONFIG_JOURNAL_HEADER_SIZE) == CONFIG_JOURNAL_HEADER_SIZE) && write_record (f, 0, EEPROM_SIZE);
+    f.close();
+    //be sure snapshot is readable before dropping old file
+    uint32_t seq, valid_size, file_size;
+    if (!res || !scan (next, seq, valid_size, file_size) || seq != next_seq) {
+        LOG ("Journal: compaction failed\r\n")
+        SPIFFS.remove (filename (next));
+        FS_INDEX::update (filename (next));
+        return false;
+    }
+    SPIFFS.remove (filename (_active));
+    FS_INDEX::update (filename (next));
+    FS_INDEX::update (filename (_active));
+    _active = next;
+    _seq = next_seq;
+    _size = valid_size;
+    _started = true;
+    _compactions++;
+    return true;
+}
+
+//compact when journal is too big
+void CONFIG_JOURNAL::handle()
+{
+    if (_started && (_size > CONFIG_JOURNAL_MAX_SIZE)) {
+        compact();
+    }
+}
+
+uint32_t CONFIG_JOURNAL::size()
+{
+    return _size;
+}
+
+uint32_t CONFIG_JOURNAL::appends()
+{
+    return _appends;
+}
+
+uint32_t CONFIG_JOURNAL::compactions()
+{
+    return _compactions;
+}
+
+#endif
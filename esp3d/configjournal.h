@@ -0,0 +1,64 @@
+/*
+  configjournal.h - ESP3D settings journal class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef CONFIGJOURNAL_H
+#define CONFIGJOURNAL_H
+#include <Arduino.h>
+#include "config.h"
+
+//journal grows until this size then is compacted in a new file
+#define CONFIG_JOURNAL_MAX_SIZE 8192
+#define CONFIG_JOURNAL_MAGIC 0xC7
+//magic + sequence + crc
+#define CONFIG_JOURNAL_HEADER_SIZE 7
+//position + length + ... + crc
+#define CONFIG_JOURNAL_RECORD_SIZE 6
+
+//settings changes are appended to a SPIFFS file instead of rewriting EEPROM sector
+//file starts with a full snapshot of settings, each record has its own crc
+//a torn record (power loss) is ignored, compaction writes a new file before removing old one
+class CONFIG_JOURNAL
+{
+public:
+    static bool begin();
+    static bool started();
+    static bool append (int pos, int len);
+    static bool compact();
+    static void handle();
+    static uint32_t size();
+    static uint32_t appends();
+    static uint32_t compactions();
+    //journal files are not shown, served, removed or replaced by web file manager
+    static bool is_journal (const char * path);
+private:
+    static bool _started;
+    static uint8_t _active;
+    static uint32_t _seq;
+    static uint32_t _size;
+    static uint32_t _appends;
+    static uint32_t _compactions;
+    static const char * filename (uint8_t index);
+    static bool scan (uint8_t index, uint32_t & seq, uint32_t & valid_size, uint32_t & file_size);
+    static void replay (uint8_t index, uint32_t valid_size);
+    static bool write_record (FS_FILE & f, uint16_t pos, uint16_t len);
+    static uint16_t crc16 (uint16_t crc, const uint8_t * data, size_t len);
+};
+
+#endif
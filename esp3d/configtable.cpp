@@ -0,0 +1,371 @@
+/*
+  configtable.cpp - ESP3D settings table class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include "configtable.h"
+#include "wificonf.h"
+#ifdef DHT_FEATURE
+#include "DHTesp.h"
+#endif
+
+#define OPTIONS(o) (uint8_t) (sizeof (o) / sizeof (setting_option_t)), o
+#define NO_OPTIONS 0, NULL
+
+#ifdef AUTHENTICATION_FEATURE
+#define LOCAL_PWD_FLAGS SETTING_SECRET
+#else
+#define LOCAL_PWD_FLAGS (SETTING_SECRET | SETTING_HIDDEN)
+#endif
+
+const setting_option_t baud_options[] PROGMEM = {
+    {"9600", 9600}, {"19200", 19200}, {"38400", 38400}, {"57600", 57600}, {"115200", 115200},
+    {"230400", 230400}, {"250000", 250000}, {"500000", 500000}, {"921600", 921600}
+};
+const setting_option_t sleep_options[] PROGMEM = {
+    {"None", WIFI_NONE_SLEEP}, {"Light", WIFI_LIGHT_SLEEP}, {"Modem", WIFI_MODEM_SLEEP}
+};
+const setting_option_t wifi_mode_options[] PROGMEM = {{"AP", AP_MODE}, {"STA", CLIENT_MODE}};
+const setting_option_t sta_phy_options[] PROGMEM = {
+    {"11b", WIFI_PHY_MODE_11B}, {"11g", WIFI_PHY_MODE_11G}, {"11n", WIFI_PHY_MODE_11N}
+};
+const setting_option_t ap_phy_options[] PROGMEM = {{"11b", WIFI_PHY_MODE_11B}, {"11g", WIFI_PHY_MODE_11G}};
+const setting_option_t ip_mode_options[] PROGMEM = {{"DHCP", DHCP_MODE}, {"Static", STATIC_IP_MODE}};
+const setting_option_t yes_no_options[] PROGMEM = {{"No", 0}, {"Yes", 1}};
+const setting_option_t auth_options[] PROGMEM = {
+    {"Open", AUTH_OPEN}, {"WPA", AUTH_WPA_PSK}, {"WPA2", AUTH_WPA2_PSK}, {"WPA/WPA2", AUTH_WPA_WPA2_PSK}
+};
+#ifdef NOTIFICATION_FEATURE
+const setting_option_t notification_options[] PROGMEM = {
+    {"None", 0}, {"Pushover", ESP_PUSHOVER_NOTIFICATION}, {"Email", ESP_EMAIL_NOTIFICATION}, {"Line", ESP_LINE_NOTIFICATION}
+};
+#endif
+const setting_option_t target_fw_options[] PROGMEM = {
+    {"Repetier", REPETIER}, {"Repetier for Davinci", REPETIER4DV}, {"Marlin", MARLIN}, {"Marlin Kimbra", MARLINKIMBRA},
+    {"Smoothieware", SMOOTHIEWARE}, {"Grbl", GRBL}, {"Unknown", UNKNOWN_FW}
+};
+const setting_option_t output_flag_options[] PROGMEM = {
+    {"M117", FLAG_BLOCK_M117},
+#ifdef ESP_OLED_FEATURE
+    {"Oled", FLAG_BLOCK_OLED},
+#endif
+    {"Serial", FLAG_BLOCK_SERIAL},
+#ifdef WS_DATA_FEATURE
+    {"Web Socket", FLAG_BLOCK_WSOCKET},
+#endif
+#ifdef TCP_IP_DATA_FEATURE
+    {"TCP", FLAG_BLOCK_TCP},
+#endif
+};
+#ifdef DHT_FEATURE
+const setting_option_t dht_options[] PROGMEM = {
+    {"None", 255}, {"DHT11", DHTesp::DHT11}, {"DHT22", DHTesp::DHT22}, {"AM2302", DHTesp::RHT03}, {"RHT03", DHTesp::AM2302}
+};
+#endif
+
+//order is [ESP400] order
+const setting_t esp_settings[] PROGMEM = {
+    //network
+    {EP_BAUD_RATE, 'I', LEVEL_ADMIN, 0, 0, 0, DEFAULT_BAUD_RATE, NULL, OPTIONS (baud_options), "Baud Rate"},
+    {EP_SLEEP_MODE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_SLEEP_MODE, NULL, OPTIONS (sleep_options), "Sleep Mode"},
+    {EP_WEB_PORT, 'I', LEVEL_ADMIN, 0, DEFAULT_MIN_WEB_PORT, DEFAULT_MAX_WEB_PORT, DEFAULT_WEB_PORT, NULL, NO_OPTIONS, "Web Port"},
+    {EP_DATA_PORT, 'I', LEVEL_ADMIN, 0, DEFAULT_MIN_DATA_PORT, DEFAULT_MAX_DATA_PORT, DEFAULT_DATA_PORT, NULL, NO_OPTIONS, "Data Port"},
+    {EP_ADMIN_PWD, 'S', LEVEL_ADMIN, LOCAL_PWD_FLAGS, MIN_LOCAL_PASSWORD_LENGTH, MAX_LOCAL_PASSWORD_LENGTH, 0, DEFAULT_ADMIN_PWD, NO_OPTIONS, "Admin Password"},
+    {EP_USER_PWD, 'S', LEVEL_USER, LOCAL_PWD_FLAGS, MIN_LOCAL_PASSWORD_LENGTH, MAX_LOCAL_PASSWORD_LENGTH, 0, DEFAULT_USER_PWD, NO_OPTIONS, "User Password"},
+    //default hostname is based on mac address
+    {EP_HOSTNAME, 'S', LEVEL_ADMIN, 0, MIN_HOSTNAME_LENGTH, MAX_HOSTNAME_LENGTH, 0, NULL, NO_OPTIONS, "Hostname"},
+    {EP_WIFI_MODE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_WIFI_MODE, NULL, OPTIONS (wifi_mode_options), "Wifi mode"},
+    {EP_STA_SSID, 'S', LEVEL_ADMIN, 0, MIN_SSID_LENGTH, MAX_SSID_LENGTH, 0, DEFAULT_STA_SSID, NO_OPTIONS, "Station SSID"},
+    {EP_STA_PASSWORD, 'S', LEVEL_ADMIN, SETTING_SECRET | SETTING_EMPTY, MIN_PASSWORD_LENGTH, MAX_PASSWORD_LENGTH, 0, DEFAULT_STA_PASSWORD, NO_OPTIONS, "Station Password"},
+    {EP_STA_PHY_MODE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_PHY_MODE, NULL, OPTIONS (sta_phy_options), "Station Network Mode"},
+    {EP_STA_IP_MODE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_STA_IP_MODE, NULL, OPTIONS (ip_mode_options), "Station IP Mode"},
+    {EP_STA_IP_VALUE, 'A', LEVEL_ADMIN, 0, 0, 0, 0, DEFAULT_IP_VALUE, NO_OPTIONS, "Station Static IP"},
+    {EP_STA_MASK_VALUE, 'A', LEVEL_ADMIN, 0, 0, 0, 0, DEFAULT_MASK_VALUE, NO_OPTIONS, "Station Static Mask"},
+    {EP_STA_GATEWAY_VALUE, 'A', LEVEL_ADMIN, 0, 0, 0, 0, DEFAULT_GATEWAY_VALUE, NO_OPTIONS, "Station Static Gateway"},
+    {EP_AP_SSID, 'S', LEVEL_ADMIN, 0, MIN_SSID_LENGTH, MAX_SSID_LENGTH, 0, DEFAULT_AP_SSID, NO_OPTIONS, "AP SSID"},
+    {EP_AP_PASSWORD, 'S', LEVEL_ADMIN, SETTING_SECRET | SETTING_EMPTY, MIN_PASSWORD_LENGTH, MAX_PASSWORD_LENGTH, 0, DEFAULT_AP_PASSWORD, NO_OPTIONS, "AP Password"},
+    {EP_AP_PHY_MODE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_PHY_MODE, NULL, OPTIONS (ap_phy_options), "AP Network Mode"},
+    {EP_SSID_VISIBLE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_SSID_VISIBLE, NULL, OPTIONS (yes_no_options), "SSID Visible"},
+    {EP_CHANNEL, 'B', LEVEL_ADMIN, SETTING_RANGE, 1, 11, DEFAULT_CHANNEL, NULL, NO_OPTIONS, "AP Channel"},
+    {EP_AUTH_TYPE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_AUTH_TYPE, NULL, OPTIONS (auth_options), "Authentication"},
+    {EP_AP_IP_MODE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_AP_IP_MODE, NULL, OPTIONS (ip_mode_options), "AP IP Mode"},
+    {EP_AP_IP_VALUE, 'A', LEVEL_ADMIN, 0, 0, 0, 0, DEFAULT_IP_VALUE, NO_OPTIONS, "AP Static IP"},
+    {EP_AP_MASK_VALUE, 'A', LEVEL_ADMIN, 0, 0, 0, 0, DEFAULT_MASK_VALUE, NO_OPTIONS, "AP Static Mask"},
+    {EP_AP_GATEWAY_VALUE, 'A', LEVEL_ADMIN, 0, 0, 0, 0, DEFAULT_GATEWAY_VALUE, NO_OPTIONS, "AP Static Gateway"},
+#if defined(TIMESTAMP_FEATURE)
+    {EP_TIMEZONE, 'B', LEVEL_USER, SETTING_SIGNED | SETTING_RANGE, -12, 12, DEFAULT_TIME_ZONE, NULL, NO_OPTIONS, "Time Zone"},
+    {EP_TIME_ISDST, 'B', LEVEL_USER, 0, 0, 0, DEFAULT_TIME_DST, NULL, OPTIONS (yes_no_options), "Day Saving Time"},
+    {EP_TIME_SERVER1, 'S', LEVEL_USER, 0, MIN_DATA_LENGTH, MAX_DATA_LENGTH, 0, DEFAULT_TIME_SERVER1, NO_OPTIONS, "Time Server 1"},
+    {EP_TIME_SERVER2, 'S', LEVEL_USER, 0, MIN_DATA_LENGTH, MAX_DATA_LENGTH, 0, DEFAULT_TIME_SERVER2, NO_OPTIONS, "Time Server 2"},
+    {EP_TIME_SERVER3, 'S', LEVEL_USER, 0, MIN_DATA_LENGTH, MAX_DATA_LENGTH, 0, DEFAULT_TIME_SERVER3, NO_OPTIONS, "Time Server 3"},
+#endif
+#ifdef NOTIFICATION_FEATURE
+    {ESP_NOTIFICATION_TYPE, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_NOTIFICATION_TYPE, NULL, OPTIONS (notification_options), "Notification"},
+    {ESP_NOTIFICATION_TOKEN1, 'S', LEVEL_ADMIN, SETTING_SECRET | SETTING_EMPTY, MIN_NOTIFICATION_TOKEN_LENGTH, MAX_NOTIFICATION_TOKEN_LENGTH, 0, NULL, NO_OPTIONS, "Token 1"},
+    {ESP_NOTIFICATION_TOKEN2, 'S', LEVEL_ADMIN, SETTING_SECRET | SETTING_EMPTY, MIN_NOTIFICATION_TOKEN_LENGTH, MAX_NOTIFICATION_TOKEN_LENGTH, 0, NULL, NO_OPTIONS, "Token 2"},
+    {ESP_NOTIFICATION_SETTINGS, 'S', LEVEL_ADMIN, SETTING_EMPTY, MIN_NOTIFICATION_SETTINGS_LENGTH, MAX_NOTIFICATION_SETTINGS_LENGTH, 0, NULL, NO_OPTIONS, "Notifications Settings"},
+    {ESP_AUTO_NOTIFICATION, 'B', LEVEL_ADMIN, 0, 0, 0, DEFAULT_AUTO_NOTIFICATION_STATE, NULL, OPTIONS (yes_no_options), "Auto notification"},
+#endif
+    //printer
+    {EP_TARGET_FW, 'B', LEVEL_USER, SETTING_PRINTER, 0, 0, UNKNOWN_FW, NULL, OPTIONS (target_fw_options), "Target FW"},
+    {EP_OUTPUT_FLAG, 'F', LEVEL_USER, SETTING_PRINTER, 0, 255, DEFAULT_OUTPUT_FLAG, NULL, OPTIONS (output_flag_options), "Output msg"},
+    {EP_STREAM_WINDOW, 'B', LEVEL_USER, SETTING_PRINTER | SETTING_RANGE, 1, MAX_STREAM_WINDOW, DEFAULT_STREAM_WINDOW, NULL, NO_OPTIONS, "Lines in flight"},
+#ifdef DHT_FEATURE
+    {EP_DHT_TYPE, 'B', LEVEL_USER, SETTING_PRINTER, 0, 0, DEFAULT_DHT_TYPE, NULL, OPTIONS (dht_options), "DHT Type"},
+    {EP_DHT_INTERVAL, 'I', LEVEL_USER, SETTING_PRINTER, 0, DEFAULT_MAX_WEB_PORT, DEFAULT_DHT_INTERVAL, NULL, NO_OPTIONS, "DHT check (seconds)"},
+#endif
+    //not in web UI
+    {EP_IS_DIRECT_SD, 'B', LEVEL_USER, SETTING_PRINTER | SETTING_HIDDEN, 0, 255, DEFAULT_IS_DIRECT_SD, NULL, NO_OPTIONS, "Direct SD"},
+    {EP_PRIMARY_SD, 'B', LEVEL_USER, SETTING_PRINTER | SETTING_HIDDEN, 0, 255, DEFAULT_PRIMARY_SD, NULL, NO_OPTIONS, "Primary SD"},
+    {EP_SECONDARY_SD, 'B', LEVEL_USER, SETTING_PRINTER | SETTING_HIDDEN, 0, 255, DEFAULT_SECONDARY_SD, NULL, NO_OPTIONS, "Secondary SD"},
+    {EP_DIRECT_SD_CHECK, 'B', LEVEL_USER, SETTING_PRINTER | SETTING_HIDDEN, 0, 255, DEFAULT_DIRECT_SD_CHECK, NULL, NO_OPTIONS, "Direct SD check"},
+    {EP_SD_CHECK_UPDATE_AT_BOOT, 'B', LEVEL_USER, SETTING_PRINTER | SETTING_HIDDEN, 0, 255, DEFAULT_SD_CHECK_UPDATE_AT_BOOT, NULL, NO_OPTIONS, "SD check at boot"},
+    {EP_SD_SPEED_DIV, 'B', LEVEL_USER, SETTING_PRINTER | SETTING_HIDDEN, 0, 255, DEFAULT_SDREADER_SPEED, NULL, NO_OPTIONS, "SD speed divider"},
+};
+
+#define SETTINGS_NB (sizeof (esp_settings) / sizeof (setting_t))
+
+//table indexes sorted by position, built once
+static uint8_t sorted_index[SETTINGS_NB];
+bool CONFIG_TABLE::_sorted = false;
+
+uint8_t CONFIG_TABLE::count()
+{
+    return SETTINGS_NB;
+}
+
+bool CONFIG_TABLE::get (uint8_t index, setting_t & setting)
+{
+    if (index >= SETTINGS_NB) {
+        return false;
+    }
+    memcpy_P (&setting, &esp_settings[index], sizeof (setting_t));
+    return true;
+}
+
+void CONFIG_TABLE::sort()
+{
+    for (uint8_t i = 0; i < SETTINGS_NB; i++) {
+        uint16_t pos = pgm_read_word (&esp_settings[i].pos);
+        uint8_t j = i;
+        while ((j > 0) && (pgm_read_word (&esp_settings[sorted_index[j - 1]].pos) > pos)) {
+            sorted_index[j] = sorted_index[j - 1];
+            j--;
+        }
+        sorted_index[j] = i;
+    }
+    _sorted = true;
+}
+
+//binary search on position
+bool CONFIG_TABLE::find (int pos, setting_t & setting)
+{
+    if (!_sorted) {
+        sort();
+    }
+    int low = 0;
+    int high = SETTINGS_NB - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int p = pgm_read_word (&esp_settings[sorted_index[mid]].pos);
+        if (p == pos) {
+            return get (sorted_index[mid], setting);
+        }
+        if (p < pos) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return false;
+}
+
+//range options are generated from min / max
+bool CONFIG_TABLE::get_option (const setting_t & setting, uint8_t index, setting_option_t & option)
+{
+    if (setting.flags & SETTING_RANGE) {
+        if (setting.min + index > setting.max) {
+            return false;
+        }
+        option.value = setting.min + index;
+        snprintf (option.label, SETTING_OPTION_SIZE, "%d", (int) option.value);
+        return true;
+    }
+    if (index >= setting.options_nb) {
+        return false;
+    }
+    memcpy_P (&option, &setting.options[index], sizeof (setting_option_t));
+    return true;
+}
+
+//B and F are both stored as byte
+bool CONFIG_TABLE::is_type (const setting_t & setting, char type)
+{
+    if ((setting.type == 'B') || (setting.type == 'F')) {
+        return (type == 'B') || (type == 'F');
+    }
+    return setting.type == type;
+}
+
+bool CONFIG_TABLE::is_valid (const setting_t & setting, const char * value)
+{
+    size_t len = strlen (value);
+    if (setting.type == 'S') {
+        if (len == 0) {
+            return (setting.flags & SETTING_EMPTY);
+        }
+        return (len >= (size_t) setting.min) && (len <= (size_t) setting.max);
+    }
+    if (setting.type == 'A') {
+        byte ipbuf[4];
+        return CONFIG::split_ip (value, ipbuf) == 4;
+    }
+    //numbers
+    char * end = NULL;
+    long v = strtol (value, &end, 10);
+    if ((len == 0) || (*end != '\0')) {
+        return false;
+    }
+    if (setting.type == 'F') {
+        return (v >= 0) && (v <= 255);
+    }
+    if ((setting.options_nb > 0) && !(setting.flags & SETTING_RANGE)) {
+        setting_option_t option;
+        for (uint8_t i = 0; i < setting.options_nb; i++) {
+            get_option (setting, i, option);
+            if (option.value == v) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if ((setting.min != 0) || (setting.max != 0)) {
+        return (v >= setting.min) && (v <= setting.max);
+    }
+    return true;
+}
+
+//current value as text
+bool CONFIG_TABLE::get_value (const setting_t & setting, char * buffer, size_t size)
+{
+    switch (setting.type) {
+    case 'B':
+    case 'F': {
+        byte bbuf = 0;
+        if (!CONFIG::read_byte (setting.pos, &bbuf)) {
+            return false;
+        }
+        snprintf (buffer, size, "%d", (setting.flags & SETTING_SIGNED) ? (int) ((int8_t) bbuf) : (int) bbuf);
+        return true;
+    }
+    case 'I': {
+        int ibuf = 0;
+        if (!CONFIG::read_buffer (setting.pos, (byte *) &ibuf, INTEGER_LENGTH)) {
+            return false;
+        }
+        snprintf (buffer, size, "%d", ibuf);
+        return true;
+    }
+    case 'A': {
+        byte ipbuf[4];
+        if (!CONFIG::read_buffer (setting.pos, ipbuf, IP_LENGTH)) {
+            return false;
+        }
+        snprintf (buffer, size, "%d.%d.%d.%d", ipbuf[0], ipbuf[1], ipbuf[2], ipbuf[3]);
+        return true;
+    }
+    case 'S':
+        //max chars + 0 terminal
+        if ((size_t) setting.max + 1 > size) {
+            return false;
+        }
+        return CONFIG::read_string (setting.pos, buffer, setting.max + 1);
+    default:
+        break;
+    }
+    return false;
+}
+
+//value must be checked with is_valid() first
+bool CONFIG_TABLE::set_value (const setting_t & setting, const char * value)
+{
+    switch (setting.type) {
+    case 'B':
+    case 'F':
+        return CONFIG::write_byte (setting.pos, (byte) atoi (value));
+    case 'I': {
+        int ibuf = atoi (value);
+        return CONFIG::write_buffer (setting.pos, (const byte *) &ibuf, INTEGER_LENGTH);
+    }
+    case 'A': {
+        byte ipbuf[4];
+        if (CONFIG::split_ip (value, ipbuf) < 4) {
+            return false;
+        }
+        return CONFIG::write_buffer (setting.pos, ipbuf, IP_LENGTH);
+    }
+    case 'S':
+        return CONFIG::write_string (setting.pos, value);
+    default:
+        break;
+    }
+    return false;
+}
+
+bool CONFIG_TABLE::write_default (const setting_t & setting)
+{
+    switch (setting.type) {
+    case 'B':
+    case 'F':
+        return CONFIG::write_byte (setting.pos, (byte) setting.defval);
+    case 'I': {
+        int ibuf = setting.defval;
+        return CONFIG::write_buffer (setting.pos, (const byte *) &ibuf, INTEGER_LENGTH);
+    }
+    case 'A':
+        return CONFIG::write_buffer (setting.pos, (const byte *) setting.defptr, IP_LENGTH);
+    case 'S':
+        if (setting.pos == EP_HOSTNAME) {
+            return CONFIG::write_string (setting.pos, wifi_config.get_default_hostname());
+        }
+        if (setting.defptr == NULL) {
+            return CONFIG::write_string (setting.pos, "");
+        }
+        return CONFIG::write_string (setting.pos, FPSTR ((const char *) setting.defptr));
+    default:
+        break;
+    }
+    return false;
+}
+
+//write all default values
+bool CONFIG_TABLE::reset()
+{
+    setting_t setting;
+    for (uint8_t i = 0; i < SETTINGS_NB; i++) {
+        get (i, setting);
+        if (!write_default (setting)) {
+            LOG ("Error reset setting ")
+            LOG (String (setting.pos))
+            LOG ("\r\n")
+            return false;
+        }
+    }
+    return true;
+}
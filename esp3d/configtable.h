@@ -0,0 +1,85 @@
+/*
+  configtable.h - ESP3D settings table class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef CONFIGTABLE_H
+#define CONFIGTABLE_H
+#include <Arduino.h>
+#include "config.h"
+
+//setting flags
+//in printer section of [ESP400], else network
+#define SETTING_PRINTER 0x01
+//value is never displayed
+#define SETTING_SECRET 0x02
+//empty string is accepted
+#define SETTING_EMPTY 0x04
+//byte is signed
+#define SETTING_SIGNED 0x08
+//options are all values from min to max
+#define SETTING_RANGE 0x10
+//not listed by [ESP400]
+#define SETTING_HIDDEN 0x20
+
+#define SETTING_LABEL_SIZE 24
+#define SETTING_OPTION_SIZE 21
+
+typedef struct {
+    char label[SETTING_OPTION_SIZE];
+    int32_t value;
+} setting_option_t;
+
+//one entry per EEPROM setting:
+//type is B (byte), F (flags), I (integer), S (string), A (IP address)
+//min / max are value range for B/I and length range for S
+typedef struct {
+    uint16_t pos;
+    char type;
+    uint8_t level;
+    uint8_t flags;
+    int32_t min;
+    int32_t max;
+    int32_t defval;
+    const void * defptr;
+    uint8_t options_nb;
+    const setting_option_t * options;
+    char label[SETTING_LABEL_SIZE];
+} setting_t;
+
+//settings descriptors are all in one table in flash
+//[ESP400], [ESP401], auth level, string sizes and reset values come from it
+class CONFIG_TABLE
+{
+public:
+    static uint8_t count();
+    static bool get (uint8_t index, setting_t & setting);
+    static bool find (int pos, setting_t & setting);
+    static bool get_option (const setting_t & setting, uint8_t index, setting_option_t & option);
+    static bool is_type (const setting_t & setting, char type);
+    static bool is_valid (const setting_t & setting, const char * value);
+    static bool get_value (const setting_t & setting, char * buffer, size_t size);
+    static bool set_value (const setting_t & setting, const char * value);
+    static bool write_default (const setting_t & setting);
+    static bool reset();
+private:
+    static bool _sorted;
+    static void sort();
+};
+
+#endif
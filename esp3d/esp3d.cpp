@@ -43,6 +43,14 @@
 #include "espcom.h"
 #include "webinterface.h"
 #include "command.h"
+#include "fsindex.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "gcode_stream.h"
+#if !defined (ASYNCWEBSERVER)
+#include "autoreport.h"
+#include "webjobs.h"
+#endif
+#endif
 #ifdef ARDUINO_ARCH_ESP8266
 #include "ESP8266WiFi.h"
 #if defined (ASYNCWEBSERVER)
@@ -181,6 +189,9 @@ void Esp3D::begin(uint16_t startdelayms, uint16_t recoverydelayms)
 #endif
     //get target FW
     CONFIG::InitFirmwareTarget();
+#ifndef USE_AS_UPDATER_ONLY
+    GCODE_STREAM::init_credit();
+#endif
     delay(100);
     //Update is done if any so should be Ok
 #ifdef ARDUINO_ARCH_ESP32
@@ -188,6 +199,8 @@ void Esp3D::begin(uint16_t startdelayms, uint16_t recoverydelayms)
 #else
     SPIFFS.begin();
 #endif
+    //files list for web listing
+    FS_INDEX::begin();
 //basic autostart
     if(SPIFFS.exists("/autostart.g")) {
         FS_FILE file = SPIFFS.open("/autostart.g", SPIFFS_FILE_READ);
@@ -277,6 +290,14 @@ void Esp3D::process()
     }
 //read / bridge all input
     ESPCOM::bridge();
+#if !defined (USE_AS_UPDATER_ONLY) && !defined (ASYNCWEBSERVER)
+//printer auto reports for websocket subscribers
+    AUTOREPORT::handle();
+//web commands sent with async
+    WEB_JOBS::handle();
+#endif
+//commit pending settings when quiet
+    CONFIG::handle_settings();
 //in case of restart requested
     if (web_interface->restartmodule) {
         CONFIG::esp_restart();
@@ -22,11 +22,25 @@
 #include "espcom.h"
 #include "command.h"
 #include "webinterface.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "gcode_stream.h"
+#include "marlin_binary.h"
+#include "cmdqueue.h"
+#include "lineframer.h"
+#include "grblcom.h"
+#include "telemetry.h"
+#if !defined (ASYNCWEBSERVER)
+#include "autoreport.h"
+#endif
+#endif
 #if defined (ASYNCWEBSERVER)
 #include "asyncwebserver.h"
 #else
 #include "syncwebserver.h"
 #endif
+#ifdef ARDUINO_ARCH_ESP32
+#include <lwip/sockets.h>
+#endif
 
 #ifdef ESP_OLED_FEATURE
 #include "esp_oled.h"
@@ -42,6 +56,37 @@ WiFiClient serverClients[MAX_SRV_CLIENTS];
 
 bool ESPCOM::block_2_printer = false;
 
+RING_BUFFER<SERIAL_RX_RING_SIZE> ESPCOM::rx_ring;
+uint32_t ESPCOM::rx_lost = 0;
+uint32_t ESPCOM::_cmd_cursor = 0;
+#ifndef USE_AS_UPDATER_ONLY
+uint32_t ESPCOM::_queue_cursor = 0;
+//printer answers are given as they are to commands origin
+static LINE_FRAMER answer_framer (1, true);
+uint32_t ESPCOM::urgent_count = 0;
+uint32_t ESPCOM::urgent_last_us = 0;
+uint32_t ESPCOM::urgent_max_us = 0;
+uint32_t ESPCOM::urgent_total_us = 0;
+#endif
+#ifdef TCP_IP_DATA_FEATURE
+uint32_t ESPCOM::_tcp_cursor[MAX_SRV_CLIENTS];
+uint32_t ESPCOM::_tcp_last[MAX_SRV_CLIENTS];
+#ifndef USE_AS_UPDATER_ONLY
+uint8_t ESPCOM::_tcp_hold[MAX_SRV_CLIENTS][TCP_HOLD_SIZE];
+uint16_t ESPCOM::_tcp_hold_len[MAX_SRV_CLIENTS];
+uint16_t ESPCOM::_tcp_hold_scan[MAX_SRV_CLIENTS];
+#endif
+#endif
+#ifdef WS_DATA_FEATURE
+#if defined (ASYNCWEBSERVER)
+uint32_t ESPCOM::_ws_cursor = 0;
+#else
+uint32_t ESPCOM::_ws_cursor[MAX_WS_CLIENTS];
+uint32_t ESPCOM::_ws_last[MAX_WS_CLIENTS];
+bool ESPCOM::_ws_on[MAX_WS_CLIENTS];
+#endif
+#endif
+
 void ESPCOM::bridge(bool async)
 {
 #if defined (ASYNCWEBSERVER)
@@ -177,6 +222,35 @@ size_t   ESPCOM::write(tpipe output, uint8_t d)
         break;
     }
 }
+size_t   ESPCOM::write(tpipe output, const uint8_t * buf, size_t len)
+{
+    if ((DEFAULT_PRINTER_PIPE == output) && (block_2_printer || CONFIG::is_locked(FLAG_BLOCK_SERIAL))) {
+        return 0;
+    }
+    if ((SERIAL_PIPE == output) && CONFIG::is_locked(FLAG_BLOCK_SERIAL)) {
+        return 0;
+    }
+    switch (output) {
+#ifdef USE_SERIAL_0
+    case SERIAL_PIPE:
+        return Serial.write(buf, len);
+        break;
+#endif
+#ifdef USE_SERIAL_1
+    case SERIAL_PIPE:
+        return Serial1.write(buf, len);
+        break;
+#endif
+#ifdef USE_SERIAL_2
+    case SERIAL_PIPE:
+        return Serial2.write(buf, len);
+        break;
+#endif
+    default:
+        return 0;
+        break;
+    }
+}
 void ESPCOM::flush (tpipe output, ESPResponseStream  *espresponse)
 {
     switch (output) {
@@ -217,6 +291,14 @@ void ESPCOM::flush (tpipe output, ESPResponseStream  *espresponse)
 
 void ESPCOM::print (const __FlashStringHelper *data, tpipe output, ESPResponseStream  *espresponse)
 {
+    //short strings are copied on stack, no heap
+    char buf[65];
+    PGM_P p = (PGM_P) data;
+    if (strlen_P (p) < sizeof (buf)) {
+        strcpy_P (buf, p);
+        ESPCOM::print (buf, output, espresponse);
+        return;
+    }
     String tmp = data;
     ESPCOM::print (tmp.c_str(), output, espresponse);
 }
@@ -389,58 +471,378 @@ void ESPCOM::send2TCP (const char * data, bool async)
 
 bool ESPCOM::processFromSerial (bool async)
 {
-    uint8_t i;
+#ifndef USE_AS_UPDATER_ONLY
+    //printer answers belong to the ongoing stream
+    if (GCODE_STREAM::is_active()) {
+        GCODE_STREAM::poll();
+        return false;
+    }
+    //binary transfer reads printer answers itself
+    if (MARLIN_BINARY::is_active()) {
+        return false;
+    }
+#endif
     //check UART for data
-    if (ESPCOM::available(DEFAULT_PRINTER_PIPE)) {
-        size_t len = ESPCOM::available(DEFAULT_PRINTER_PIPE);
-        uint8_t * sbuf = (uint8_t *)malloc(len+1);
-        if(!sbuf) {
-            return false;
+    size_t len = ESPCOM::available(DEFAULT_PRINTER_PIPE);
+    bool received = false;
+    uint8_t * sbuf;
+    if (len > 0) {
+        //UART data go directly into the ring, no copy
+        size_t span = rx_ring.write_span (&sbuf);
+        if (len > span) {
+            len = span;
         }
-        sbuf[len] = '\0';
-        ESPCOM::readBytes (DEFAULT_PRINTER_PIPE, sbuf, len);
+        len = ESPCOM::readBytes (DEFAULT_PRINTER_PIPE, sbuf, len);
+        rx_ring.commit (len);
+        received = (len > 0);
+    }
+#ifndef USE_AS_UPDATER_ONLY
+    //match answers to the command which is waiting for them
+    while ((len = rx_ring.peek (_queue_cursor, &sbuf, &rx_lost)) > 0) {
+        process_answers (sbuf, len);
+        rx_ring.consume (_queue_cursor, len);
+    }
+    CMD_QUEUE::poll();
+#endif
 #ifdef TCP_IP_DATA_FEATURE
-        if (!async &&  !CONFIG::is_locked(FLAG_BLOCK_TCP)) {
-            if ((WiFi.getMode() != WIFI_OFF)  || !wifi_config.WiFi_on) {
-                //push UART data to all connected tcp clients
-                for (i = 0; i < MAX_SRV_CLIENTS; i++) {
-                    if (serverClients[i] && serverClients[i].connected() ) {
-                        serverClients[i].write (sbuf, len);
-                        delay (0);
-                    }
-                }
-            }
-        }
+    //tcp clients cannot be used from async context, data stay in ring until next loop
+    if (!async) {
+        flush2TCP();
+    }
 #endif
 #ifdef WS_DATA_FEATURE
-
 #if defined (ASYNCWEBSERVER)
+    //async websocket queues messages per client
+    while ((len = rx_ring.peek (_ws_cursor, &sbuf, &rx_lost)) > 0) {
         if (!CONFIG::is_locked(FLAG_BLOCK_WSOCKET)) {
             web_interface->web_socket.textAll(sbuf, len);
         }
+        rx_ring.consume (_ws_cursor, len);
+    }
 #else
-        if (!CONFIG::is_locked(FLAG_BLOCK_WSOCKET) && socket_server) {
+    for (uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+        if (!_ws_on[i]) {
+            continue;
+        }
+        //if client is too slow oldest data are lost
+        while ((len = rx_ring.peek (_ws_cursor[i], &sbuf, &rx_lost)) > 0) {
 #ifndef DEBUG_OUTPUT_SOCKET
-            if(socket_server){
-                socket_server->sendBIN(current_socket_id,sbuf,len);
+            if (!CONFIG::is_locked(FLAG_BLOCK_WSOCKET) && socket_server) {
+                //only send what the socket takes without blocking, frame header included
+                size_t room = socket_server->availableForWrite (i);
+                if (room <= WEBSOCKETS_MAX_HEADER_SIZE) {
+                    break;
+                }
+                if (len > (room - WEBSOCKETS_MAX_HEADER_SIZE)) {
+                    len = room - WEBSOCKETS_MAX_HEADER_SIZE;
                 }
+                if (!socket_server->sendBIN (i, sbuf, len)) {
+                    break;
+                }
+            }
 #endif
+            rx_ring.consume (_ws_cursor[i], len);
+            _ws_last[i] = millis();
         }
+        //nothing pending
+        if (rx_ring.available (_ws_cursor[i]) == 0) {
+            _ws_last[i] = millis();
+        } else if ((millis() - _ws_last[i]) > SRV_CLIENT_STALL_TIMEOUT) {
+            //client does not read anymore, so drop it
+            log_esp3d ("Drop stalled websocket client %d", i);
+            _ws_on[i] = false;
+            socket_server->disconnect (i);
+        }
+    }
 #endif
-
 #endif
-        //process data if any
+    //process data if any
+    while ((len = rx_ring.peek (_cmd_cursor, &sbuf, &rx_lost)) > 0) {
         COMMAND::read_buffer_serial (sbuf, len);
-        free(sbuf);
+        rx_ring.consume (_cmd_cursor, len);
+    }
+    return received;
+}
+
+#if defined (WS_DATA_FEATURE) && !defined (ASYNCWEBSERVER)
+//websocket client receives printer output from now
+void ESPCOM::subscribeWS (uint8_t num, bool on)
+{
+    if (num < MAX_WS_CLIENTS) {
+        _ws_on[num] = on;
+        _ws_cursor[num] = rx_ring.cursor();
+        _ws_last[num] = millis();
+    }
+}
+#endif
+
+//bytes which can be written to client without blocking
+size_t ESPCOM::write_room (WiFiClient & client)
+{
+#ifdef ARDUINO_ARCH_ESP8266
+    return client.availableForWrite();
+#else
+    //esp32 client has no room count, ask lwip if socket is writable
+    int fd = client.fd();
+    if (fd < 0) {
+        return 0;
+    }
+    fd_set set;
+    struct timeval tv = {0, 0};
+    FD_ZERO (&set);
+    FD_SET (fd, &set);
+    if (select (fd + 1, NULL, &set, NULL, &tv) > 0) {
+        return ESP32_WRITABLE_ROOM;
+    }
+    return 0;
+#endif
+}
+
+#ifdef TCP_IP_DATA_FEATURE
+//push printer output to each tcp client without waiting for it
+void ESPCOM::flush2TCP()
+{
+    bool tcp_on = !CONFIG::is_locked(FLAG_BLOCK_TCP) && ((WiFi.getMode() != WIFI_OFF)  || !wifi_config.WiFi_on);
+    uint8_t * sbuf;
+    size_t len;
+    for (uint8_t i = 0; i < MAX_SRV_CLIENTS; i++) {
+        if (!serverClients[i] || !serverClients[i].connected() ) {
+            continue;
+        }
+        //if client is too slow oldest data are lost
+        while ((len = rx_ring.peek (_tcp_cursor[i], &sbuf, &rx_lost)) > 0) {
+            if (!tcp_on) {
+                rx_ring.consume (_tcp_cursor[i], len);
+                continue;
+            }
+            size_t room = write_room (serverClients[i]);
+            if (len > room) {
+                len = room;
+            }
+            if (len > 0) {
+                len = serverClients[i].write (sbuf, len);
+            }
+            if (len == 0) {
+                break;
+            }
+            rx_ring.consume (_tcp_cursor[i], len);
+            _tcp_last[i] = millis();
+        }
+        //nothing pending
+        if (rx_ring.available (_tcp_cursor[i]) == 0) {
+            _tcp_last[i] = millis();
+        } else if ((millis() - _tcp_last[i]) > SRV_CLIENT_STALL_TIMEOUT) {
+            //client does not read anymore, so drop it
+            log_esp3d ("Drop stalled tcp client %d", i);
+            serverClients[i].stop();
+        }
+    }
+}
+#endif
+#ifndef USE_AS_UPDATER_ONLY
+//each answer line goes to command queue first, so printer credit is only released
+//by acks of lines sent by ESP3D, acks of tcp host lines do not give credits
+void ESPCOM::process_answers (const uint8_t * data, size_t len)
+{
+    while (answer_framer.push (data, len)) {
+        bool credit = CMD_QUEUE::on_answer (answer_framer.line(), answer_framer.length());
+        GCODE_STREAM::process_answer (answer_framer.line(), credit);
+        TELEMETRY::parse (answer_framer.line(), answer_framer.length());
+#if !defined (ASYNCWEBSERVER)
+        AUTOREPORT::parse (answer_framer.line(), answer_framer.length());
+#endif
+    }
+}
+
+//serial is owned by an upload, printer may write lines into a file
+static bool upload_running()
+{
+    return (web_interface && web_interface->blockserial) || GCODE_STREAM::is_active() || MARLIN_BINARY::is_active();
+}
+
+//M112 (emergency stop), M108 (break wait), M410 (quickstop) and grbl real time commands are
+//handled by printer as soon as received
+//M0 / M25 (pause) are queued like any line, during an upload printer would write them into the file
+bool ESPCOM::is_urgent (const char * cmd)
+{
+    while (*cmd == ' ') {
+        cmd++;
+    }
+    if (CONFIG::GetFirmwareTarget() == GRBL) {
+        return GRBLCOM::is_realtime (cmd);
+    }
+    if ((cmd[0] != 'M') && (cmd[0] != 'm')) {
+        return false;
+    }
+    if (!isdigit (cmd[1])) {
+        return false;
+    }
+    char * end;
+    long code = strtol (&cmd[1], &end, 10);
+    //subcodes like M410.1 are not urgent
+    if (*end == '.') {
+        return false;
+    }
+    //no other line must be hidden after
+    if (strchr (end, '\n')) {
+        return false;
+    }
+    if ((code == 112) || (code == 108) || (code == 410)) {
         return true;
-    } else {
+    }
+    return ((code == 0) || (code == 25)) && !upload_running();
+}
+
+//write command to printer now, even if an upload or a macro is using serial
+//during an upload only emergency commands are allowed
+//start_us is when command was received, to measure time until it is out of UART
+bool ESPCOM::send_urgent (const char * cmd, uint32_t start_us)
+{
+    while (*cmd == ' ') {
+        cmd++;
+    }
+    size_t len = strlen (cmd);
+    while ((len > 0) && ((cmd[len - 1] == '\n') || (cmd[len - 1] == '\r') || (cmd[len - 1] == ' '))) {
+        len--;
+    }
+    if (len == 0) {
         return false;
     }
+    if (upload_running() && !is_urgent (cmd)) {
+        log_esp3d ("Not an emergency command, upload is running");
+        return false;
+    }
+    if ((CONFIG::GetFirmwareTarget() == GRBL) && GRBLCOM::is_realtime (cmd)) {
+        GRBLCOM::send_realtime (cmd[0]);
+    } else {
+        if (ESPCOM::write (DEFAULT_PRINTER_PIPE, (const uint8_t *)cmd, len) != len) {
+            return false;
+        }
+        ESPCOM::write (DEFAULT_PRINTER_PIPE, '\n');
+        //binary transfer does not expect any ack
+        if (!MARLIN_BINARY::is_active()) {
+            //line uses a printer slot like others, so the stream does not send one line too many
+            GCODE_STREAM::count_line (len);
+            //stream reads acks itself, else printer acks it in order like any line
+            if (!GCODE_STREAM::is_active()) {
+                CMD_QUEUE::add_urgent();
+            }
+        }
+    }
+    ESPCOM::flush (DEFAULT_PRINTER_PIPE);
+    urgent_last_us = micros() - start_us;
+    if (urgent_last_us > urgent_max_us) {
+        urgent_max_us = urgent_last_us;
+    }
+    urgent_total_us += urgent_last_us;
+    urgent_count++;
+    log_esp3d ("Urgent %s sent in %u us", cmd, urgent_last_us);
+    return true;
+}
+
+#ifdef TCP_IP_DATA_FEATURE
+//send urgent lines found in held tcp data and remove them, other data stay as they are
+//data before from are complete lines already checked, return new size of data
+uint16_t ESPCOM::take_urgent (uint8_t * data, uint16_t len, uint16_t from)
+{
+    uint32_t start_us = micros();
+    bool is_grbl = (CONFIG::GetFirmwareTarget() == GRBL);
+    uint16_t start = from;
+    uint16_t i = from;
+    while (i < len) {
+        if (is_grbl) {
+            //grbl real time commands are single bytes inside the stream
+            char rt[2] = {(char) data[i], 0};
+            if (GRBLCOM::is_realtime (rt)) {
+                send_urgent (rt, start_us);
+                memmove (&data[i], &data[i + 1], len - i - 1);
+                len--;
+            } else {
+                i++;
+            }
+            continue;
+        }
+        if ((data[i] != '\n') && (data[i] != '\r')) {
+            i++;
+            continue;
+        }
+        //line from start to i, emergency commands are short
+        char line[16];
+        uint16_t n = i - start;
+        bool urgent = false;
+        if ((n > 0) && (n < sizeof (line))) {
+            memcpy (line, &data[start], n);
+            line[n] = '\0';
+            urgent = is_urgent (line);
+        }
+        if (urgent) {
+            send_urgent (line, start_us);
+            //remove line and its end
+            memmove (&data[start], &data[i + 1], len - i - 1);
+            len -= n + 1;
+            i = start;
+        } else {
+            i++;
+            start = i;
+        }
+    }
+    return len;
+}
+#endif
+
+//tcp clients are not forwarded while serial is locked (upload), so only look for urgent commands
+//this is called from upload wait loops, other data are kept and sent to printer once upload is done
+//if a client fills its hold buffer, its next data stay in socket
+void ESPCOM::poll_urgent()
+{
+#ifdef TCP_IP_DATA_FEATURE
+    if (!web_interface->blockserial || CONFIG::is_locked(FLAG_BLOCK_TCP)) {
+        return;
+    }
+    for (uint8_t i = 0; i < MAX_SRV_CLIENTS; i++) {
+        if (!serverClients[i] || !serverClients[i].connected() ) {
+            continue;
+        }
+        int len;
+        while ((_tcp_hold_len[i] < TCP_HOLD_SIZE) && ((len = serverClients[i].available()) > 0)) {
+            uint16_t room = TCP_HOLD_SIZE - _tcp_hold_len[i];
+            if (len > room) {
+                len = room;
+            }
+            len = serverClients[i].read (&_tcp_hold[i][_tcp_hold_len[i]], len);
+            if (len <= 0) {
+                break;
+            }
+            _tcp_hold_len[i] = take_urgent (_tcp_hold[i], _tcp_hold_len[i] + len, _tcp_hold_scan[i]);
+            //next check starts at the line not yet complete
+            uint16_t scan = _tcp_hold_len[i];
+            while ((scan > 0) && (_tcp_hold[i][scan - 1] != '\n') && (_tcp_hold[i][scan - 1] != '\r')) {
+                scan--;
+            }
+            _tcp_hold_scan[i] = (CONFIG::GetFirmwareTarget() == GRBL) ? _tcp_hold_len[i] : scan;
+        }
+    }
+#endif
 }
+#endif //USE_AS_UPDATER_ONLY
+
 #ifdef TCP_IP_DATA_FEATURE
+void ESPCOM::tcp2Serial (uint8_t client, const uint8_t * data, size_t len)
+{
+    ESPCOM::write(DEFAULT_PRINTER_PIPE, data, len);
+#ifndef USE_AS_UPDATER_ONLY
+    //acks of these lines belong to this client
+    CMD_QUEUE::add_raw (ORIGIN_TCP, client, data, len);
+#endif
+    COMMAND::read_buffer_tcp (data, len);
+}
+
 void ESPCOM::processFromTCP2Serial()
 {
-    uint8_t i, data;
+    uint8_t i;
+    //read by block, not byte per byte
+    static uint8_t data[TCP_READ_BUFFER_SIZE];
+    int len;
     //check if there are any new clients
     if (data_server->hasClient() ) {
         for (i = 0; i < MAX_SRV_CLIENTS; i++) {
@@ -450,25 +852,54 @@ void ESPCOM::processFromTCP2Serial()
                     serverClients[i].stop();
                 }
                 serverClients[i] = data_server->available();
-                continue;
+                //client receives printer output from now
+                _tcp_cursor[i] = rx_ring.cursor();
+                _tcp_last[i] = millis();
+#ifndef USE_AS_UPDATER_ONLY
+                _tcp_hold_len[i] = 0;
+                _tcp_hold_scan[i] = 0;
+#endif
+                break;
             }
         }
         //no free/disconnected spot so reject
-        WiFiClient serverClient = data_server->available();
-        serverClient.stop();
+        if (i == MAX_SRV_CLIENTS) {
+            WiFiClient serverClient = data_server->available();
+            serverClient.stop();
+        }
     }
     //check clients for data
     //to avoid any pollution if Uploading file to SDCard
     if (!((web_interface->blockserial)  || CONFIG::is_locked(FLAG_BLOCK_TCP) || CONFIG::is_locked(FLAG_BLOCK_SERIAL))) {
         for (i = 0; i < MAX_SRV_CLIENTS; i++) {
             if (serverClients[i] && serverClients[i].connected() ) {
-                if (serverClients[i].available() ) {
-                    //get data from the tcp client and push it to the UART
-                    while (serverClients[i].available() ) {
-                        data = serverClients[i].read();
-                        ESPCOM::write(DEFAULT_PRINTER_PIPE, data);
-                        COMMAND::read_buffer_tcp (data);
+#ifndef USE_AS_UPDATER_ONLY
+                //data received during upload go first
+                if (_tcp_hold_len[i] > 0) {
+                    if (!CMD_QUEUE::can_add_raw (ORIGIN_TCP, i)) {
+                        continue;
+                    }
+                    tcp2Serial (i, _tcp_hold[i], _tcp_hold_len[i]);
+                    _tcp_hold_len[i] = 0;
+                    _tcp_hold_scan[i] = 0;
+                }
+#endif
+                //get data from the tcp client and push it to the UART
+                while ((len = serverClients[i].available()) > 0) {
+#ifndef USE_AS_UPDATER_ONLY
+                    //acks cannot be tracked now, data wait in socket
+                    if (!CMD_QUEUE::can_add_raw (ORIGIN_TCP, i)) {
+                        break;
+                    }
+#endif
+                    if (len > TCP_READ_BUFFER_SIZE) {
+                        len = TCP_READ_BUFFER_SIZE;
+                    }
+                    len = serverClients[i].read (data, len);
+                    if (len <= 0) {
+                        break;
                     }
+                    tcp2Serial (i, data, len);
                 }
             }
         }
@@ -22,6 +22,7 @@
 #define ESPCOM_H
 #include <WiFiServer.h>
 #include "config.h"
+#include "ringbuffer.h"
 #ifdef TCP_IP_DATA_FEATURE
 extern WiFiServer * data_server;
 #endif
@@ -30,6 +31,7 @@ class ESPCOM
 {
 public:
     static size_t  write(tpipe output, uint8_t d);
+    static size_t  write(tpipe output, const uint8_t * buf, size_t len);
     static long readBytes (tpipe output, uint8_t * sbuf, size_t len);
     static long baudRate(tpipe output);
     static size_t available(tpipe output);
@@ -43,6 +45,10 @@ public:
     static void println (String & data, tpipe output, ESPResponseStream  *espresponse = NULL);
     static void println (const char * data, tpipe output, ESPResponseStream  *espresponse = NULL);
     static uint8_t current_socket_id;
+    static size_t write_room (WiFiClient & client);
+#if defined (WS_DATA_FEATURE) && !defined (ASYNCWEBSERVER)
+    static void subscribeWS (uint8_t num, bool on);
+#endif
 #ifdef TCP_IP_DATA_FEATURE
     static void processFromTCP2Serial();
     static void send2TCP (const __FlashStringHelper *data, bool async = false);
@@ -50,8 +56,49 @@ public:
     static void send2TCP (const char * data, bool async = false);
 #endif
     static bool block_2_printer;
+#ifndef USE_AS_UPDATER_ONLY
+    //emergency lane, bypass any queue and lock
+    static bool is_urgent (const char * cmd);
+    static bool send_urgent (const char * cmd, uint32_t start_us);
+    static void poll_urgent();
+    //printer answers not read by a stream: command queue, credits and telemetry
+    static void process_answers (const uint8_t * data, size_t len);
+    static uint32_t urgent_count;
+    static uint32_t urgent_last_us;
+    static uint32_t urgent_max_us;
+    static uint32_t urgent_total_us;
+#endif
+    //serial data received, each consumer reads it with its own cursor
+    static RING_BUFFER<SERIAL_RX_RING_SIZE> rx_ring;
+    static uint32_t rx_lost;
 #ifdef ESP_OLED_FEATURE
     static bool block_2_oled;
 #endif
+private:
+    static uint32_t _cmd_cursor;
+#ifndef USE_AS_UPDATER_ONLY
+    static uint32_t _queue_cursor;
+#endif
+#ifdef TCP_IP_DATA_FEATURE
+    static uint32_t _tcp_cursor[MAX_SRV_CLIENTS];
+    static uint32_t _tcp_last[MAX_SRV_CLIENTS];
+    static void flush2TCP();
+    static void tcp2Serial (uint8_t client, const uint8_t * data, size_t len);
+#ifndef USE_AS_UPDATER_ONLY
+    static uint8_t _tcp_hold[MAX_SRV_CLIENTS][TCP_HOLD_SIZE];
+    static uint16_t _tcp_hold_len[MAX_SRV_CLIENTS];
+    static uint16_t _tcp_hold_scan[MAX_SRV_CLIENTS];
+    static uint16_t take_urgent (uint8_t * data, uint16_t len, uint16_t from);
+#endif
+#endif
+#ifdef WS_DATA_FEATURE
+#if defined (ASYNCWEBSERVER)
+    static uint32_t _ws_cursor;
+#else
+    static uint32_t _ws_cursor[MAX_WS_CLIENTS];
+    static uint32_t _ws_last[MAX_WS_CLIENTS];
+    static bool _ws_on[MAX_WS_CLIENTS];
+#endif
+#endif
 };
 #endif
@@ -0,0 +1,392 @@
+/*
+  fsindex.cpp - ESP3D SPIFFS files index class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifndef FS_NO_GLOBALS
+#define FS_NO_GLOBALS
+#endif
+#include <FS.h>
+#if defined(ARDUINO_ARCH_ESP32)
+#include "SPIFFS.h"
+#endif
+#include "fsindex.h"
+#include "nameset.h"
+#ifdef CONFIG_JOURNAL_FEATURE
+#include "configjournal.h"
+#endif
+
+static void print_entry (JSON_WRITER & writer, bool & first, const char * name, const char * size)
+{
+    if (!first) {
+        writer.print (',');
+    }
+    first = false;
+    writer.print (F ("{\"name\":\""));
+    writer.print (name);
+    writer.print (F ("\",\"size\":\""));
+    writer.print (size);
+    writer.print (F ("\"}"));
+}
+
+//read all SPIFFS and keep only path entries
+static void scan_list (const String & path, JSON_WRITER & writer)
+{
+    bool first = true;
+    NAME_SET subdirs;
+#if defined (ARDUINO_ARCH_ESP8266)
+    FS_DIR dir = SPIFFS.openDir (path);
+    while (dir.next()) {
+        String filename = dir.fileName();
+        uint32_t filesize = dir.fileSize();
+#else
+    String ptmp = path;
+    if ((path != "/") && (path[path.length() - 1] == '/')) {
+        ptmp = path.substring (0, path.length() - 1);
+    }
+    FS_FILE dir = SPIFFS.open (ptmp);
+    FS_FILE fileparsed = dir.openNextFile();
+    while (fileparsed) {
+        String filename = fileparsed.name();
+        uint32_t filesize = fileparsed.size();
+        fileparsed = dir.openNextFile();
+#endif
+#ifdef CONFIG_JOURNAL_FEATURE
+        if (CONFIG_JOURNAL::is_journal (filename.c_str())) {
+            continue;
+        }
+#endif
+        if (filename.length() <= path.length()) {
+            continue;
+        }
+        //remove path from name
+        filename.remove (0, path.length());
+        int slash = filename.indexOf ("/");
+        //check if file or subfile
+        if (slash > -1) {
+            //Do not rely on "/." to define directory as SPIFFS upload won't create it but directly files
+            //and no need to overload SPIFFS if not necessary to create "/." if no need
+            //it will reduce SPIFFS available space so limit it to creation
+            filename.remove (slash);
+            if ((slash > 0) && subdirs.add (filename.c_str(), slash)) {
+                //it is subfile so display only directory, size will be -1 to describe it is directory
+                print_entry (writer, first, filename.c_str(), "-1");
+            }
+        } else if (filename != ".") {
+            //do not add "." file
+            print_entry (writer, first, filename.c_str(), CONFIG::formatBytes (filesize).c_str());
+        }
+    }
+}
+
+#ifdef FS_INDEX_FEATURE
+fs_index_entry_t * FS_INDEX::_entries = NULL;
+uint16_t FS_INDEX::_count = 0;
+uint16_t FS_INDEX::_capacity = 0;
+bool FS_INDEX::_started = false;
+uint16_t FS_INDEX::_missing = 0;
+
+//0 means not computed
+static uint32_t hash_file (const char * name)
+{
+    FS_FILE f = SPIFFS.open (name, SPIFFS_FILE_READ);
+    if (!f) {
+        return 0;
+    }
+    uint8_t buf[128];
+    uint32_t h = NAME_SET_FNV_BASIS;
+    size_t len;
+    while ((len = f.read (buf, sizeof (buf))) > 0) {
+        h = NAME_SET::fnv (h, buf, len);
+        CONFIG::wdtFeed();
+    }
+    f.close();
+    return (h == 0) ? 1 : h;
+}
+
+//first entry not lower than name
+uint16_t FS_INDEX::lower_bound (const char * name)
+{
+    uint16_t low = 0;
+    uint16_t high = _count;
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (strcmp (_entries[mid].name, name) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool FS_INDEX::set (const char * name, uint32_t size)
+{
+    if (strlen (name) >= FS_INDEX_NAME_SIZE) {
+        return false;
+    }
+    uint16_t i = lower_bound (name);
+    if ((i < _count) && (strcmp (_entries[i].name, name) == 0)) {
+        //content may have changed
+        _entries[i].size = size;
+        _entries[i].etag = (size <= FS_INDEX_ETAG_SIZE) ? hash_file (name) : 0;
+        return true;
+    }
+    if (_count == _capacity) {
+        if ((_capacity > (0xFFFF - FS_INDEX_BLOCK)) || (ESP.getFreeHeap() < (FS_INDEX_HEAP_RESERVE + FS_INDEX_BLOCK * sizeof (fs_index_entry_t)))) {
+            return false;
+        }
+        fs_index_entry_t * entries = (fs_index_entry_t *) realloc (_entries, (_capacity + FS_INDEX_BLOCK) * sizeof (fs_index_entry_t));
+        if (!entries) {
+            return false;
+        }
+        _entries = entries;
+        _capacity += FS_INDEX_BLOCK;
+    }
+    memmove (&_entries[i + 1], &_entries[i], (_count - i) * sizeof (fs_index_entry_t));
+    strcpy (_entries[i].name, name);
+    _entries[i].size = size;
+    _entries[i].etag = (size <= FS_INDEX_ETAG_SIZE) ? hash_file (name) : 0;
+    _count++;
+    return true;
+}
+
+void FS_INDEX::remove (const char * name)
+{
+    uint16_t i = lower_bound (name);
+    if ((i < _count) && (strcmp (_entries[i].name, name) == 0)) {
+        memmove (&_entries[i], &_entries[i + 1], (_count - i - 1) * sizeof (fs_index_entry_t));
+        _count--;
+    }
+}
+
+//go back to SPIFFS scan
+void FS_INDEX::end()
+{
+    free (_entries);
+    _entries = NULL;
+    _count = 0;
+    _capacity = 0;
+    _started = false;
+}
+#endif //FS_INDEX_FEATURE
+
+bool FS_INDEX::begin()
+{
+#ifdef FS_INDEX_FEATURE
+    end();
+    _started = true;
+    _missing = 0;
+    //once heap is full, only count files which do not fit
+    uint16_t missing = 0;
+#if defined (ARDUINO_ARCH_ESP8266)
+    FS_DIR dir = SPIFFS.openDir ("/");
+    while (dir.next()) {
+        if ((missing > 0) || !set (dir.fileName().c_str(), dir.fileSize())) {
+            missing++;
+        }
+    }
+#else
+    FS_FILE root = SPIFFS.open ("/");
+    FS_FILE file = root.openNextFile();
+    while (file) {
+        if ((missing > 0) || !set (file.name(), file.size())) {
+            missing++;
+        }
+        file = root.openNextFile();
+    }
+#endif
+    if (missing > 0) {
+        LOG ("FS index: too many files\r\n")
+        end();
+        _missing = missing;
+    }
+    return _started;
+#else
+    return false;
+#endif
+}
+
+bool FS_INDEX::started()
+{
+#ifdef FS_INDEX_FEATURE
+    return _started;
+#else
+    return false;
+#endif
+}
+
+uint16_t FS_INDEX::count()
+{
+#ifdef FS_INDEX_FEATURE
+    return _count;
+#else
+    return 0;
+#endif
+}
+
+void FS_INDEX::update (const char * name)
+{
+#ifdef FS_INDEX_FEATURE
+    if (!_started) {
+        //index is rebuilt when files which did not fit are removed
+        if ((_missing > 0) && !SPIFFS.exists (name)) {
+            _missing--;
+            if (_missing == 0) {
+                begin();
+            }
+        }
+        return;
+    }
+    if (SPIFFS.exists (name)) {
+        uint32_t size = 0;
+        FS_FILE f = SPIFFS.open (name, SPIFFS_FILE_READ);
+        if (f) {
+            size = f.size();
+            f.close();
+        }
+        if (!set (name, size)) {
+            LOG ("FS index: too many files\r\n")
+            end();
+            _missing = 1;
+        }
+    } else {
+        remove (name);
+    }
+#ifdef FS_INDEX_CHECK
+    if (check() != 0) {
+        LOG ("FS index: mismatch after ")
+        LOG (name)
+        LOG ("\r\n")
+    }
+#endif
+#endif
+}
+
+void FS_INDEX::list (const String & path, JSON_WRITER & writer)
+{
+#ifdef FS_INDEX_FEATURE
+    if (_started) {
+        bool first = true;
+        size_t plen = path.length();
+        char lastdir[FS_INDEX_NAME_SIZE] = "";
+        for (uint16_t i = lower_bound (path.c_str()); (i < _count) && (strncmp (_entries[i].name, path.c_str(), plen) == 0); i++) {
+#ifdef CONFIG_JOURNAL_FEATURE
+            if (CONFIG_JOURNAL::is_journal (_entries[i].name)) {
+                continue;
+            }
+#endif
+            const char * name = _entries[i].name + plen;
+            const char * slash = strchr (name, '/');
+            if (slash) {
+                //files of a subdirectory follow each other, directory is shown once
+                size_t len = slash - name;
+                if ((len == 0) || ((strncmp (lastdir, name, len) == 0) && (lastdir[len] == 0))) {
+                    continue;
+                }
+                memcpy (lastdir, name, len);
+                lastdir[len] = 0;
+                print_entry (writer, first, lastdir, "-1");
+            } else if ((name[0] != 0) && (strcmp (name, ".") != 0)) {
+                print_entry (writer, first, name, CONFIG::formatBytes (_entries[i].size).c_str());
+            }
+        }
+        return;
+    }
+#endif
+    scan_list (path, writer);
+}
+
+bool FS_INDEX::is_empty (const String & path)
+{
+#ifdef FS_INDEX_FEATURE
+    if (_started) {
+        uint16_t i = lower_bound (path.c_str());
+        return !((i < _count) && (strncmp (_entries[i].name, path.c_str(), path.length()) == 0));
+    }
+#endif
+#if defined (ARDUINO_ARCH_ESP8266)
+    FS_DIR dir = SPIFFS.openDir (path);
+    return !dir.next();
+#else
+    String ptmp = path;
+    if ((path != "/") && (path[path.length() - 1] == '/')) {
+        ptmp = path.substring (0, path.length() - 1);
+    }
+    FS_FILE dir = SPIFFS.open (ptmp);
+    FS_FILE dircontent = dir.openNextFile();
+    return !dircontent;
+#endif
+}
+
+uint16_t FS_INDEX::check()
+{
+    uint16_t diff = 0;
+#ifdef FS_INDEX_FEATURE
+    if (!_started) {
+        return 0;
+    }
+    uint16_t found = 0;
+#if defined (ARDUINO_ARCH_ESP8266)
+    FS_DIR dir = SPIFFS.openDir ("/");
+    while (dir.next()) {
+        String name = dir.fileName();
+        uint32_t size = dir.fileSize();
+#else
+    FS_FILE root = SPIFFS.open ("/");
+    FS_FILE file = root.openNextFile();
+    while (file) {
+        String name = file.name();
+        uint32_t size = file.size();
+        file = root.openNextFile();
+#endif
+        uint16_t i = lower_bound (name.c_str());
+        if ((i < _count) && (name == _entries[i].name)) {
+            found++;
+            if (_entries[i].size != size) {
+                diff++;
+            }
+        } else {
+            diff++;
+        }
+    }
+    //entries of removed files
+    diff += _count - found;
+#endif
+    return diff;
+}
+
+uint32_t FS_INDEX::etag (const char * name)
+{
+#ifdef FS_INDEX_FEATURE
+    if (!_started) {
+        return 0;
+    }
+    uint16_t i = lower_bound (name);
+    if ((i == _count) || (strcmp (_entries[i].name, name) != 0)) {
+        return 0;
+    }
+    if (_entries[i].etag == 0) {
+        _entries[i].etag = hash_file (name);
+    }
+    return _entries[i].etag;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,78 @@
+/*
+  fsindex.h - ESP3D SPIFFS files index class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FSINDEX_H
+#define FSINDEX_H
+#include <Arduino.h>
+#include "config.h"
+#include "jsonwriter.h"
+
+//entries are allocated by blocks, index grows while this heap stays free
+#define FS_INDEX_BLOCK 16
+#define FS_INDEX_HEAP_RESERVE 16384
+//SPIFFS names are 31 chars max
+#define FS_INDEX_NAME_SIZE 32
+//files up to this size are hashed when indexed (boot, update), bigger ones on first etag() request
+#define FS_INDEX_ETAG_SIZE 262144
+
+typedef struct {
+    char name[FS_INDEX_NAME_SIZE];
+    uint32_t size;
+    //content hash, 0 if not yet computed
+    uint32_t etag;
+} fs_index_entry_t;
+
+//SPIFFS has no directories, names are full paths
+//index keeps them sorted so one directory is a contiguous range of entries
+//it is built at boot and each change of SPIFFS must call update()
+//without index (feature off or not enough heap), SPIFFS is scanned as before
+//and index is built again once enough files are removed
+class FS_INDEX
+{
+public:
+    static bool begin();
+    static bool started();
+    static uint16_t count();
+    //file was created, written or removed
+    static void update (const char * name);
+    //list one level of path (ending with /) as JSON entries
+    static void list (const String & path, JSON_WRITER & writer);
+    static bool is_empty (const String & path);
+    //number of differences between index and SPIFFS
+    static uint16_t check();
+    //content hash computed once per file version, 0 if file is not indexed
+    //for files bigger than FS_INDEX_ETAG_SIZE, first call reads whole file
+    static uint32_t etag (const char * name);
+private:
+#ifdef FS_INDEX_FEATURE
+    static fs_index_entry_t * _entries;
+    static uint16_t _count;
+    static uint16_t _capacity;
+    static bool _started;
+    //files to remove before index can fit in heap again
+    static uint16_t _missing;
+    static uint16_t lower_bound (const char * name);
+    static bool set (const char * name, uint32_t size);
+    static void remove (const char * name);
+    static void end();
+#endif
+};
+
+#endif
@@ -0,0 +1,458 @@
+/*
+  gcode_stream.cpp - ESP3D windowed gcode streaming class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "gcode_stream.h"
+#include "espcom.h"
+#include "marlin_binary.h"
+#include "cmdqueue.h"
+#include "telemetry.h"
+
+extern uint8_t Checksum(const char * line, uint16_t lineSize);
+
+bool GCODE_STREAM::_active = false;
+bool GCODE_STREAM::_error = false;
+uint8_t GCODE_STREAM::_window = DEFAULT_STREAM_WINDOW;
+bool GCODE_STREAM::_advanced_ok = false;
+uint8_t GCODE_STREAM::_advanced_limit = DEFAULT_STREAM_WINDOW;
+uint8_t GCODE_STREAM::_in_flight = 0;
+uint8_t GCODE_STREAM::_grbl_len[GRBL_FIFO_SIZE];
+uint8_t GCODE_STREAM::_grbl_head = 0;
+uint8_t GCODE_STREAM::_grbl_count = 0;
+uint16_t GCODE_STREAM::_grbl_bytes = 0;
+uint8_t GCODE_STREAM::_resend_ignore = 0;
+int32_t GCODE_STREAM::_last_queued = 0;
+int32_t GCODE_STREAM::_next_send = 1;
+uint32_t GCODE_STREAM::_last_answer = 0;
+uint32_t GCODE_STREAM::_start_time = 0;
+size_t GCODE_STREAM::_answer_pos = 0;
+char GCODE_STREAM::_answer[STREAM_ANSWER_SIZE + 1];
+int32_t GCODE_STREAM::_ring_line[STREAM_RING_SIZE];
+char GCODE_STREAM::_ring[STREAM_RING_SIZE][STREAM_LINE_SIZE];
+uint32_t GCODE_STREAM::lines_sent = 0;
+uint32_t GCODE_STREAM::lines_resent = 0;
+
+//window size is a setting, it should match printer BUFSIZE (Marlin default is 4)
+uint8_t GCODE_STREAM::get_window()
+{
+    byte b = DEFAULT_STREAM_WINDOW;
+    if (!CONFIG::read_byte (EP_STREAM_WINDOW, &b) || (b == 0) || (b > MAX_STREAM_WINDOW)) {
+        b = DEFAULT_STREAM_WINDOW;
+    }
+    return b;
+}
+
+//reset printer credits, to be called when settings change
+void GCODE_STREAM::init_credit()
+{
+    _window = get_window();
+    _advanced_ok = false;
+    _advanced_limit = _window;
+    _in_flight = 0;
+    _grbl_count = 0;
+    _grbl_bytes = 0;
+    _answer_pos = 0;
+    _last_answer = millis();
+}
+
+//lines the printer can accept without waiting an ok
+uint8_t GCODE_STREAM::credit_limit()
+{
+    return _advanced_ok ? _advanced_limit : _window;
+}
+
+//len is the size of the line to send, without end of line
+bool GCODE_STREAM::has_credit (size_t len)
+{
+    //an ok may be lost or printer reset, so do not wait forever
+    if ((_in_flight > 0) && ((millis() - _last_answer) > CREDIT_TIMEOUT)) {
+        log_esp3d("Credits lost, reset");
+        _in_flight = 0;
+        _grbl_count = 0;
+        _grbl_bytes = 0;
+        _last_answer = millis();
+    }
+    if (CONFIG::GetFirmwareTarget() == GRBL) {
+        if (_grbl_count == 0) {
+            return true;
+        }
+        return (_grbl_count < GRBL_FIFO_SIZE) && ((_grbl_bytes + len + 1) <= GRBL_RX_BUFFER_SIZE);
+    }
+    return _in_flight < credit_limit();
+}
+
+//one line was processed by printer
+void GCODE_STREAM::release_credit()
+{
+    if (_in_flight > 0) {
+        _in_flight--;
+    }
+    if (_grbl_count > 0) {
+        _grbl_bytes -= _grbl_len[_grbl_head];
+        _grbl_head = (_grbl_head + 1) % GRBL_FIFO_SIZE;
+        _grbl_count--;
+    }
+}
+
+//len is the size of the line, without end of line
+void GCODE_STREAM::count_line (size_t len)
+{
+    _in_flight++;
+    if ((CONFIG::GetFirmwareTarget() == GRBL) && (_grbl_count < GRBL_FIFO_SIZE)) {
+        _grbl_len[(_grbl_head + _grbl_count) % GRBL_FIFO_SIZE] = len + 1;
+        _grbl_bytes += len + 1;
+        _grbl_count++;
+    }
+}
+
+//printer does not answer to empty or comment only lines
+bool GCODE_STREAM::is_gcode_line (const char * line, size_t len)
+{
+    size_t i = 0;
+    while ((i < len) && (line[i] == ' ')) {
+        i++;
+    }
+    return (i < len) && (line[i] != ';');
+}
+
+//send unnumbered lines (macro, web command) to printer when it has free slots
+//answers are read by ESPCOM::processFromSerial which updates credits
+bool GCODE_STREAM::send_line (const char * line, uint32_t timeout)
+{
+    bool is_grbl = (CONFIG::GetFirmwareTarget() == GRBL);
+    if (is_grbl && GRBLCOM::is_realtime (line)) {
+        GRBLCOM::send_realtime (line[0]);
+        return true;
+    }
+    //serial is owned by the ongoing stream or binary transfer
+    if (_active || MARLIN_BINARY::is_active()) {
+        return false;
+    }
+    const char * start = line;
+    while (*start) {
+        const char * end = strchr (start, '\n');
+        size_t len = end ? (size_t) (end - start) : strlen (start);
+        if ((len > 0) && (start[len - 1] == '\r')) {
+            len--;
+        }
+        if (len >= STREAM_LINE_SIZE) {
+            log_esp3d("Line too long");
+            return false;
+        }
+        if (is_gcode_line (start, len)) {
+            uint32_t wait_start = millis();
+            //printer needs a free slot and the ack needs a queue entry
+            while (!has_credit (len) || !CMD_QUEUE::can_add_line()) {
+                ESPCOM::processFromSerial();
+                if ((millis() - wait_start) > timeout) {
+                    log_esp3d("No credit to send line");
+                    return false;
+                }
+                CONFIG::wait (0);
+            }
+            char tmp[STREAM_LINE_SIZE];
+            memcpy (tmp, start, len);
+            tmp[len] = '\0';
+            ESPCOM::println (tmp, DEFAULT_PRINTER_PIPE);
+            count_line (len);
+            //printer ack will be matched to line origin
+            CMD_QUEUE::add_line();
+        }
+        if (!end) {
+            break;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+//first_line is the number of the first line that will be pushed
+bool GCODE_STREAM::begin (int32_t first_line, uint8_t window)
+{
+    if (window == 0) {
+        window = get_window();
+    }
+    if (window > MAX_STREAM_WINDOW) {
+        window = MAX_STREAM_WINDOW;
+    }
+    _window = window;
+    _in_flight = 0;
+    //stream reads printer answers itself so waiting commands acks are lost
+    CMD_QUEUE::clear();
+    _resend_ignore = 0;
+    _last_queued = first_line - 1;
+    _next_send = first_line;
+    _answer_pos = 0;
+    _error = false;
+    for (uint8_t i = 0; i < STREAM_RING_SIZE; i++) {
+        _ring_line[i] = -1;
+    }
+    lines_sent = 0;
+    lines_resent = 0;
+    _start_time = millis();
+    _last_answer = _start_time;
+    _active = true;
+    log_esp3d("Stream start at %d, window %d", first_line, _window);
+    return true;
+}
+
+//return next line number to use
+int32_t GCODE_STREAM::end()
+{
+    if (_active) {
+        uint32_t duration = millis() - _start_time;
+        log_esp3d("Stream end: %d lines, %d resent, %d ms", lines_sent, lines_resent, duration);
+        (void) duration;
+    }
+    _active = false;
+    return _last_queued + 1;
+}
+
+//queue a line and send it as soon as the window allows it
+bool GCODE_STREAM::push (const char * line)
+{
+    if (!_active || _error) {
+        return false;
+    }
+    //wait all previous lines are sent and there is a free slot in window
+    if (!wait_for_slot (STREAM_TIMEOUT)) {
+        return false;
+    }
+    int32_t linenb = _last_queued + 1;
+    char * slot = _ring[linenb & (STREAM_RING_SIZE - 1)];
+#ifdef DISABLE_SERIAL_CHECKSUM
+    int len = snprintf (slot, STREAM_LINE_SIZE, "%s", line);
+#else
+    int len = snprintf (slot, STREAM_LINE_SIZE, "N%ld %s", (long) linenb, line);
+    if ((len > 0) && (len < (STREAM_LINE_SIZE - 5))) {
+        uint8_t crc = Checksum (slot, len);
+        len += snprintf (&slot[len], STREAM_LINE_SIZE - len, "*%d", crc);
+    }
+#endif
+    if ((len <= 0) || (len >= STREAM_LINE_SIZE)) {
+        log_esp3d("Line too long");
+        _error = true;
+        return false;
+    }
+    _ring_line[linenb & (STREAM_RING_SIZE - 1)] = linenb;
+    _last_queued = linenb;
+    send_pending();
+    return !_error;
+}
+
+//wait until all lines are acknowledged
+bool GCODE_STREAM::flush (uint32_t timeout)
+{
+    if (!_active) {
+        return false;
+    }
+    _last_answer = millis();
+    while (!_error && ((_in_flight > 0) || (_next_send <= _last_queued))) {
+        poll();
+        send_pending();
+        if ((millis() - _last_answer) > timeout) {
+            log_esp3d("Stream flush timeout");
+            _error = true;
+        }
+        CONFIG::wait (0);
+    }
+    return !_error;
+}
+
+bool GCODE_STREAM::wait_for_slot (uint32_t timeout)
+{
+    _last_answer = millis();
+    poll();
+    send_pending();
+    while (!_error && ((_next_send <= _last_queued) || (_in_flight >= credit_limit()))) {
+        CONFIG::wait (0);
+        poll();
+        send_pending();
+        if ((millis() - _last_answer) > timeout) {
+            log_esp3d("Stream timeout");
+            _error = true;
+        }
+    }
+    return !_error;
+}
+
+//send queued lines (new or requested again) while window allows it
+void GCODE_STREAM::send_pending()
+{
+    while (!_error && (_next_send <= _last_queued) && (_in_flight < credit_limit())) {
+        transmit (_next_send);
+        _next_send++;
+    }
+}
+
+void GCODE_STREAM::transmit (int32_t linenb)
+{
+    uint8_t index = linenb & (STREAM_RING_SIZE - 1);
+    if (_ring_line[index] != linenb) {
+        log_esp3d("Line %d not in ring", linenb);
+        _error = true;
+        return;
+    }
+    ESPCOM::println (_ring[index], DEFAULT_PRINTER_PIPE);
+    _in_flight++;
+    lines_sent++;
+}
+
+//read printer answers without blocking
+void GCODE_STREAM::poll()
+{
+    uint8_t buf[64];
+    //emergency commands must not wait end of stream
+    ESPCOM::poll_urgent();
+    while (ESPCOM::available (DEFAULT_PRINTER_PIPE) > 0) {
+        size_t len = ESPCOM::available (DEFAULT_PRINTER_PIPE);
+        if (len > sizeof (buf)) {
+            len = sizeof (buf);
+        }
+        len = ESPCOM::readBytes (DEFAULT_PRINTER_PIPE, buf, len);
+        feed (buf, len);
+    }
+}
+
+//parse printer answers of the stream to track credits, data is not consumed
+void GCODE_STREAM::feed (const uint8_t * buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if ((buf[i] == '\n') || (buf[i] == '\r')) {
+            if (_answer_pos > 0) {
+                _answer[_answer_pos] = '\0';
+                process_answer (_answer);
+                _answer_pos = 0;
+            }
+        } else if (_answer_pos < STREAM_ANSWER_SIZE) {
+            _answer[_answer_pos++] = buf[i];
+        }
+    }
+}
+
+//value of ADVANCED_OK field: ok N10 P15 B3
+int32_t GCODE_STREAM::get_ok_value (const char * answer, char code)
+{
+    for (const char * pos = answer; *pos; pos++) {
+        if ((pos[0] == ' ') && (pos[1] == code) && isdigit (pos[2])) {
+            return atol (&pos[2]);
+        }
+    }
+    return -1;
+}
+
+int32_t GCODE_STREAM::get_resend_line (const char * answer)
+{
+    const char * pos = NULL;
+    if (CONFIG::GetFirmwareTarget() == SMOOTHIEWARE) {
+        pos = strstr (answer, "rs N");
+        if (pos) {
+            pos += 4;
+        }
+    } else {
+        pos = strstr (answer, "Resend:");
+        if (pos) {
+            pos += 7;
+        }
+    }
+    if (!pos) {
+        return -1;
+    }
+    while (*pos == ' ') {
+        pos++;
+    }
+    if (!isdigit (*pos)) {
+        return -1;
+    }
+    return atol (pos);
+}
+
+void GCODE_STREAM::process_answer (const char * answer, bool credit)
+{
+    //stream reads answers itself, so keep telemetry up to date
+    if (_active) {
+        TELEMETRY::parse (answer, strlen (answer));
+    }
+    //every line sent get one ok, even the rejected ones
+    //grbl answers error instead of ok
+    if ((strncmp (answer, "ok", 2) == 0) || ((strncmp (answer, "error", 5) == 0) && (CONFIG::GetFirmwareTarget() == GRBL))) {
+        //only answers to sent lines prove credits are still right,
+        //autoreported temperatures must not hide a lost ok
+        _last_answer = millis();
+        if (credit) {
+            release_credit();
+        }
+        if (_resend_ignore > 0) {
+            _resend_ignore--;
+        }
+        int32_t free_slots = get_ok_value (answer, 'B');
+        if (free_slots >= 0) {
+            //lines still in printer RX buffer are not counted in B yet,
+            //so B is the most that can be in flight without overflowing command buffer
+            if (free_slots < 1) {
+                free_slots = 1;
+            }
+            if (free_slots > MAX_STREAM_WINDOW) {
+                free_slots = MAX_STREAM_WINDOW;
+            }
+            _advanced_ok = true;
+            _advanced_limit = free_slots;
+        }
+        return;
+    }
+    if ((answer[0] == '<') && (CONFIG::GetFirmwareTarget() == GRBL)) {
+        GRBLCOM::parse_status (answer);
+        return;
+    }
+    //repetier sends wait when its buffer is empty
+    if (strcmp (answer, "wait") == 0) {
+        _last_answer = millis();
+        _in_flight = 0;
+        return;
+    }
+    int32_t linenb = get_resend_line (answer);
+    if (linenb == -1) {
+        //temperatures, echo... are not answers to a line, but busy means
+        //printer is still working on one, so its ok is not lost
+        if (strstr (answer, "busy:")) {
+            _last_answer = millis();
+        }
+        return;
+    }
+    _last_answer = millis();
+    //lines sent before the previous resend are rejected too, no need to rewind again
+    if (_resend_ignore > 0) {
+        log_esp3d("Resend %d ignored", linenb);
+        return;
+    }
+    log_esp3d("Resend %d requested", linenb);
+    if ((linenb > _last_queued) || ((_last_queued - linenb) >= STREAM_RING_SIZE) || (_ring_line[linenb & (STREAM_RING_SIZE - 1)] != linenb)) {
+        log_esp3d("Line %d cannot be resent", linenb);
+        _error = true;
+        return;
+    }
+    lines_resent += _next_send - linenb;
+    //all lines currently in flight will be rejected and acknowledged
+    _resend_ignore = _in_flight;
+    _next_send = linenb;
+}
+
+#endif //USE_AS_UPDATER_ONLY
@@ -0,0 +1,98 @@
+/*
+  gcode_stream.h - ESP3D windowed gcode streaming class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef GCODE_STREAM_H
+#define GCODE_STREAM_H
+#include <Arduino.h>
+#include "config.h"
+#include "grblcom.h"
+
+//number of sent lines kept for resend, must be a power of 2 and bigger than the window
+#define STREAM_RING_SIZE 8
+//max size of a line once numbered and checksumed: N<line> <gcode>*<crc>
+#define STREAM_LINE_SIZE 248
+//max size of a printer answer we need to parse
+#define STREAM_ANSWER_SIZE 96
+//time without any answer from printer before declaring the stream failed
+#define STREAM_TIMEOUT 2000
+//time without any answer from printer before considering credits are lost
+#define CREDIT_TIMEOUT 10000
+//max grbl lines in flight, a line is at least 2 chars + \n
+#define GRBL_FIFO_SIZE 32
+
+//send checksumed lines to printer keeping several lines in flight
+//instead of waiting "ok" for each line
+//lines in flight are limited by printer free slots if it reports them (ADVANCED_OK)
+//or by a fixed window
+//for grbl the chars in flight are counted to fill its RX buffer
+class GCODE_STREAM
+{
+public:
+    static void init_credit();
+    static bool send_line (const char * line, uint32_t timeout = CREDIT_TIMEOUT);
+    //a line was written to printer outside send_line (emergency lane), its ack releases the credit
+    static void count_line (size_t len);
+    static void feed (const uint8_t * buf, size_t len);
+    static bool has_credit (size_t len = 0);
+    static uint8_t credit_limit();
+    static bool begin (int32_t first_line, uint8_t window = 0);
+    static bool push (const char * line);
+    static bool flush (uint32_t timeout = STREAM_TIMEOUT);
+    static int32_t end();
+    static void poll();
+    //credit is false for acks of lines ESP3D did not send (tcp host)
+    static void process_answer (const char * answer, bool credit = true);
+    static bool is_active()
+    {
+        return _active;
+    };
+    static uint8_t get_window();
+    static uint32_t lines_sent;
+    static uint32_t lines_resent;
+private:
+    static bool _active;
+    static bool _error;
+    static uint8_t _window;
+    static bool _advanced_ok;
+    static uint8_t _advanced_limit;
+    static uint8_t _in_flight;
+    static uint8_t _grbl_len[GRBL_FIFO_SIZE];
+    static uint8_t _grbl_head;
+    static uint8_t _grbl_count;
+    static uint16_t _grbl_bytes;
+    static uint8_t _resend_ignore;
+    static int32_t _last_queued;
+    static int32_t _next_send;
+    static uint32_t _last_answer;
+    static uint32_t _start_time;
+    static size_t _answer_pos;
+    static char _answer[STREAM_ANSWER_SIZE + 1];
+    static int32_t _ring_line[STREAM_RING_SIZE];
+    static char _ring[STREAM_RING_SIZE][STREAM_LINE_SIZE];
+    static void send_pending();
+    static bool wait_for_slot (uint32_t timeout);
+    static void transmit (int32_t linenb);
+    static int32_t get_resend_line (const char * answer);
+    static int32_t get_ok_value (const char * answer, char code);
+    static bool is_gcode_line (const char * line, size_t len);
+    static void release_credit();
+};
+
+#endif
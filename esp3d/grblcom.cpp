@@ -0,0 +1,155 @@
+/*
+  grblcom.cpp - ESP3D grbl communication class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "grblcom.h"
+#include "espcom.h"
+#include "gcode_stream.h"
+#include "cmdqueue.h"
+
+grbl_status_t GRBLCOM::status = {"", {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, 0, 0, -1, -1, 0};
+
+//real time commands are single chars executed by grbl as soon as received
+//? status, ! feed hold, ~ cycle start, 0x18 reset, >= 0x80 grbl 1.1 overrides
+bool GRBLCOM::is_realtime (const char * line)
+{
+    if ((line[0] == '\0') || (line[1] != '\0')) {
+        return false;
+    }
+    uint8_t c = line[0];
+    return (c == '?') || (c == '!') || (c == '~') || (c == 0x18) || (c >= 0x80);
+}
+
+//real time commands do not use grbl RX buffer so they bypass any queue
+void GRBLCOM::send_realtime (uint8_t c)
+{
+    ESPCOM::write (DEFAULT_PRINTER_PIPE, c);
+    //soft reset empties grbl RX buffer: lines sent will never get their ok
+    if (c == 0x18) {
+        GCODE_STREAM::init_credit();
+        CMD_QUEUE::clear();
+    }
+}
+
+//field value if any: grbl 1.1 uses | as separator, grbl 0.9 uses ,
+const char * GRBLCOM::get_field (const char * report, const char * name)
+{
+    const char * pos = strstr (report, name);
+    while (pos) {
+        if ((pos[-1] == '|') || (pos[-1] == ',')) {
+            return pos + strlen (name);
+        }
+        pos = strstr (pos + 1, name);
+    }
+    return NULL;
+}
+
+//read comma separated values, return how many were read
+uint8_t GRBLCOM::get_values (const char * pos, float * values, uint8_t nb)
+{
+    uint8_t i = 0;
+    while (pos && (i < nb)) {
+        char * end;
+        float v = strtod (pos, &end);
+        if (end == pos) {
+            break;
+        }
+        values[i++] = v;
+        if (*end != ',') {
+            break;
+        }
+        pos = end + 1;
+    }
+    return i;
+}
+
+bool GRBLCOM::parse_status (const char * report)
+{
+    if (report[0] != '<') {
+        return false;
+    }
+    uint8_t i = 0;
+    const char * pos = &report[1];
+    while (pos[i] && (pos[i] != '|') && (pos[i] != ',') && (pos[i] != '>') && (i < (GRBL_STATE_SIZE - 1))) {
+        status.state[i] = pos[i];
+        i++;
+    }
+    status.state[i] = '\0';
+    float values[2];
+    bool has_mpos = (get_values (get_field (report, "MPos:"), status.mpos, GRBL_AXIS_NB) == GRBL_AXIS_NB);
+    bool has_wpos = (get_values (get_field (report, "WPos:"), status.wpos, GRBL_AXIS_NB) == GRBL_AXIS_NB);
+    //WCO is only sent from time to time, keep last one
+    get_values (get_field (report, "WCO:"), status.wco, GRBL_AXIS_NB);
+    for (i = 0; i < GRBL_AXIS_NB; i++) {
+        if (has_mpos && !has_wpos) {
+            status.wpos[i] = status.mpos[i] - status.wco[i];
+        } else if (has_wpos && !has_mpos) {
+            status.mpos[i] = status.wpos[i] + status.wco[i];
+        }
+    }
+    uint8_t nb = get_values (get_field (report, "FS:"), values, 2);
+    if (nb == 0) {
+        nb = get_values (get_field (report, "F:"), values, 1);
+    }
+    if (nb > 0) {
+        status.feed = values[0];
+    }
+    if (nb > 1) {
+        status.spindle = values[1];
+    }
+    if (get_values (get_field (report, "Bf:"), values, 2) == 2) {
+        status.planner_free = values[0];
+        status.rx_free = values[1];
+    }
+    status.last_update = millis();
+    return true;
+}
+
+static String axis_values (float * values)
+{
+    String s = "[";
+    for (uint8_t i = 0; i < GRBL_AXIS_NB; i++) {
+        if (i > 0) {
+            s += ",";
+        }
+        s += String (values[i], 3);
+    }
+    return s + "]";
+}
+
+//last status report, age is in ms, -1 if never received
+String GRBLCOM::json()
+{
+    String s = "{\"state\":\"";
+    s += status.state;
+    s += "\",\"mpos\":" + axis_values (status.mpos);
+    s += ",\"wpos\":" + axis_values (status.wpos);
+    s += ",\"feed\":" + String (status.feed, 0);
+    s += ",\"spindle\":" + String (status.spindle, 0);
+    s += ",\"planner_free\":" + String (status.planner_free);
+    s += ",\"rx_free\":" + String (status.rx_free);
+    s += ",\"age\":";
+    s += (status.last_update == 0) ? String ("-1") : String (millis() - status.last_update);
+    s += "}";
+    return s;
+}
+
+#endif //USE_AS_UPDATER_ONLY
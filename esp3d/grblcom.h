@@ -0,0 +1,57 @@
+/*
+  grblcom.h - ESP3D grbl communication class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef GRBLCOM_H
+#define GRBLCOM_H
+#include <Arduino.h>
+#include "config.h"
+
+//size of grbl serial RX buffer used for character counting
+#define GRBL_RX_BUFFER_SIZE 128
+#define GRBL_STATE_SIZE 12
+#define GRBL_AXIS_NB 3
+
+//last status report <Idle|MPos:0.000,0.000,0.000|FS:0,0>
+typedef struct {
+    char state[GRBL_STATE_SIZE];
+    float mpos[GRBL_AXIS_NB];
+    float wpos[GRBL_AXIS_NB];
+    float wco[GRBL_AXIS_NB];
+    float feed;
+    float spindle;
+    int16_t planner_free; //-1 if not reported
+    int16_t rx_free; //-1 if not reported
+    uint32_t last_update; //0 if never received
+} grbl_status_t;
+
+class GRBLCOM
+{
+public:
+    static grbl_status_t status;
+    static bool parse_status (const char * report);
+    static String json();
+    static bool is_realtime (const char * line);
+    static void send_realtime (uint8_t c);
+private:
+    static const char * get_field (const char * report, const char * name);
+    static uint8_t get_values (const char * pos, float * values, uint8_t nb);
+};
+
+#endif
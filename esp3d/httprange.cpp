@@ -0,0 +1,92 @@
+/*
+  httprange.cpp - ESP3D http Range header class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "httprange.h"
+
+//read decimal number of Range header, false if no digit, too big values are saturated
+bool HTTP_RANGE::number (const char * & p, uint32_t & value)
+{
+    if (!isdigit (*p)) {
+        return false;
+    }
+    value = 0;
+    while (isdigit (*p)) {
+        value = (value > 0x0FFFFFFF) ? 0xFFFFFFFF : (value * 10) + (*p - '0');
+        p++;
+    }
+    return true;
+}
+
+int8_t HTTP_RANGE::parse (const char * header, uint32_t size, uint32_t & first, uint32_t & last)
+{
+    if (strncmp (header, "bytes=", 6) != 0) {
+        return RANGE_WHOLE_FILE;
+    }
+    const char * p = header + 6;
+    //multiple ranges are not supported, whole file is sent
+    if (strchr (p, ',') != NULL) {
+        return RANGE_WHOLE_FILE;
+    }
+    while (*p == ' ') {
+        p++;
+    }
+    if (*p == '-') {
+        p++;
+        uint32_t suffix;
+        if (!number (p, suffix) ) {
+            return RANGE_WHOLE_FILE;
+        }
+        if ((suffix == 0) || (size == 0)) {
+            return RANGE_NOT_SATISFIABLE;
+        }
+        first = (suffix >= size) ? 0 : size - suffix;
+        last = size - 1;
+        return RANGE_PARTIAL;
+    }
+    if (!number (p, first) || (*p != '-')) {
+        return RANGE_WHOLE_FILE;
+    }
+    p++;
+    if (isdigit (*p)) {
+        if (!number (p, last) || (last < first)) {
+            return RANGE_WHOLE_FILE;
+        }
+    } else {
+        last = 0xFFFFFFFF;
+    }
+    if (first >= size) {
+        return RANGE_NOT_SATISFIABLE;
+    }
+    if (last >= size) {
+        last = size - 1;
+    }
+    return RANGE_PARTIAL;
+}
+
+bool HTTP_RANGE::applies (const char * range, const char * if_range, const char * etag)
+{
+    if (range[0] == 0) {
+        return false;
+    }
+    if (if_range[0] == 0) {
+        return true;
+    }
+    return (etag[0] != 0) && (strcmp (if_range, etag) == 0);
+}
@@ -0,0 +1,46 @@
+/*
+  httprange.h - ESP3D http Range header class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef HTTPRANGE_H
+#define HTTPRANGE_H
+#include <Arduino.h>
+
+//bytes read from file and written to client at once for Range requests
+#define RANGE_CHUNK_SIZE 512
+
+//results of parse()
+#define RANGE_WHOLE_FILE 0
+#define RANGE_PARTIAL 1
+#define RANGE_NOT_SATISFIABLE -1
+
+//single range of RFC 7233, multiple ranges are answered with whole file
+class HTTP_RANGE
+{
+public:
+    //"bytes=first-last", "bytes=first-" or "bytes=-suffix" of file of size bytes
+    static int8_t parse (const char * header, uint32_t size, uint32_t & first, uint32_t & last);
+    //Range is used if there is no If-Range or if it is current ETag,
+    //dates and weak ETags never match as no Last-Modified is sent
+    static bool applies (const char * range, const char * if_range, const char * etag);
+private:
+    static bool number (const char * & p, uint32_t & value);
+};
+
+#endif
@@ -0,0 +1,202 @@
+/*
+  jsonwriter.cpp - ESP3D buffered output writer class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include "jsonwriter.h"
+#include "espcom.h"
+#if !defined (ASYNCWEBSERVER)
+#include "webinterface.h"
+#endif
+
+JSON_WRITER::JSON_WRITER (tpipe output, ESPResponseStream  *espresponse)
+{
+    _len = 0;
+    _output = output;
+    _espresponse = espresponse;
+    _web = false;
+    //printer and screen handle each print as a message, so no buffering
+    _direct = (output == PRINTER_PIPE);
+#ifdef ESP_OLED_FEATURE
+    _direct = _direct || (output == OLED_PIPE);
+#endif
+}
+
+JSON_WRITER::~JSON_WRITER()
+{
+    flush();
+#if !defined (ASYNCWEBSERVER)
+    if (_web) {
+        //close chunked answer
+        web_interface->web_server.sendContent ("");
+    }
+#endif
+}
+
+#if !defined (ASYNCWEBSERVER)
+void JSON_WRITER::begin_web (int code, const char * content_type)
+{
+    flush();
+    _web = true;
+    _direct = false;
+    web_interface->web_server.setContentLength (CONTENT_LENGTH_UNKNOWN);
+    web_interface->web_server.sendHeader ("Cache-Control", "no-cache");
+    web_interface->web_server.send (code, content_type, "");
+}
+#endif
+
+void JSON_WRITER::flush()
+{
+    if (_len == 0) {
+        return;
+    }
+    _buffer[_len] = 0;
+#if !defined (ASYNCWEBSERVER)
+    if (_web) {
+        web_interface->web_server.sendContent_P (_buffer, _len);
+        _len = 0;
+        return;
+    }
+#endif
+    ESPCOM::print (_buffer, _output, _espresponse);
+    _len = 0;
+}
+
+void JSON_WRITER::print (char c)
+{
+    if (_direct) {
+        char tmp[2] = {c, 0};
+        ESPCOM::print (tmp, _output, _espresponse);
+        return;
+    }
+    if (_len == JSON_WRITER_BUFFER_SIZE) {
+        flush();
+    }
+    _buffer[_len++] = c;
+}
+
+void JSON_WRITER::print (const char * data)
+{
+    if (_direct) {
+        ESPCOM::print (data, _output, _espresponse);
+        return;
+    }
+    size_t len = strlen (data);
+    while (len > 0) {
+        if (_len == JSON_WRITER_BUFFER_SIZE) {
+            flush();
+        }
+        size_t n = JSON_WRITER_BUFFER_SIZE - _len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy (&_buffer[_len], data, n);
+        _len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void JSON_WRITER::print (const __FlashStringHelper * data)
+{
+    PGM_P p = (PGM_P) data;
+    if (_direct) {
+        String tmp = data;
+        ESPCOM::print (tmp.c_str(), _output, _espresponse);
+        return;
+    }
+    size_t len = strlen_P (p);
+    while (len > 0) {
+        if (_len == JSON_WRITER_BUFFER_SIZE) {
+            flush();
+        }
+        size_t n = JSON_WRITER_BUFFER_SIZE - _len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy_P (&_buffer[_len], p, n);
+        _len += n;
+        p += n;
+        len -= n;
+    }
+}
+
+void JSON_WRITER::print (const String & data)
+{
+    print (data.c_str());
+}
+
+void JSON_WRITER::newline()
+{
+#ifdef TCP_IP_DATA_FEATURE
+    print ("\r");
+#endif
+    print ("\n");
+}
+
+void JSON_WRITER::println (const __FlashStringHelper * data)
+{
+    print (data);
+    newline();
+}
+
+void JSON_WRITER::println (const char * data)
+{
+    print (data);
+    newline();
+}
+
+void JSON_WRITER::println (const String & data)
+{
+    print (data.c_str());
+    newline();
+}
+
+void JSON_WRITER::number (int32_t value)
+{
+    char tmp[12];
+    snprintf (tmp, sizeof (tmp), "%d", (int) value);
+    print (tmp);
+}
+
+//quotes are sent as html entities, empty value as a space (web UI expects it)
+void JSON_WRITER::escaped (const char * data)
+{
+    if (data[0] == 0) {
+        print (" ");
+        return;
+    }
+    if (_direct) {
+        //keep each value in one message
+        String tmp = data;
+        tmp.replace ("'", "&#39;");
+        tmp.replace ("\"", "&#34;");
+        ESPCOM::print (tmp.c_str(), _output, _espresponse);
+        return;
+    }
+    for (const char * p = data; *p; p++) {
+        if (*p == '\'') {
+            print ("&#39;");
+        } else if (*p == '"') {
+            print ("&#34;");
+        } else {
+            print (*p);
+        }
+    }
+}
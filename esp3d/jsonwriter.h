@@ -0,0 +1,61 @@
+/*
+  jsonwriter.h - ESP3D buffered output writer class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+#include <Arduino.h>
+#include "config.h"
+
+#define JSON_WRITER_BUFFER_SIZE 256
+
+//collect output in a fixed buffer and send it to the pipe by blocks
+//flash strings are copied directly, no String is created
+//buffer is sent when full, on flush() and when writer is destroyed
+//web answer ends when writer is destroyed
+class JSON_WRITER
+{
+public:
+    JSON_WRITER (tpipe output, ESPResponseStream  *espresponse = NULL);
+    ~JSON_WRITER();
+    void print (const __FlashStringHelper * data);
+    void print (const char * data);
+    void print (const String & data);
+    void print (char c);
+    void println (const __FlashStringHelper * data);
+    void println (const char * data);
+    void println (const String & data);
+    void number (int32_t value);
+    void escaped (const char * data);
+    void flush();
+#if !defined (ASYNCWEBSERVER)
+    //send answer to web client as chunked http, without ESPResponseStream buffer
+    void begin_web (int code, const char * content_type);
+#endif
+private:
+    char _buffer[JSON_WRITER_BUFFER_SIZE + 1];
+    size_t _len;
+    tpipe _output;
+    ESPResponseStream  * _espresponse;
+    bool _direct;
+    bool _web;
+    void newline();
+};
+
+#endif
@@ -0,0 +1,90 @@
+/*
+  lineframer.cpp - ESP3D line assembler class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "lineframer.h"
+
+LINE_FRAMER::LINE_FRAMER (size_t min_len, bool keep_comment)
+{
+    _min_len = min_len;
+    _keep_comment = keep_comment;
+    reset();
+}
+
+void LINE_FRAMER::reset()
+{
+    _len = 0;
+    _line[0] = '\0';
+    _previous_was_char = false;
+    _iscomment = false;
+    _overflow = false;
+}
+
+bool LINE_FRAMER::push (const uint8_t *& data, size_t & len)
+{
+    while (len > 0) {
+        //to ensure it is continuous string, no char separated by binaries
+        if (!_previous_was_char) {
+            _len = 0;
+            _iscomment = false;
+            _overflow = false;
+        }
+        //copy the run of printable chars until comment if any
+        size_t i = 0;
+        while ((i < len) && (data[i] >= 0x20) && (data[i] < 0x7F)) {
+            i++;
+        }
+        if (i > 0) {
+            _previous_was_char = true;
+            if (!_iscomment) {
+                size_t n = i;
+                const uint8_t * c = _keep_comment ? NULL : (const uint8_t *)memchr (data, ';', i);
+                if (c) {
+                    n = c - data;
+                    _iscomment = true;
+                }
+                if ((_len + n) > LINE_FRAMER_SIZE) {
+                    n = LINE_FRAMER_SIZE - _len;
+                    _overflow = true;
+                }
+                memcpy (&_line[_len], data, n);
+                _len += n;
+            }
+            data += i;
+            len -= i;
+            if (len == 0) {
+                break;
+            }
+        }
+        //this is not printable, next push will reset the line
+        uint8_t b = *data;
+        data++;
+        len--;
+        _previous_was_char = false;
+        //end of line, minimum for a command is something like M10 so 3 char
+        if ((b == 13) || (b == 10)) {
+            _iscomment = false;
+            if ((_len >= _min_len) && !_overflow) {
+                _line[_len] = '\0';
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+/*
+  lineframer.h - ESP3D line assembler class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef LINEFRAMER_H
+#define LINEFRAMER_H
+#include <Arduino.h>
+
+//max size of a line, longer lines are ignored
+#define LINE_FRAMER_SIZE 256
+
+//build lines from received data in a fixed buffer
+//a line is a continuous run of printable chars ended by \r or \n, comments (;) are removed unless kept
+class LINE_FRAMER
+{
+public:
+    LINE_FRAMER (size_t min_len = 4, bool keep_comment = false);
+    void reset();
+    //use data until a line is complete: return true and data/len point after the line end
+    //return false once all data are used
+    bool push (const uint8_t *& data, size_t & len);
+    //line stays valid until next push
+    const char * line()
+    {
+        return _line;
+    };
+    size_t length()
+    {
+        return _len;
+    };
+private:
+    char _line[LINE_FRAMER_SIZE + 1];
+    size_t _len;
+    size_t _min_len;
+    bool _keep_comment;
+    bool _previous_was_char;
+    bool _iscomment;
+    bool _overflow;
+};
+
+#endif
@@ -0,0 +1,484 @@
+/*
+  marlin_binary.cpp - ESP3D marlin binary file transfer class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "marlin_binary.h"
+#include "espcom.h"
+#include "cmdqueue.h"
+
+extern bool purge_serial();
+
+#define BINARY_TOKEN 0xB5AD
+#define PROTOCOL_CONTROL 0
+#define PROTOCOL_FILE 1
+#define CONTROL_SYNC 1
+#define CONTROL_CLOSE 2
+#define FILE_QUERY 0
+#define FILE_OPEN 1
+#define FILE_CLOSE 2
+#define FILE_WRITE 3
+#define FILE_ABORT 4
+
+#define HS_HASH(w, p) ((((w)[p] << 3) ^ (w)[(p) + 1]) & (HS_HASH_SIZE - 1))
+
+bool MARLIN_BINARY::_active = false;
+bool MARLIN_BINARY::_compression = false;
+uint8_t MARLIN_BINARY::_sync = 0;
+uint16_t MARLIN_BINARY::_block_size = BINARY_BLOCK_SIZE;
+uint16_t MARLIN_BINARY::_payload_size = 0;
+uint32_t MARLIN_BINARY::_start_time = 0;
+binary_buffer_t * MARLIN_BINARY::_buffer = NULL;
+char MARLIN_BINARY::_line[BINARY_LINE_SIZE + 1];
+size_t MARLIN_BINARY::_line_pos = 0;
+uint16_t MARLIN_BINARY::_hs_input = 0;
+uint16_t MARLIN_BINARY::_hs_history = 0;
+uint8_t MARLIN_BINARY::_bit_byte = 0;
+uint8_t MARLIN_BINARY::_bit_mask = 0x80;
+uint32_t MARLIN_BINARY::bytes_in = 0;
+uint32_t MARLIN_BINARY::bytes_sent = 0;
+
+//fletcher 16 as computed by marlin
+static uint16_t binary_checksum (const uint8_t * data, size_t len)
+{
+    uint16_t low = 0;
+    uint16_t high = 0;
+    for (size_t i = 0; i < len; i++) {
+        low = (low + data[i]) % 255;
+        high = (high + low) % 255;
+    }
+    return (high << 8) | low;
+}
+
+//firmware must report Cap:BINARY_FILE_TRANSFER:1 in M115 answer
+bool MARLIN_BINARY::is_supported()
+{
+    if ((CONFIG::GetFirmwareTarget() != MARLIN) && (CONFIG::GetFirmwareTarget() != MARLINKIMBRA)) {
+        return false;
+    }
+    bool supported = false;
+    purge_serial();
+    _line_pos = 0;
+    ESPCOM::println (F ("M115"), DEFAULT_PRINTER_PIPE);
+    while (read_line (BINARY_TIMEOUT)) {
+        if (strstr (_line, "Cap:BINARY_FILE_TRANSFER:1")) {
+            supported = true;
+        }
+        if (strncmp (_line, "ok", 2) == 0) {
+            break;
+        }
+    }
+    log_esp3d("Binary transfer %s", supported ? "supported" : "not supported");
+    return supported;
+}
+
+//read one printer answer, false if timeout
+bool MARLIN_BINARY::read_line (uint32_t timeout)
+{
+    uint32_t start = millis();
+    while ((millis() - start) < timeout) {
+        if (ESPCOM::available (DEFAULT_PRINTER_PIPE) > 0) {
+            uint8_t c;
+            ESPCOM::readBytes (DEFAULT_PRINTER_PIPE, &c, 1);
+            if ((c == '\n') || (c == '\r')) {
+                if (_line_pos > 0) {
+                    _line[_line_pos] = '\0';
+                    _line_pos = 0;
+                    return true;
+                }
+            } else if (_line_pos < BINARY_LINE_SIZE) {
+                _line[_line_pos++] = c;
+            }
+        } else {
+            //emergency commands must not wait end of transfer
+            ESPCOM::poll_urgent();
+            CONFIG::wait (0);
+        }
+    }
+    return false;
+}
+
+bool MARLIN_BINARY::wait_line (const char * prefix, uint32_t timeout)
+{
+    size_t len = strlen (prefix);
+    while (read_line (timeout)) {
+        if (strncmp (_line, prefix, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//payload must be already in packet buffer, return size of full packet
+size_t MARLIN_BINARY::build_packet (uint8_t protocol, uint8_t type, uint16_t len)
+{
+    uint8_t * p = _buffer->packet;
+    p[0] = BINARY_TOKEN & 0xFF;
+    p[1] = BINARY_TOKEN >> 8;
+    p[2] = _sync;
+    p[3] = (protocol << 4) | type;
+    p[4] = len & 0xFF;
+    p[5] = len >> 8;
+    //token is not part of checksums
+    uint16_t cs = binary_checksum (&p[2], 4);
+    p[6] = cs & 0xFF;
+    p[7] = cs >> 8;
+    if (len == 0) {
+        return BINARY_HEADER_SIZE;
+    }
+    //footer checksum covers header and payload
+    cs = binary_checksum (&p[2], BINARY_HEADER_SIZE - 2 + len);
+    p[BINARY_HEADER_SIZE + len] = cs & 0xFF;
+    p[BINARY_HEADER_SIZE + len + 1] = cs >> 8;
+    return BINARY_HEADER_SIZE + len + BINARY_FOOTER_SIZE;
+}
+
+void MARLIN_BINARY::write_packet (size_t size)
+{
+    //one serial write and one lock check for whole packet
+    ESPCOM::write (DEFAULT_PRINTER_PIPE, _buffer->packet, size);
+    bytes_sent += size;
+}
+
+//send packet and wait for ok<sync>, resend if requested or no answer
+bool MARLIN_BINARY::send_packet (uint8_t protocol, uint8_t type, uint16_t len)
+{
+    size_t size = build_packet (protocol, type, len);
+    for (uint8_t retry = 0; retry < BINARY_RETRY; retry++) {
+        write_packet (size);
+        while (read_line (BINARY_TIMEOUT)) {
+            if ((strncmp (_line, "ok", 2) == 0) && isdigit (_line[2])) {
+                if (atoi (&_line[2]) == _sync) {
+                    _sync++;
+                    return true;
+                }
+            } else if (strncmp (_line, "rs", 2) == 0) {
+                log_esp3d("Resend packet %d", _sync);
+                break;
+            } else if (strncmp (_line, "fe", 2) == 0) {
+                log_esp3d("Binary fatal error");
+                return false;
+            } else if (strncmp (_line, "PFT:ioerror", 11) == 0) {
+                log_esp3d("Binary io error");
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+//file command answered by PFT:success or PFT:fail/busy/ioerror
+bool MARLIN_BINARY::send_command (uint8_t protocol, uint8_t type, uint16_t len)
+{
+    if (!send_packet (protocol, type, len)) {
+        return false;
+    }
+    if (!wait_line ("PFT:", BINARY_FILE_TIMEOUT)) {
+        return false;
+    }
+    return (strcmp (_line, "PFT:success") == 0);
+}
+
+//go back to ascii protocol and release buffers
+void MARLIN_BINARY::close_binary()
+{
+    if (_buffer) {
+        send_packet (PROTOCOL_CONTROL, CONTROL_CLOSE, 0);
+        free (_buffer);
+        _buffer = NULL;
+    }
+    _active = false;
+}
+
+bool MARLIN_BINARY::begin (const char * filename)
+{
+    _active = false;
+    size_t name_len = strlen (filename);
+    if ((name_len + 3) > BINARY_BLOCK_SIZE) {
+        return false;
+    }
+    //transfer reads printer answers itself so waiting commands acks are lost
+    CMD_QUEUE::clear();
+    if (!is_supported()) {
+        return false;
+    }
+    _buffer = (binary_buffer_t *) malloc (sizeof (binary_buffer_t));
+    if (!_buffer) {
+        log_esp3d("Binary buffer allocation failed");
+        return false;
+    }
+    bytes_in = 0;
+    bytes_sent = 0;
+    ESPCOM::println (F ("M28B1"), DEFAULT_PRINTER_PIPE);
+    if (!wait_line ("ok", BINARY_TIMEOUT)) {
+        log_esp3d("Binary mode rejected");
+        free (_buffer);
+        _buffer = NULL;
+        return false;
+    }
+    //sync does not need right sync number and is answered by ss<sync>,<block size>,<version>
+    bool synced = false;
+    _sync = 0;
+    size_t size = build_packet (PROTOCOL_CONTROL, CONTROL_SYNC, 0);
+    for (uint8_t retry = 0; (retry < BINARY_RETRY) && !synced; retry++) {
+        write_packet (size);
+        synced = wait_line ("ss", BINARY_TIMEOUT);
+    }
+    if (!synced) {
+        log_esp3d("Binary sync failed");
+        close_binary();
+        return false;
+    }
+    _sync = atoi (&_line[2]);
+    _block_size = BINARY_BLOCK_SIZE;
+    const char * pos = strchr (_line, ',');
+    if (pos) {
+        int block = atoi (pos + 1);
+        if ((block > 0) && (block < BINARY_BLOCK_SIZE)) {
+            _block_size = block;
+        }
+    }
+    //compression is only used if printer decoder has same parameters
+    _compression = false;
+    if (send_packet (PROTOCOL_FILE, FILE_QUERY, 0) && wait_line ("PFT:version", BINARY_TIMEOUT)) {
+        pos = strstr (_line, "heatshrink,");
+        if (pos) {
+            pos += 11;
+            const char * pos2 = strchr (pos, ',');
+            if (pos2 && (atoi (pos) == HS_WINDOW_BITS) && (atoi (pos2 + 1) == HS_LOOKAHEAD_BITS)) {
+                _compression = true;
+            }
+        }
+    }
+    //open: dummy flag, compression flag, filename with ending 0
+    uint8_t * payload = &_buffer->packet[BINARY_HEADER_SIZE];
+    payload[0] = 0;
+    payload[1] = _compression ? 1 : 0;
+    memcpy (&payload[2], filename, name_len + 1);
+    if (!send_command (PROTOCOL_FILE, FILE_OPEN, name_len + 3)) {
+        log_esp3d("Binary open failed");
+        close_binary();
+        return false;
+    }
+    _payload_size = 0;
+    _hs_input = 0;
+    _hs_history = 0;
+    _bit_byte = 0;
+    _bit_mask = 0x80;
+    for (uint16_t i = 0; i < HS_HASH_SIZE; i++) {
+        _buffer->head[i] = -1;
+    }
+    _start_time = millis();
+    _active = true;
+    log_esp3d("Binary upload start, block %d, compression %d", _block_size, _compression);
+    return true;
+}
+
+bool MARLIN_BINARY::flush_payload()
+{
+    if (_payload_size == 0) {
+        return true;
+    }
+    bool res = send_packet (PROTOCOL_FILE, FILE_WRITE, _payload_size);
+    _payload_size = 0;
+    return res;
+}
+
+bool MARLIN_BINARY::push_byte (uint8_t b)
+{
+    _buffer->packet[BINARY_HEADER_SIZE + _payload_size++] = b;
+    if (_payload_size == _block_size) {
+        return flush_payload();
+    }
+    return true;
+}
+
+//heatshrink bits are sent msb first
+bool MARLIN_BINARY::push_bits (uint16_t bits, uint8_t count)
+{
+    while (count > 0) {
+        count--;
+        if ((bits >> count) & 0x01) {
+            _bit_byte |= _bit_mask;
+        }
+        _bit_mask >>= 1;
+        if (_bit_mask == 0) {
+            if (!push_byte (_bit_byte)) {
+                return false;
+            }
+            _bit_byte = 0;
+            _bit_mask = 0x80;
+        }
+    }
+    return true;
+}
+
+void MARLIN_BINARY::hash_insert (int16_t pos, uint8_t count, int16_t end)
+{
+    for (int16_t i = pos; (i < (pos + count)) && ((i + 1) < end); i++) {
+        uint8_t h = HS_HASH (_buffer->window, i);
+        _buffer->prev[i] = _buffer->head[h];
+        _buffer->head[h] = i;
+    }
+}
+
+//encode input half of window, first half is history for back references
+bool MARLIN_BINARY::compress_block()
+{
+    uint8_t * w = _buffer->window;
+    int16_t start = HS_WINDOW_SIZE - _hs_history;
+    int16_t end = HS_WINDOW_SIZE + _hs_input;
+    int16_t pos = HS_WINDOW_SIZE;
+    while (pos < end) {
+        uint8_t best_len = 0;
+        int16_t best_pos = 0;
+        int16_t max_len = end - pos;
+        if (max_len > HS_LOOKAHEAD_SIZE) {
+            max_len = HS_LOOKAHEAD_SIZE;
+        }
+        if (max_len > 1) {
+            int16_t candidate = _buffer->head[HS_HASH (w, pos)];
+            uint8_t chain = 0;
+            while ((candidate >= start) && ((pos - candidate) <= HS_WINDOW_SIZE) && (chain < HS_MAX_CHAIN)) {
+                uint8_t len = 0;
+                while ((len < max_len) && (w[candidate + len] == w[pos + len])) {
+                    len++;
+                }
+                if (len > best_len) {
+                    best_len = len;
+                    best_pos = candidate;
+                    if (len == max_len) {
+                        break;
+                    }
+                }
+                candidate = _buffer->prev[candidate];
+                chain++;
+            }
+        }
+        if (best_len > 1) {
+            //back reference: tag 0, offset - 1, length - 1
+            if (!push_bits (0, 1) || !push_bits (pos - best_pos - 1, HS_WINDOW_BITS) || !push_bits (best_len - 1, HS_LOOKAHEAD_BITS)) {
+                return false;
+            }
+        } else {
+            //literal: tag 1, byte
+            best_len = 1;
+            if (!push_bits (1, 1) || !push_bits (w[pos], 8)) {
+                return false;
+            }
+        }
+        hash_insert (pos, best_len, end);
+        pos += best_len;
+    }
+    return true;
+}
+
+//input becomes history, positions are moved accordingly
+void MARLIN_BINARY::shift_window()
+{
+    memcpy (_buffer->window, &_buffer->window[HS_WINDOW_SIZE], HS_WINDOW_SIZE);
+    for (uint16_t i = 0; i < HS_HASH_SIZE; i++) {
+        int16_t v = _buffer->head[i];
+        _buffer->head[i] = (v >= HS_WINDOW_SIZE) ? (v - HS_WINDOW_SIZE) : -1;
+    }
+    for (uint16_t i = 0; i < HS_WINDOW_SIZE; i++) {
+        int16_t v = _buffer->prev[i + HS_WINDOW_SIZE];
+        _buffer->prev[i] = (v >= HS_WINDOW_SIZE) ? (v - HS_WINDOW_SIZE) : -1;
+    }
+    _hs_history = HS_WINDOW_SIZE;
+    _hs_input = 0;
+}
+
+bool MARLIN_BINARY::write (const uint8_t * data, size_t len)
+{
+    if (!_active) {
+        return false;
+    }
+    bytes_in += len;
+    while (len > 0) {
+        size_t n;
+        if (_compression) {
+            n = HS_WINDOW_SIZE - _hs_input;
+            if (n > len) {
+                n = len;
+            }
+            memcpy (&_buffer->window[HS_WINDOW_SIZE + _hs_input], data, n);
+            _hs_input += n;
+            if (_hs_input == HS_WINDOW_SIZE) {
+                if (!compress_block()) {
+                    return false;
+                }
+                shift_window();
+            }
+        } else {
+            n = _block_size - _payload_size;
+            if (n > len) {
+                n = len;
+            }
+            memcpy (&_buffer->packet[BINARY_HEADER_SIZE + _payload_size], data, n);
+            _payload_size += n;
+            if ((_payload_size == _block_size) && !flush_payload()) {
+                return false;
+            }
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool MARLIN_BINARY::end()
+{
+    if (!_active) {
+        return false;
+    }
+    bool res = true;
+    if (_compression) {
+        res = compress_block();
+        //last byte is padded with 0, decoder ignores an incomplete back reference
+        if (res && (_bit_mask != 0x80)) {
+            res = push_byte (_bit_byte);
+        }
+    }
+    if (res) {
+        res = flush_payload();
+    }
+    if (res) {
+        res = send_command (PROTOCOL_FILE, FILE_CLOSE, 0);
+    } else {
+        send_command (PROTOCOL_FILE, FILE_ABORT, 0);
+    }
+    uint32_t duration = millis() - _start_time;
+    log_esp3d("Binary upload end: %d bytes, %d sent, %d ms, %d B/s", bytes_in, bytes_sent, duration, duration ? (bytes_in * 1000) / duration : 0);
+    (void) duration;
+    close_binary();
+    return res;
+}
+
+void MARLIN_BINARY::abort()
+{
+    if (!_active) {
+        return;
+    }
+    send_command (PROTOCOL_FILE, FILE_ABORT, 0);
+    close_binary();
+}
+
+#endif //USE_AS_UPDATER_ONLY
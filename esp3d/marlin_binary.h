@@ -0,0 +1,99 @@
+/*
+  marlin_binary.h - ESP3D marlin binary file transfer class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef MARLIN_BINARY_H
+#define MARLIN_BINARY_H
+#include <Arduino.h>
+#include "config.h"
+
+//packet: token(2) sync(1) protocol/type(1) size(2) header checksum(2) payload footer checksum(2)
+#define BINARY_HEADER_SIZE 8
+#define BINARY_FOOTER_SIZE 2
+//max payload we send, printer may ask for less
+#define BINARY_BLOCK_SIZE 512
+#define BINARY_TIMEOUT 1000
+//file open/close on SD can be slow
+#define BINARY_FILE_TIMEOUT 3000
+#define BINARY_RETRY 5
+#define BINARY_LINE_SIZE 96
+
+//heatshrink parameters used by marlin (window 8 bits, lookahead 4 bits)
+#define HS_WINDOW_BITS 8
+#define HS_LOOKAHEAD_BITS 4
+#define HS_WINDOW_SIZE (1 << HS_WINDOW_BITS)
+#define HS_LOOKAHEAD_SIZE (1 << HS_LOOKAHEAD_BITS)
+#define HS_HASH_SIZE 256
+#define HS_MAX_CHAIN 16
+
+//buffers are only allocated during transfer
+typedef struct {
+    uint8_t packet[BINARY_HEADER_SIZE + BINARY_BLOCK_SIZE + BINARY_FOOTER_SIZE];
+    uint8_t window[2 * HS_WINDOW_SIZE];
+    int16_t head[HS_HASH_SIZE];
+    int16_t prev[2 * HS_WINDOW_SIZE];
+} binary_buffer_t;
+
+//upload file to printer SD using BINARY_FILE_TRANSFER protocol
+//data can be compressed using heatshrink if printer supports it
+class MARLIN_BINARY
+{
+public:
+    static bool begin (const char * filename);
+    static bool write (const uint8_t * data, size_t len);
+    static bool end();
+    static void abort();
+    static bool is_active()
+    {
+        return _active;
+    };
+    static uint32_t bytes_in;
+    static uint32_t bytes_sent;
+private:
+    static bool _active;
+    static bool _compression;
+    static uint8_t _sync;
+    static uint16_t _block_size;
+    static uint16_t _payload_size;
+    static uint32_t _start_time;
+    static binary_buffer_t * _buffer;
+    static char _line[BINARY_LINE_SIZE + 1];
+    static size_t _line_pos;
+    //heatshrink encoder state
+    static uint16_t _hs_input;
+    static uint16_t _hs_history;
+    static uint8_t _bit_byte;
+    static uint8_t _bit_mask;
+    static bool is_supported();
+    static bool read_line (uint32_t timeout);
+    static bool wait_line (const char * prefix, uint32_t timeout);
+    static size_t build_packet (uint8_t protocol, uint8_t type, uint16_t len);
+    static void write_packet (size_t size);
+    static bool send_packet (uint8_t protocol, uint8_t type, uint16_t len);
+    static bool send_command (uint8_t protocol, uint8_t type, uint16_t len);
+    static void close_binary();
+    static bool push_byte (uint8_t b);
+    static bool push_bits (uint16_t bits, uint8_t count);
+    static bool flush_payload();
+    static bool compress_block();
+    static void hash_insert (int16_t pos, uint8_t count, int16_t end);
+    static void shift_window();
+};
+
+#endif
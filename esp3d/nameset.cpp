@@ -0,0 +1,87 @@
+/*
+  nameset.cpp - ESP3D small set of names class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "nameset.h"
+
+NAME_SET::NAME_SET()
+{
+    _count = 0;
+    memset (_hashes, 0, sizeof (_hashes));
+    _names = "*";
+}
+
+uint32_t NAME_SET::fnv (uint32_t h, const uint8_t * data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+uint32_t NAME_SET::hash (const char * name, size_t len)
+{
+    uint32_t h = fnv (NAME_SET_FNV_BASIS, (const uint8_t *) name, len);
+    //0 means empty slot
+    return (h == 0) ? 1 : h;
+}
+
+bool NAME_SET::same (uint16_t pos, const char * name, size_t len) const
+{
+    return (strncmp (_names.c_str() + pos, name, len) == 0) && (_names[pos + len] == '*');
+}
+
+void NAME_SET::keep (const char * name, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        _names += name[i];
+    }
+    _names += '*';
+}
+
+bool NAME_SET::add (const char * name, size_t len)
+{
+    if (_count == NAME_SET_SIZE) {
+        String tag = "*";
+        for (size_t i = 0; i < len; i++) {
+            tag += name[i];
+        }
+        tag += '*';
+        if (_names.indexOf (tag) > -1) {
+            return false;
+        }
+        keep (name, len);
+        return true;
+    }
+    uint32_t h = hash (name, len);
+    uint8_t i = h & (NAME_SET_SIZE - 1);
+    while (_hashes[i] != 0) {
+        //different names may have same hash
+        if ((_hashes[i] == h) && same (_pos[i], name, len)) {
+            return false;
+        }
+        i = (i + 1) & (NAME_SET_SIZE - 1);
+    }
+    _hashes[i] = h;
+    _pos[i] = _names.length();
+    _count++;
+    keep (name, len);
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+  nameset.h - ESP3D small set of names class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef NAMESET_H
+#define NAMESET_H
+#include <Arduino.h>
+
+//names kept in set, must be a power of 2
+#define NAME_SET_SIZE 64
+#define NAME_SET_FNV_BASIS 2166136261UL
+
+//fixed set of names hashes (FNV-1a) to find duplicates quickly
+//names are kept as "*name1*name2*" so a hash match is confirmed on the name itself,
+//when set is full, names are searched in this list as listings did before
+class NAME_SET
+{
+public:
+    NAME_SET();
+    //false if name is already in set
+    bool add (const char * name, size_t len);
+    static uint32_t hash (const char * name, size_t len);
+    //FNV-1a by parts, start with NAME_SET_FNV_BASIS
+    static uint32_t fnv (uint32_t h, const uint8_t * data, size_t len);
+private:
+    uint32_t _hashes[NAME_SET_SIZE];
+    //position of each name in _names
+    uint16_t _pos[NAME_SET_SIZE];
+    uint8_t _count;
+    String _names;
+    bool same (uint16_t pos, const char * name, size_t len) const;
+    void keep (const char * name, size_t len);
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+  ringbuffer.h - ESP3D ring buffer class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+#include <Arduino.h>
+
+//statically allocated ring with one writer and several readers
+//head only grows, each reader keeps its own cursor (position already read)
+//writer never waits: a reader too slow loses oldest data
+template <size_t SIZE> class RING_BUFFER
+{
+    static_assert ((SIZE != 0) && ((SIZE & (SIZE - 1)) == 0), "ring size must be a power of two");
+public:
+    RING_BUFFER()
+    {
+        _head = 0;
+    }
+    //writer: contiguous free space at head, data must be committed once written
+    size_t write_span (uint8_t ** p)
+    {
+        size_t pos = _head & (SIZE - 1);
+        *p = &_data[pos];
+        return SIZE - pos;
+    }
+    void commit (size_t len)
+    {
+        //data must be visible before head moves
+        __sync_synchronize();
+        _head += len;
+    }
+    uint32_t head()
+    {
+        return _head;
+    }
+    //reader: new cursor only sees data written from now
+    uint32_t cursor()
+    {
+        return _head;
+    }
+    size_t available (uint32_t cursor)
+    {
+        uint32_t n = _head - cursor;
+        return (n > SIZE) ? SIZE : n;
+    }
+    //reader: contiguous data at cursor, return 0 if nothing to read
+    //if reader was overrun the cursor jumps to oldest data and lost bytes are returned in *lost
+    size_t peek (uint32_t & cursor, uint8_t ** p, uint32_t * lost = NULL)
+    {
+        uint32_t h = _head;
+        __sync_synchronize();
+        uint32_t n = h - cursor;
+        if (n > SIZE) {
+            if (lost) {
+                *lost += n - SIZE;
+            }
+            cursor = h - SIZE;
+            n = SIZE;
+        }
+        size_t pos = cursor & (SIZE - 1);
+        *p = &_data[pos];
+        if (n > SIZE - pos) {
+            n = SIZE - pos;
+        }
+        return n;
+    }
+    void consume (uint32_t & cursor, size_t len)
+    {
+        cursor += len;
+    }
+    //reader: copy data at cursor
+    size_t read (uint32_t & cursor, uint8_t * buf, size_t len, uint32_t * lost = NULL)
+    {
+        size_t done = 0;
+        uint8_t * p;
+        while (done < len) {
+            size_t n = peek (cursor, &p, lost);
+            if (n == 0) {
+                break;
+            }
+            if (n > len - done) {
+                n = len - done;
+            }
+            memcpy (&buf[done], p, n);
+            consume (cursor, n);
+            done += n;
+        }
+        return done;
+    }
+private:
+    uint8_t _data[SIZE];
+    volatile uint32_t _head;
+};
+
+#endif
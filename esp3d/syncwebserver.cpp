@@ -47,6 +47,20 @@
 #include "GenLinkedList.h"
 #include "command.h"
 #include "espcom.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "gcode_stream.h"
+#include "marlin_binary.h"
+#include "cmdqueue.h"
+#include "telemetry.h"
+#include "autoreport.h"
+#include "webjobs.h"
+#endif
+#include "jsonwriter.h"
+#include "fsindex.h"
+#include "httprange.h"
+#ifdef CONFIG_JOURNAL_FEATURE
+#include "configjournal.h"
+#endif
 
 #ifdef SSDP_FEATURE
 #ifdef ARDUINO_ARCH_ESP32
@@ -59,7 +73,10 @@
 //embedded response file if no files on SPIFFS
 #include "nofile.h"
 #include "syncwebserver.h"
-WebSocketsServer * socket_server;
+#ifdef AUTHENTICATION_FEATURE
+#include "authcache.h"
+#endif
+WEBSOCKET_SERVER_CLASS * socket_server;
 
 
 #define ESP_ERROR_AUTHENTICATION 1
@@ -114,12 +131,28 @@ void cancelUpload(){
     }
 }
 
+//the websocket library blocks until a frame is written, so room is checked before
+size_t WEBSOCKET_SERVER_CLASS::availableForWrite (uint8_t num)
+{
+    if ((num >= WEBSOCKETS_SERVER_CLIENT_MAX) || !clientIsConnected (&_clients[num])) {
+        return 0;
+    }
+    return ESPCOM::write_room (*_clients[num].tcp);
+}
+
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length)
 {
 
     switch(type) {
     case WStype_DISCONNECTED:
         //USE_SERIAL.printf("[%u] Disconnected!\n", num);
+#ifdef WS_DATA_FEATURE
+        ESPCOM::subscribeWS (num, false);
+#endif
+#ifndef USE_AS_UPDATER_ONLY
+        AUTOREPORT::subscribe (num, 0);
+        WEB_JOBS::drop_client (num);
+#endif
         break;
     case WStype_CONNECTED: {
         IPAddress ip = socket_server->remoteIP(num);
@@ -127,6 +160,9 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length
         String s = "CURRENT_ID:" + String(num);
         // send message to client
         ESPCOM::current_socket_id = num;
+#ifdef WS_DATA_FEATURE
+        ESPCOM::subscribeWS (num, true);
+#endif
         socket_server->sendTXT(ESPCOM::current_socket_id, s);
         s = "ACTIVE_ID:" + String(ESPCOM::current_socket_id);
         socket_server->broadcastTXT(s);
@@ -134,6 +170,12 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length
     break;
     case WStype_TEXT:
         //USE_SERIAL.printf("[%u] get Text: %s\n", num, payload);
+#ifndef USE_AS_UPDATER_ONLY
+        //TELEMETRY:<ms> to get printer values at this rate, TELEMETRY:0 to stop
+        if ((length > 10) && (strncmp ((const char *) payload, "TELEMETRY:", 10) == 0)) {
+            AUTOREPORT::subscribe (num, atol ((const char *) payload + 10));
+        }
+#endif
 
         // send message to client
         // webSocket.sendTXT(num, "message here");
@@ -166,6 +208,83 @@ const uint8_t PAGE_CAPTIVE [] PROGMEM = "<HTML>\n<HEAD>\n<title>Captive Portal</
 
 //Root of Webserver/////////////////////////////////////////////////////
 
+//send validators, true if browser already has this version (304 is sent)
+static bool not_modified (const char * etag, const char * cache_control)
+{
+    web_interface->web_server.sendHeader("ETag", etag);
+    web_interface->web_server.sendHeader("Cache-Control", cache_control);
+    if (web_interface->web_server.header("If-None-Match").indexOf(etag) != -1) {
+        web_interface->web_server.send(304);
+        return true;
+    }
+    return false;
+}
+
+//send part of an opened file as 206 Partial Content
+static void send_file_range (FS_FILE & file, const String & path, const String & contentType, uint32_t first, uint32_t last)
+{
+    String content_range = "bytes " + String(first) + "-" + String(last) + "/" + String((uint32_t)file.size());
+    web_interface->web_server.sendHeader("Content-Range", content_range);
+    if (path.endsWith(".gz") && (contentType != "application/octet-stream") && (contentType != "application/x-gzip")) {
+        web_interface->web_server.sendHeader("Content-Encoding", "gzip");
+    }
+    web_interface->web_server.setContentLength(last - first + 1);
+    web_interface->web_server.send(206, contentType, "");
+    if (!file.seek(first, SeekSet)) {
+        return;
+    }
+    uint8_t buf[RANGE_CHUNK_SIZE];
+    uint32_t left = last - first + 1;
+    while (left > 0) {
+        size_t len = file.read(buf, (left > RANGE_CHUNK_SIZE) ? RANGE_CHUNK_SIZE : left);
+        if (len == 0) {
+            break;
+        }
+        //client is gone
+        if (web_interface->web_server.client().write(buf, len) != len) {
+            break;
+        }
+        left -= len;
+        CONFIG::wdtFeed();
+    }
+}
+
+//send SPIFFS file, with ETag if file is indexed and only requested part if any
+static void send_spiffs_file (const String & path, const String & contentType)
+{
+    uint32_t hash = FS_INDEX::etag(path.c_str());
+    char etag[11] = "";
+    if (hash != 0) {
+        snprintf(etag, sizeof(etag), "\"%08x\"", hash);
+        if (not_modified(etag, web_interface->getCacheControl(path))) {
+            return;
+        }
+    }
+    FS_FILE file = SPIFFS.open(path, SPIFFS_FILE_READ);
+    web_interface->web_server.sendHeader("Accept-Ranges", "bytes");
+    String range = web_interface->web_server.header("Range");
+    String if_range = web_interface->web_server.header("If-Range");
+    //If-Range must match current version, else whole file is sent
+    if (HTTP_RANGE::applies(range.c_str(), if_range.c_str(), etag)) {
+        uint32_t first = 0;
+        uint32_t last = 0;
+        int8_t res = HTTP_RANGE::parse(range.c_str(), file.size(), first, last);
+        if (res == RANGE_NOT_SATISFIABLE) {
+            web_interface->web_server.sendHeader("Content-Range", "bytes */" + String((uint32_t)file.size()));
+            web_interface->web_server.send(416);
+            file.close();
+            return;
+        }
+        if (res == RANGE_PARTIAL) {
+            send_file_range(file, path, contentType, first, last);
+            file.close();
+            return;
+        }
+    }
+    web_interface->web_server.streamFile(file, contentType);
+    file.close();
+}
+
 void handle_web_interface_root()
 {
     String path = "/index.html";
@@ -176,12 +295,13 @@ void handle_web_interface_root()
         if(SPIFFS.exists(pathWithGz)) {
             path = pathWithGz;
         }
-        FS_FILE file = SPIFFS.open(path, SPIFFS_FILE_READ);
-        web_interface->web_server.streamFile(file, contentType);
-        file.close();
+        send_spiffs_file(path, contentType);
         return;
     }
     //if no lets launch the default content
+    if (not_modified(PAGE_NOFILES_ETAG, WEB_CACHE_CONTROL)) {
+        return;
+    }
     web_interface->web_server.sendHeader("Content-Encoding", "gzip");
     web_interface->web_server.send_P(200,CONTENT_TYPE_HTML,PAGE_NOFILES,PAGE_NOFILES_SIZE);
 }
@@ -237,24 +357,10 @@ void handle_login()
             if (msg_alert_error == false) {
                 //Password
                 sPassword = web_interface->web_server.arg("PASSWORD");
-                String sadminPassword;
-
-                if (!CONFIG::read_string(EP_ADMIN_PWD, sadminPassword, MAX_LOCAL_PASSWORD_LENGTH)) {
-                    sadminPassword=FPSTR(DEFAULT_ADMIN_PWD);
-                }
-
-                String suserPassword;
-
-                if (!CONFIG::read_string(EP_USER_PWD, suserPassword, MAX_LOCAL_PASSWORD_LENGTH)) {
-                    suserPassword=FPSTR(DEFAULT_USER_PWD);
-                }
-
-                if(!(((sUser==FPSTR(DEFAULT_ADMIN_LOGIN)) && (strcmp(sPassword.c_str(),sadminPassword.c_str())==0)) ||
-                        ((sUser==FPSTR(DEFAULT_USER_LOGIN)) && (strcmp(sPassword.c_str(),suserPassword.c_str()) == 0)))) {
+                if(!(((sUser==FPSTR(DEFAULT_ADMIN_LOGIN)) && AUTH_CACHE::is_admin (sPassword.c_str(), sPassword.length())) ||
+                        ((sUser==FPSTR(DEFAULT_USER_LOGIN)) && AUTH_CACHE::is_user (sPassword.c_str(), sPassword.length())))) {
                     msg_alert_error=true;
                     smsg=F("Error: Incorrect password");
-                    Serial.println(sPassword.c_str());
-                    Serial.println(sadminPassword.c_str());
                     code = 401;
                 }
             }
@@ -411,26 +517,21 @@ void handleFileList()
             filename.replace ("//","/");
             if (!SPIFFS.exists (filename)) {
                 status = shortname + F(" does not exists!");
+#ifdef CONFIG_JOURNAL_FEATURE
+            } else if (CONFIG_JOURNAL::is_journal (filename.c_str())) {
+                status = shortname + F(" does not exists!");
+#endif
             } else {
                 if (SPIFFS.remove(filename)) {
                     status = shortname + F(" deleted");
+                    FS_INDEX::update (filename.c_str());
                     //what happen if no "/." and no other subfiles ?
-#if defined(ARDUINO_ARCH_ESP8266)
-                    FS_DIR dir = SPIFFS.openDir(path);
-                    if (!dir.next()) {
-#else
-                    String ptmp = path;
-                    if ( (path != "/") && (path[path.length() - 1] = '/') ) {
-                        ptmp = path.substring (0, path.length() - 1);
-                    }
-                    FS_FILE dir = SPIFFS.open (ptmp);
-                    FS_FILE dircontent = dir.openNextFile();
-                    if (!dircontent) {
-#endif
+                    if (FS_INDEX::is_empty (path)) {
                         //keep directory alive even empty
                         FS_FILE r = SPIFFS.open (path+"/.", SPIFFS_FILE_WRITE);
                         if (r) {
                             r.close();
+                            FS_INDEX::update ((path+"/.").c_str());
                         }
                     }
                 } else {
@@ -463,12 +564,21 @@ void handleFileList()
                         String fullpath = dir.fileName();
 #else
                         String fullpath = file2deleted.name();
+#endif
+#ifdef CONFIG_JOURNAL_FEATURE
+                        if (CONFIG_JOURNAL::is_journal (fullpath.c_str())) {
+#if defined(ARDUINO_ARCH_ESP32)
+                            file2deleted = dir.openNextFile();
+#endif
+                            continue;
+                        }
 #endif
                         if (!SPIFFS.remove(fullpath)) {
                             delete_error = true;
                             status = F("Cannot deleted ") ;
                             status+=fullpath;
                         }
+                        FS_INDEX::update (fullpath.c_str());
 #if defined(ARDUINO_ARCH_ESP32)
                         file2deleted = dir.openNextFile();
 #endif
@@ -496,87 +606,21 @@ void handleFileList()
                     status += shortname ;
                 } else {
                     r.close();
+                    FS_INDEX::update (filename.c_str());
                     status = shortname + F(" created");
                 }
             }
         }
     }
-    String jsonfile = "{";
-#if defined ( ARDUINO_ARCH_ESP8266 )
-    FS_DIR dir = SPIFFS.openDir(path);
-#else
-    String ptmp = path;
-    if ( (path != "/") && (path[path.length() - 1] = '/') ) {
-        ptmp = path.substring (0, path.length() - 1);
-    }
-    FS_FILE dir = SPIFFS.open(ptmp);
-#endif
-    jsonfile+="\"files\":[";
-    bool firstentry=true;
-    String subdirlist="";
-#if defined ( ARDUINO_ARCH_ESP8266 )
-    while (dir.next()) {
-        String filename = dir.fileName();
-#else
-    File fileparsed = dir.openNextFile();
-    while (fileparsed) {
-        String filename = fileparsed.name();
-#endif
-        String size ="";
-        bool addtolist=true;
-        //remove path from name
-        filename = filename.substring(path.length(),filename.length());
-        //check if file or subfile
-        if (filename.indexOf("/")>-1) {
-            //Do not rely on "/." to define directory as SPIFFS upload won't create it but directly files
-            //and no need to overload SPIFFS if not necessary to create "/." if no need
-            //it will reduce SPIFFS available space so limit it to creation
-            filename = filename.substring(0,filename.indexOf("/"));
-            String tag="*";
-            tag += filename + "*";
-            if (subdirlist.indexOf(tag)>-1 || filename.length()==0) { //already in list
-                addtolist = false; //no need to add
-            } else {
-                size = -1; //it is subfile so display only directory, size will be -1 to describe it is directory
-                if (subdirlist.length()==0) {
-                    subdirlist+="*";
-                }
-                subdirlist += filename + "*"; //add to list
-            }
-        } else {
-            //do not add "." file
-            if (!((filename==".") || (filename==""))) {
-#if defined ( ARDUINO_ARCH_ESP8266)
-                size = CONFIG::formatBytes(dir.fileSize());
-#else
-                size = CONFIG::formatBytes(fileparsed.size());
-#endif
-
-            } else {
-                addtolist = false;
-            }
-        }
-        if(addtolist) {
-            if (!firstentry) {
-                jsonfile+=",";
-            } else {
-                firstentry=false;
-            }
-            jsonfile+="{";
-            jsonfile+="\"name\":\"";
-            jsonfile+=filename;
-            jsonfile+="\",\"size\":\"";
-            jsonfile+=size;
-            jsonfile+="\"";
-            jsonfile+="}";
-        }
-#ifdef ARDUINO_ARCH_ESP32
-        fileparsed = dir.openNextFile();
-#endif
-    }
-    jsonfile+="],";
-    jsonfile+="\"path\":\"" + path + "\",";
-    jsonfile+="\"status\":\"" + status + "\",";
+    //entries are sent while they are read
+    JSON_WRITER writer (WEB_PIPE);
+    writer.begin_web (200, "application/json");
+    writer.print (F ("{\"files\":["));
+    FS_INDEX::list (path, writer);
+    writer.print (F ("],\"path\":\""));
+    writer.print (path);
+    writer.print (F ("\",\"status\":\""));
+    writer.print (status);
     size_t totalBytes;
     size_t usedBytes;
 #if defined ( ARDUINO_ARCH_ESP8266)
@@ -588,15 +632,13 @@ void handleFileList()
     totalBytes = SPIFFS.totalBytes();
     usedBytes = SPIFFS.usedBytes();
 #endif
-    jsonfile+="\"total\":\"" + CONFIG::formatBytes(totalBytes) + "\",";
-    jsonfile+="\"used\":\"" + CONFIG::formatBytes(usedBytes) + "\",";
-    jsonfile.concat(F("\"occupation\":\""));
-    jsonfile+= CONFIG::intTostr(100*usedBytes/totalBytes);
-    jsonfile+="\"";
-    jsonfile+="}";
-    path = "";
-    web_interface->web_server.sendHeader("Cache-Control", "no-cache");
-    web_interface->web_server.send(200, "application/json", jsonfile);
+    writer.print (F ("\",\"total\":\""));
+    writer.print (CONFIG::formatBytes(totalBytes));
+    writer.print (F ("\",\"used\":\""));
+    writer.print (CONFIG::formatBytes(usedBytes));
+    writer.print (F ("\",\"occupation\":\""));
+    writer.print (CONFIG::intTostr(100*usedBytes/totalBytes));
+    writer.print (F ("\"}"));
     web_interface->_upload_status=UPLOAD_STATUS_NONE;
 }
 
@@ -629,6 +671,13 @@ void SPIFFSFileupload()
                     upload_filename = filename;
                     filename = "/user" + upload_filename;
                 }
+#ifdef CONFIG_JOURNAL_FEATURE
+                if (CONFIG_JOURNAL::is_journal (filename.c_str())) {
+                    web_interface->_upload_status=UPLOAD_STATUS_FAILED;
+                    pushError(ESP_ERROR_FILE_CREATION, "File creation failed");
+                    return;
+                }
+#endif
                 
                 if (SPIFFS.exists (filename) ) {
                     SPIFFS.remove (filename);
@@ -689,6 +738,9 @@ void SPIFFSFileupload()
                 if(fsUploadFile) {
                     //close it
                     fsUploadFile.close();
+                    FS_INDEX::update (filename.c_str());
+                    //web files validator is ready for first request
+                    FS_INDEX::etag (filename.c_str());
                     if (web_interface->_upload_status == UPLOAD_STATUS_ONGOING) {
                         web_interface->_upload_status = UPLOAD_STATUS_SUCCESSFUL;
                     }
@@ -712,6 +764,7 @@ void SPIFFSFileupload()
         cancelUpload();
         if (SPIFFS.exists (filename) ) {
             SPIFFS.remove (filename);
+            FS_INDEX::update (filename.c_str());
             }
     }
     CONFIG::wait(0);
@@ -855,13 +908,18 @@ void handle_not_found()
     String contentType =  web_interface->getContentType(path);
     String pathWithGz = path + ".gz";
     log_esp3d("Not found %s, type %s", path.c_str(), contentType.c_str());
-    if(SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) {
+#ifdef CONFIG_JOURNAL_FEATURE
+    //journal has all settings, passwords included
+    if (CONFIG_JOURNAL::is_journal (path.c_str())) {
+        path = "";
+        pathWithGz = "";
+    }
+#endif
+    if((path.length() > 0) && (SPIFFS.exists(pathWithGz) || SPIFFS.exists(path))) {
         if(SPIFFS.exists(pathWithGz)) {
             path = pathWithGz;
         }
-        FS_FILE file = SPIFFS.open(path, SPIFFS_FILE_READ);
-        web_interface->web_server.streamFile(file, contentType);
-        file.close();
+        send_spiffs_file(path, contentType);
         return;
     } else {
         page_not_found = true;
@@ -923,8 +981,39 @@ void handle_not_found()
 }
 
 //Handle web command query and send answer /////////////////////////////
+//an emergency stop may be waiting behind a command, so if another request comes
+//waiting for printer answer stops after this time (ms), late answers are lost
+#define WEB_COMMAND_YIELD_TIME 200
+//printer answers of a web command
+typedef struct {
+    String buffer;
+    int temp_counter;
+    uint32_t last_answer;
+} web_answer_t;
+
+static void web_command_answer (void * ctx, const char * line, size_t len)
+{
+    web_answer_t * answer = (web_answer_t *) ctx;
+    answer->last_answer = millis();
+    //it is sending too many temp status should be heating
+    if (COMMAND::check_command (line, len, NO_PIPE, false, false)) {
+        answer->temp_counter++;
+    }
+    if ((CONFIG::GetFirmwareTarget()  == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV)) {
+        if ((len > 5) && (strncmp (line, "busy:", 5) == 0)) {
+            answer->temp_counter++;
+        }
+        if ((len >= 3) && (strncmp (line, "ok ", 3) == 0)) {
+            return;
+        }
+    }
+    answer->buffer += line;
+    answer->buffer += "\n";
+}
+
 void handle_web_command()
 {
+    uint32_t start_us = micros();
     level_authenticate_type auth_level= web_interface->is_authenticated();
     /*  if (auth_level == LEVEL_GUEST) {
           web_interface->web_server.send(403,"text/plain","Not allowed, log in first!\n");
@@ -933,6 +1022,25 @@ void handle_web_command()
     String buffer2send = "";
     ESPResponseStream espresponse;
     String cmd = "";
+#ifndef USE_AS_UPDATER_ONLY
+    //answer of a command sent with async
+    if (web_interface->web_server.hasArg("job")) {
+        if (auth_level == LEVEL_GUEST) {
+            web_interface->web_server.send(401,"text/plain","Authentication failed!\n");
+            return;
+        }
+        web_interface->web_server.sendHeader("Cache-Control","no-cache");
+        web_job_state_t state = WEB_JOBS::fetch (web_interface->web_server.arg("job").toInt(), buffer2send);
+        if (state == JOB_DONE) {
+            web_interface->web_server.send(200,"text/plain",buffer2send);
+        } else if (state == JOB_FREE) {
+            web_interface->web_server.send(404,"text/plain","Unknown job");
+        } else {
+            web_interface->web_server.send(202,"text/plain","Running");
+        }
+        return;
+    }
+#endif
     if (web_interface->web_server.hasArg("plain") || web_interface->web_server.hasArg("commandText")) {
         if (web_interface->web_server.hasArg("plain")) {
             cmd = web_interface->web_server.arg("plain");
@@ -976,135 +1084,77 @@ void handle_web_command()
             web_interface->web_server.send(401,"text/plain","Authentication failed!\n");
             return;
         }
+        //emergency and grbl real time commands must not wait
+        if (ESPCOM::is_urgent (cmd.c_str())) {
+            if (ESPCOM::send_urgent (cmd.c_str(), start_us)) {
+                web_interface->web_server.send(200,"text/plain","ok");
+            } else {
+                web_interface->web_server.send(200,"text/plain","Serial is busy, retry later!");
+            }
+            return;
+        }
         //send command to serial as no need to transfer ESP command
         //to avoid any pollution if Uploading file to SDCard
         if ((web_interface->blockserial) == false) {
-            //block every query
-            web_interface->blockserial = true;
-            log_esp3d("Block Serial");
-            //empty the serial buffer and incoming data
-            log_esp3d("Start PurgeSerial");
-            if(ESPCOM::available(DEFAULT_PRINTER_PIPE)) {
-                ESPCOM::bridge();
-                CONFIG::wait(1);
+#ifndef USE_AS_UPDATER_ONLY
+            //do not wait printer, answer is pushed on websocket or fetched with job=<id>
+            if (web_interface->web_server.hasArg("async")) {
+                uint8_t client = WEB_JOBS_NO_CLIENT;
+                if (web_interface->web_server.hasArg("ws") && (web_interface->web_server.arg("ws").toInt() < MAX_WS_CLIENTS)) {
+                    client = web_interface->web_server.arg("ws").toInt();
+                }
+                uint16_t id = WEB_JOBS::start (cmd.c_str(), client);
+                web_interface->web_server.sendHeader("Cache-Control","no-cache");
+                if (id == 0) {
+                    web_interface->web_server.send(200,"text/plain","Printer is busy, retry later!");
+                } else {
+                    web_interface->web_server.send(202,"application/json","{\"job\":" + String(id) + "}");
+                }
+                return;
             }
-            log_esp3d("End PurgeSerial");
+#endif
             web_interface->web_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
             web_interface->web_server.sendHeader("Content-Type","text/plain",true);
             web_interface->web_server.sendHeader("Cache-Control","no-cache");
             web_interface->web_server.send(200);
-            //send command
-            log_esp3d("Start PurgeSerial");
-            if(ESPCOM::available(DEFAULT_PRINTER_PIPE)) {
-                ESPCOM::bridge();
-                CONFIG::wait(1);
-            }
-            log_esp3d("End PurgeSerial");
-            ESPCOM::println (cmd, DEFAULT_PRINTER_PIPE);
-            bool done = false;
-            String current_buffer;
-            String current_line;
-            //int pos;
-            int temp_counter = 0;
-            String tmp;
+            //answers are matched to this command, other clients can send commands too
+            web_answer_t answer;
+            answer.temp_counter = 0;
+            answer.last_answer = millis();
+            uint16_t ticket = 0;
             bool datasent = false;
-            uint32_t timeout = millis();
-            //pickup the list
-            while ((millis() - timeout < 2000) && !done) {
-                //give some time between each buffer
-                if (ESPCOM::available(DEFAULT_PRINTER_PIPE)) {
-                    log_esp3d("Got data");
-                    timeout = millis();
-                    size_t len = ESPCOM::available(DEFAULT_PRINTER_PIPE);
-                    uint8_t sbuf[len+1];
-                    //read buffer
-                    ESPCOM::readBytes (DEFAULT_PRINTER_PIPE, sbuf, len);
-                    //change buffer as string
-                    sbuf[len]='\0';
-                    //add buffer to current one if any
-                    current_buffer += (char * ) sbuf;
-                    while (current_buffer.indexOf("\n") !=-1) {
-                        log_esp3d("Remove new line");
-                        //remove the possible "\r"
-                        current_buffer.replace("\r","");
-                        //get line
-                        current_line = current_buffer.substring(0,current_buffer.indexOf("\n"));
-                        //if line is command ack - just exit so save the time out period
-                        if ((current_line == "ok") || (current_line == "wait") || (current_line.startsWith("ok") && !((CONFIG::GetFirmwareTarget() == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV)))) {
-                            done = true;
-                            buffer2send +=current_line;
-                            log_esp3d("Found ok/wait add New buffer %s", buffer2send.c_str());
-                            buffer2send +="\n";
-                            break;
-                        }
-                        //get the line and transmit it
-                        //check command
-                        if ((CONFIG::GetFirmwareTarget() == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV)) {
-                            //save time no need to continue
-                            if (current_line.indexOf("busy:") > -1) {
-                                temp_counter++;
-                            } else if (COMMAND::check_command(current_line, NO_PIPE, false)) {
-                                temp_counter ++ ;
-                            }
-                        } else {
-                            if (COMMAND::check_command(current_line, NO_PIPE, false)) {
-                                temp_counter ++ ;
-                            }
-                        }
-                        if (temp_counter > 5) {
-                            log_esp3d("Timeout X5");
-                            done = true;
-                            break;
-                        }
-                        if ((CONFIG::GetFirmwareTarget()  == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV)) {
-                            if (!current_line.startsWith( "ok ")) {
-                                buffer2send +=current_line;
-                                buffer2send +="\n";
-                            }
-                        } else {
-                            buffer2send +=current_line;
-                            log_esp3d("New buffer %s", buffer2send.c_str());
-                            buffer2send +="\n";
-                        }
-                        if (buffer2send.length() > 1200) {
-                            web_interface->web_server.sendContent(buffer2send);
-                           log_esp3d("Sending %s", buffer2send.c_str());
-                            buffer2send = "";
-                            datasent = true;
-                        }
-                        //current remove line from buffer
-                        tmp = current_buffer.substring(current_buffer.indexOf("\n")+1,current_buffer.length());
-                        current_buffer = tmp;
-                        CONFIG::wait (0);
-                    }
-                    CONFIG::wait (0);
-                } else {
-                    CONFIG::wait(1);
+            if (!CMD_QUEUE::send (cmd.c_str(), ORIGIN_WEB, 0, web_command_answer, &answer, &ticket, 2000)) {
+                answer.buffer = "Printer is busy, retry later!\n";
+            }
+            //wait until ack or no answer for 2s
+            uint32_t wait_start = millis();
+            while (CMD_QUEUE::is_pending (ticket) && ((millis() - answer.last_answer) < 2000) && (answer.temp_counter <= 5)) {
+                if (((millis() - wait_start) > WEB_COMMAND_YIELD_TIME) && web_interface->web_server.has_waiting_client()) {
+                    log_esp3d("Request waiting, stop command wait");
+                    break;
                 }
-                //it is sending too many temp status should be heating so let's exit the loop
-                if (temp_counter > 5) {
-                    done = true;
+                ESPCOM::bridge();
+                if (answer.buffer.length() > 1200) {
+                    web_interface->web_server.sendContent(answer.buffer);
+                    log_esp3d("Sending %s", answer.buffer.c_str());
+                    answer.buffer = "";
+                    datasent = true;
                 }
+                CONFIG::wait (1);
             }
+            //late answers go nowhere
+            CMD_QUEUE::release (ticket);
             log_esp3d("Finished");
             //to be sure connection close
-            if (buffer2send.length() > 0) {
-                web_interface->web_server.sendContent(buffer2send);
-                log_esp3d("Sending %s", buffer2send.c_str());
+            if (answer.buffer.length() > 0) {
+                web_interface->web_server.sendContent(answer.buffer);
+                log_esp3d("Sending %s", answer.buffer.c_str());
                 datasent = true;
             }
             if (!datasent) {
                 web_interface->web_server.sendContent(" \r\n");
             }
             web_interface->web_server.sendContent("");
-            log_esp3d("Start PurgeSerial");
-            if(ESPCOM::available(DEFAULT_PRINTER_PIPE)) {
-                ESPCOM::bridge();
-                CONFIG::wait(1);
-            }
-            log_esp3d("End PurgeSerial");
-            web_interface->blockserial = false;
-            log_esp3d("Release PurgeSerial");
         } else {
             web_interface->web_server.send(200,"text/plain","Serial is busy, retry later!");
         }
@@ -1114,6 +1164,7 @@ void handle_web_command()
 //Handle web command query and sent ack or fail instead of answer //////
 void handle_web_command_silent()
 {
+    uint32_t start_us = micros();
     level_authenticate_type auth_level= web_interface->is_authenticated();
     if (auth_level == LEVEL_GUEST) {
         web_interface->web_server.send(401,"text/plain","Authentication failed!\n");
@@ -1160,12 +1211,24 @@ void handle_web_command_silent()
             //if not is not a valid [ESPXXX] command
         }
     } else {
+        //emergency and grbl real time commands must not wait
+        if (ESPCOM::is_urgent (cmd.c_str())) {
+            if (ESPCOM::send_urgent (cmd.c_str(), start_us)) {
+                web_interface->web_server.send(200,"text/plain","ok");
+            } else {
+                web_interface->web_server.send(200,"text/plain","Serial is busy, retry later!");
+            }
+            return;
+        }
         //send command to serial as no need to transfer ESP command
         //to avoid any pollution if Uploading file to SDCard
         if ((web_interface->blockserial) == false) {
-            //send command
-            ESPCOM::println (cmd, DEFAULT_PRINTER_PIPE);
-            web_interface->web_server.send(200,"text/plain","ok");
+            //send command when printer has free slot, answers are not needed
+            if (CMD_QUEUE::send (cmd.c_str(), ORIGIN_WEB)) {
+                web_interface->web_server.send(200,"text/plain","ok");
+            } else {
+                web_interface->web_server.send(200,"text/plain","Printer is busy, retry later!");
+            }
         } else {
             web_interface->web_server.send(200,"text/plain","Serial is busy, retry later!");
         }
@@ -1174,6 +1237,19 @@ void handle_web_command_silent()
 }
 
 
+//Printer telemetry from cached values //////////////////////////////////
+void handle_telemetry()
+{
+#ifndef USE_AS_UPDATER_ONLY
+    if (web_interface->is_authenticated() == LEVEL_GUEST) {
+        web_interface->web_server.send(401,"application/json","{\"status\":\"Authentication failed!\"}");
+        return;
+    }
+    web_interface->web_server.sendHeader("Cache-Control", "no-cache");
+    web_interface->web_server.send(200, "application/json", TELEMETRY::json());
+#endif //USE_AS_UPDATER_ONLY
+}
+
 //Serial SD files list//////////////////////////////////////////////////
 void handle_serial_SDFileList()
 {
@@ -1276,14 +1352,19 @@ void SDFile_serial_upload()
                         //besure nothing left again
                         purge_serial();
                         command = "M28 " + upload.filename;
-                        //send start upload
+                        //use binary transfer if firmware supports it, else send start upload
                         //no correction allowed because it means reset numbering was failed
-                        if (sendLine2Serial(command, lineNb, NULL)){
+                        if (MARLIN_BINARY::begin (upload.filename.c_str())) {
+                            web_interface->_upload_status= UPLOAD_STATUS_ONGOING;
+                            log_esp3d("Binary creation Ok");
+                        } else if (sendLine2Serial(command, lineNb, NULL)){
                             CONFIG::wait(1200);
                             //additional purge, in case it is slow to answer
                             purge_serial();
                             web_interface->_upload_status= UPLOAD_STATUS_ONGOING;
                             log_esp3d("Creation Ok");
+                            //now lines are streamed without waiting each ok
+                            GCODE_STREAM::begin(lineNb + 1);
                             
                         } else  {
                             web_interface->_upload_status= UPLOAD_STATUS_FAILED;
@@ -1296,7 +1377,13 @@ void SDFile_serial_upload()
                 //**************
                 //upload is on going with data coming by 2K blocks
             } else if(upload.status == UPLOAD_FILE_WRITE) { //if com error no need to send more data to serial
-                for (int pos = 0;( pos < upload.currentSize) && (web_interface->_upload_status == UPLOAD_STATUS_ONGOING); pos++) { //parse full post data
+                //binary transfer sends file as it is
+                if (MARLIN_BINARY::is_active() && !MARLIN_BINARY::write (upload.buf, upload.currentSize)) {
+                    log_esp3d("Error sending binary data");
+                    web_interface->_upload_status= UPLOAD_STATUS_FAILED;
+                    pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+                }
+                for (int pos = 0; !MARLIN_BINARY::is_active() &&( pos < upload.currentSize) && (web_interface->_upload_status == UPLOAD_STATUS_ONGOING); pos++) { //parse full post data
                     //feed watchdog
                     CONFIG::wait(0);
                     //it is a comment
@@ -1312,10 +1399,8 @@ void SDFile_serial_upload()
                         if (current_line.length() < MAX_RESEND_BUFFER) {
                             //do we have something in buffer ?
                             if (current_line.length() > 0 ) {
-                                lineNb++;
-                                if (!sendLine2Serial (current_line, lineNb, NULL) ) {
+                                if (!GCODE_STREAM::push (current_line.c_str()) ) {
                                     log_esp3d("Error sending line");
-                                    CloseSerialUpload (true, current_filename,lineNb);
                                     web_interface->_upload_status= UPLOAD_STATUS_FAILED;
                                     pushError(ESP_ERROR_FILE_WRITE, "File write failed");
                                 }
@@ -1345,21 +1430,36 @@ void SDFile_serial_upload()
                 }
                 //Upload end
                 //**************
+            } else if(upload.status == UPLOAD_FILE_END && web_interface->_upload_status == UPLOAD_STATUS_ONGOING && MARLIN_BINARY::is_active()) {
+                if (MARLIN_BINARY::end()) {
+                    log_esp3d ("Binary upload finished");
+                    ESPCOM::println (F ("SD upload done"), PRINTER_PIPE);
+                    web_interface->_upload_status = UPLOAD_STATUS_SUCCESSFUL;
+                    web_interface->blockserial = false;
+                } else {
+                    web_interface->_upload_status= UPLOAD_STATUS_FAILED;
+                    pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+                }
             } else if(upload.status == UPLOAD_FILE_END && web_interface->_upload_status == UPLOAD_STATUS_ONGOING) {
                 //if last part does not have '\n'
                 if (current_line.length()  > 0) {
-                    lineNb++;
-                    if (!sendLine2Serial (current_line, lineNb, NULL) ) {
+                    if (!GCODE_STREAM::push (current_line.c_str()) ) {
                         log_esp3d ("Error sending buffer");
-                        lineNb++;
-                        CloseSerialUpload (true, current_filename, lineNb);
                         web_interface->_upload_status= UPLOAD_STATUS_FAILED;
-                        pushError(ESP_ERROR_FILE_WRITE, "File write failed");
                     }
                 }
-                log_esp3d ("Upload finished");
-                lineNb++;
-                CloseSerialUpload (false, current_filename, lineNb);
+                //wait for all lines in flight to be acknowledged
+                if ((web_interface->_upload_status == UPLOAD_STATUS_ONGOING) && !GCODE_STREAM::flush()) {
+                    log_esp3d ("Error flushing stream");
+                    web_interface->_upload_status= UPLOAD_STATUS_FAILED;
+                }
+                if (web_interface->_upload_status == UPLOAD_STATUS_ONGOING) {
+                    log_esp3d ("Upload finished");
+                    lineNb = GCODE_STREAM::end();
+                    CloseSerialUpload (false, current_filename, lineNb);
+                } else {
+                    pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+                }
                 //Upload cancelled
                 //**************
             } else { //UPLOAD_FILE_ABORTED
@@ -1372,7 +1472,13 @@ void SDFile_serial_upload()
     
     if (web_interface->_upload_status == UPLOAD_STATUS_FAILED) {
         ESPCOM::println (F ("Upload failed"), PRINTER_PIPE);
-        lineNb++;
+        //back to ascii protocol before closing
+        MARLIN_BINARY::abort();
+        if (GCODE_STREAM::is_active()) {
+            lineNb = GCODE_STREAM::end();
+        } else {
+            lineNb++;
+        }
         CloseSerialUpload (true, current_filename, lineNb);
         cancelUpload();
     }
@@ -32,8 +32,16 @@ extern void handle_not_found();
 extern void handle_web_command();
 extern void handle_web_command_silent();
 extern void handle_serial_SDFileList();
+extern void handle_telemetry();
 extern void SDFile_serial_upload();
-extern WebSocketsServer * socket_server;
+//websocket server which tells what can be sent to a client without blocking
+class WEBSOCKET_SERVER_CLASS : public WebSocketsServer
+{
+public:
+    WEBSOCKET_SERVER_CLASS (uint16_t port) : WebSocketsServer (port) {}
+    size_t availableForWrite (uint8_t num);
+};
+extern WEBSOCKET_SERVER_CLASS * socket_server;
 extern void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length);
 
 #ifdef SSDP_FEATURE
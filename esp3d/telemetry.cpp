@@ -0,0 +1,288 @@
+/*
+  telemetry.cpp - ESP3D printer telemetry class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#ifndef USE_AS_UPDATER_ONLY
+#include "telemetry.h"
+#include "espcom.h"
+
+telemetry_t TELEMETRY::data;
+
+void TELEMETRY::clear()
+{
+    memset (&data, 0, sizeof (data));
+}
+
+//line must be null terminated
+void TELEMETRY::parse (const char * line, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+    //grbl status is handled by GRBLCOM
+    if (CONFIG::GetFirmwareTarget() == GRBL) {
+        return;
+    }
+    if ((strstr (line, "busy:") != NULL)) {
+        data.state = PRINTER_BUSY;
+        data.state_time = millis();
+        return;
+    }
+    if ((len == 4) && (strcmp (line, "wait") == 0)) {
+        data.state = PRINTER_IDLE;
+        data.state_time = millis();
+        return;
+    }
+    if ((line[0] == 'o') && (line[1] == 'k')) {
+        //printer answers again so blocking command is done
+        if (data.state != PRINTER_IDLE) {
+            data.state = PRINTER_IDLE;
+            data.state_time = millis();
+        }
+    }
+    if (parse_temperatures (line, len)) {
+        return;
+    }
+    if (parse_position (line, len)) {
+        return;
+    }
+    parse_sd (line, len);
+}
+
+//current value and optional target: 210.3 /210.0
+const char * TELEMETRY::read_temp (const char * p, const char * end, float * values)
+{
+    char * next;
+    float current = strtod (p, &next);
+    if (next == p) {
+        return NULL;
+    }
+    values[0] = current;
+    p = next;
+    while ((p < end) && (*p == ' ')) {
+        p++;
+    }
+    if ((p < end) && (*p == '/')) {
+        float target = strtod (p + 1, &next);
+        if (next != (p + 1)) {
+            values[1] = target;
+            p = next;
+        }
+    }
+    return p;
+}
+
+//ok T:210.3 /210.0 B:60.1 /60.0 @:127 B@:0
+//T:200.0 /200.0 B:60.0 /60.0 T0:200.0 /200.0 T1:25.0 /0.0 @:0 B@:0
+bool TELEMETRY::parse_temperatures (const char * line, size_t len)
+{
+    const char * end = line + len;
+    bool found = false;
+    bool has_index = false;
+    const char * p = line;
+    while (p < end) {
+        //a field starts the line or follows a space
+        if ((p != line) && (p[-1] != ' ')) {
+            p++;
+            continue;
+        }
+        float values[2] = {0, 0};
+        const char * next = NULL;
+        if ((p[0] == 'T') && (p[1] == ':')) {
+            next = read_temp (p + 2, end, values);
+            //T: is active tool, T0: T1: give each tool if several
+            if (next && !has_index) {
+                memcpy (data.tool[0], values, sizeof (values));
+                if (data.nb_tools == 0) {
+                    data.nb_tools = 1;
+                }
+            }
+        } else if ((p[0] == 'T') && isdigit (p[1]) && (p[2] == ':')) {
+            uint8_t index = p[1] - '0';
+            next = read_temp (p + 3, end, values);
+            if (next && (index < TELEMETRY_TOOLS)) {
+                has_index = true;
+                memcpy (data.tool[index], values, sizeof (values));
+                if (data.nb_tools <= index) {
+                    data.nb_tools = index + 1;
+                }
+            }
+        } else if ((p[0] == 'B') && (p[1] == ':')) {
+            next = read_temp (p + 2, end, values);
+            if (next) {
+                memcpy (data.bed, values, sizeof (values));
+                data.has_bed = true;
+            }
+        } else if ((p[0] == 'C') && (p[1] == ':')) {
+            next = read_temp (p + 2, end, values);
+            if (next) {
+                memcpy (data.chamber, values, sizeof (values));
+                data.has_chamber = true;
+            }
+        }
+        if (next) {
+            found = true;
+            p = next;
+        } else {
+            p++;
+        }
+    }
+    if (found) {
+        data.temp_time = millis();
+    }
+    return found;
+}
+
+//X:10.00 Y:20.00 Z:0.30 E:0.00 Count X:800 Y:1600 Z:120
+bool TELEMETRY::parse_position (const char * line, size_t len)
+{
+    if ((line[0] != 'X') || (line[1] != ':') || !strstr (line, " Y:")) {
+        return false;
+    }
+    const char * stop = strstr (line, "Count");
+    if (!stop) {
+        stop = line + len;
+    }
+    const char axis[] = "XYZE";
+    for (uint8_t i = 0; i < 4; i++) {
+        char field[3] = {axis[i], ':', 0};
+        const char * p = strstr (line, field);
+        if (p && (p < stop)) {
+            data.pos[i] = strtod (p + 2, NULL);
+        }
+    }
+    data.pos_time = millis();
+    return true;
+}
+
+//SD printing byte 1234/56789, Not SD printing, Done printing file
+bool TELEMETRY::parse_sd (const char * line, size_t len)
+{
+    const char * p = strstr (line, "SD printing byte ");
+    if (p) {
+        char * next;
+        data.sd_done = strtoul (p + 17, &next, 10);
+        if (*next == '/') {
+            data.sd_total = strtoul (next + 1, NULL, 10);
+        }
+        data.sd_printing = true;
+        data.sd_time = millis();
+        return true;
+    }
+    if (strstr (line, "Not SD printing")) {
+        data.sd_printing = false;
+        data.sd_time = millis();
+        return true;
+    }
+    if (strstr (line, "Done printing file")) {
+        data.sd_printing = false;
+        data.sd_done = data.sd_total;
+        data.sd_time = millis();
+        return true;
+    }
+    return false;
+}
+
+//age in ms of a value, -1 if never received
+static String age (uint32_t time)
+{
+    if (time == 0) {
+        return "-1";
+    }
+    return String (millis() - time);
+}
+
+static String temp_pair (float * values)
+{
+    return "[" + String (values[0], 1) + "," + String (values[1], 1) + "]";
+}
+
+String TELEMETRY::json()
+{
+    String s = "{\"T\":[";
+    for (uint8_t i = 0; i < data.nb_tools; i++) {
+        if (i > 0) {
+            s += ",";
+        }
+        s += temp_pair (data.tool[i]);
+    }
+    s += "]";
+    if (data.has_bed) {
+        s += ",\"B\":" + temp_pair (data.bed);
+    }
+    if (data.has_chamber) {
+        s += ",\"C\":" + temp_pair (data.chamber);
+    }
+    s += ",\"temp_age\":" + age (data.temp_time);
+    s += ",\"pos\":[";
+    for (uint8_t i = 0; i < 4; i++) {
+        if (i > 0) {
+            s += ",";
+        }
+        s += String (data.pos[i], 3);
+    }
+    s += "],\"pos_age\":" + age (data.pos_time);
+    s += ",\"sd\":{\"printing\":";
+    s += data.sd_printing ? "1" : "0";
+    s += ",\"done\":" + String (data.sd_done);
+    s += ",\"total\":" + String (data.sd_total);
+    s += ",\"age\":" + age (data.sd_time);
+    s += "},\"state\":\"";
+    s += (data.state == PRINTER_BUSY) ? "busy" : ((data.state == PRINTER_IDLE) ? "idle" : "unknown");
+    s += "\",\"state_age\":" + age (data.state_time);
+    s += "}";
+    return s;
+}
+
+void TELEMETRY::print (tpipe output, bool plaintext, ESPResponseStream  *espresponse)
+{
+    if (!plaintext) {
+        String s = json();
+        ESPCOM::println (s, output, espresponse);
+        return;
+    }
+    String s;
+    for (uint8_t i = 0; i < data.nb_tools; i++) {
+        s = "T" + String (i) + ": " + String (data.tool[i][0], 1) + " / " + String (data.tool[i][1], 1);
+        ESPCOM::println (s, output, espresponse);
+    }
+    if (data.has_bed) {
+        s = "Bed: " + String (data.bed[0], 1) + " / " + String (data.bed[1], 1);
+        ESPCOM::println (s, output, espresponse);
+    }
+    if (data.has_chamber) {
+        s = "Chamber: " + String (data.chamber[0], 1) + " / " + String (data.chamber[1], 1);
+        ESPCOM::println (s, output, espresponse);
+    }
+    s = "Temperatures age: " + age (data.temp_time) + " ms";
+    ESPCOM::println (s, output, espresponse);
+    s = "Position: X" + String (data.pos[0], 3) + " Y" + String (data.pos[1], 3) + " Z" + String (data.pos[2], 3) + " E" + String (data.pos[3], 3) + " (" + age (data.pos_time) + " ms)";
+    ESPCOM::println (s, output, espresponse);
+    s = "SD: ";
+    s += data.sd_printing ? "printing " : "not printing ";
+    s += String (data.sd_done) + "/" + String (data.sd_total) + " (" + age (data.sd_time) + " ms)";
+    ESPCOM::println (s, output, espresponse);
+    s = "State: ";
+    s += (data.state == PRINTER_BUSY) ? "busy" : ((data.state == PRINTER_IDLE) ? "idle" : "unknown");
+    s += " (" + age (data.state_time) + " ms)";
+    ESPCOM::println (s, output, espresponse);
+}
+
+#endif //USE_AS_UPDATER_ONLY
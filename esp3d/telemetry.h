@@ -0,0 +1,71 @@
+/*
+  telemetry.h - ESP3D printer telemetry class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include <Arduino.h>
+#include "config.h"
+
+//number of extruders followed
+#define TELEMETRY_TOOLS 4
+
+typedef enum {
+    PRINTER_UNKNOWN = 0,
+    PRINTER_IDLE = 1,
+    PRINTER_BUSY = 2
+} printer_state_t;
+
+//latest values seen in printer output, time is millis() of last update, 0 means never
+typedef struct {
+    float tool[TELEMETRY_TOOLS][2];
+    uint8_t nb_tools;
+    float bed[2];
+    bool has_bed;
+    float chamber[2];
+    bool has_chamber;
+    uint32_t temp_time;
+    float pos[4];
+    uint32_t pos_time;
+    uint32_t sd_done;
+    uint32_t sd_total;
+    bool sd_printing;
+    uint32_t sd_time;
+    uint8_t state;
+    uint32_t state_time;
+} telemetry_t;
+
+//parse temperatures (M105 / auto report), position (M114), SD progress (M27) and busy state
+//from printer output, so clients can get them without sending anything to printer
+class TELEMETRY
+{
+public:
+    static void parse (const char * line, size_t len);
+    static void clear();
+    static void print (tpipe output, bool plaintext, ESPResponseStream  *espresponse = NULL);
+    static String json();
+    static telemetry_t data;
+private:
+    static bool parse_temperatures (const char * line, size_t len);
+    static bool parse_position (const char * line, size_t len);
+    static bool parse_sd (const char * line, size_t len);
+    static const char * read_temp (const char * p, const char * end, float * values);
+};
+
+#endif
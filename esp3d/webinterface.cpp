@@ -306,7 +306,7 @@ WEBINTERFACE_CLASS::WEBINTERFACE_CLASS (int port) : web_server (port)
     //that handle "/" and default index.html.gz
 #if defined(ASYNCWEBSERVER)
     //trick to catch command line on "/" before file being processed
-    web_server.serveStatic ("/", SPIFFS, "/").setDefaultFile ("index.html").setFilter (filterOnRoot);
+    web_server.serveStatic ("/", SPIFFS, "/").setDefaultFile ("index.html").setFilter (filterOnRoot).setCacheControl (WEB_CACHE_CONTROL);
     web_server.serveStatic ("/", SPIFFS, "/Nowhere");
     //events functions
     web_events.onConnect(handle_onevent_connect);
@@ -355,6 +355,10 @@ WEBINTERFACE_CLASS::WEBINTERFACE_CLASS (int port) : web_server (port)
     //web commands
     web_server.on ("/command", HTTP_ANY, handle_web_command);
     web_server.on ("/command_silent", HTTP_ANY, handle_web_command_silent);
+#ifndef USE_AS_UPDATER_ONLY
+    //printer values from its output, no serial query
+    web_server.on ("/telemetry", HTTP_ANY, handle_telemetry);
+#endif
     //Serial SD management
     web_server.on ("/upload_serial", HTTP_ANY, handle_serial_SDFileList, SDFile_serial_upload);
 
@@ -549,5 +553,27 @@ String WEBINTERFACE_CLASS::getContentType (String filename)
     return "application/octet-stream";
 }
 
+//files with a content hash in name (like app.1a2b3c4d.js.gz) can be kept by browser
+const char * WEBINTERFACE_CLASS::getCacheControl (const String & filename)
+{
+    //name parts between dots, first one is name and last one is extension
+    int dot = filename.indexOf ('.', filename.lastIndexOf ('/') + 1);
+    while (dot != -1) {
+        int next = filename.indexOf ('.', dot + 1);
+        if (next == -1) {
+            break;
+        }
+        bool hash = ((next - dot - 1) >= 8);
+        for (int i = dot + 1; hash && (i < next); i++) {
+            hash = isxdigit (filename[i]);
+        }
+        if (hash) {
+            return WEB_CACHE_CONTROL_FINGERPRINT;
+        }
+        dot = next;
+    }
+    return WEB_CACHE_CONTROL;
+}
+
 
 WEBINTERFACE_CLASS * web_interface;
@@ -44,6 +44,25 @@
 #endif
 #endif
 
+#if !defined(ASYNCWEBSERVER)
+#ifdef ARDUINO_ARCH_ESP8266
+#define SYNC_WEB_SERVER ESP8266WebServer
+#else
+#define SYNC_WEB_SERVER WebServer
+#endif
+//server serves one request at a time, long handlers check if another one is waiting (emergency stop)
+class WEBSERVER_CLASS : public SYNC_WEB_SERVER
+{
+public:
+    WEBSERVER_CLASS (int port = 80) : SYNC_WEB_SERVER (port) {}
+    //_server is the listening WiFiServer, a protected member of ESP8266WebServer and of esp32 WebServer,
+    //it is only read here so a core which renames it breaks this one function only
+    bool has_waiting_client()
+    {
+        return _server.hasClient();
+    }
+};
+#endif
 
 struct auth_ip {
     IPAddress ip;
@@ -63,11 +82,7 @@ public:
     AsyncWebServer web_server;
     AsyncEventSource web_events;
 #else
-#ifdef ARDUINO_ARCH_ESP8266
-    ESP8266WebServer web_server;
-#else
-    WebServer web_server;
-#endif
+    WEBSERVER_CLASS web_server;
 #endif
 #ifdef WS_DATA_FEATURE
 #if defined(ASYNCWEBSERVER)
@@ -76,6 +91,7 @@ public:
 #endif
     bool restartmodule;
     String getContentType (String filename);
+    const char * getCacheControl (const String & filename);
     level_authenticate_type is_authenticated();
     bool AddAuthIP (auth_ip * item);
     bool blockserial;
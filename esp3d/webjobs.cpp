@@ -0,0 +1,175 @@
+/*
+  webjobs.cpp - ESP3D web commands jobs class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#if !defined (USE_AS_UPDATER_ONLY) && !defined (ASYNCWEBSERVER)
+#include "webjobs.h"
+#include "command.h"
+#include "syncwebserver.h"
+#include "cmdqueue.h"
+
+web_job_t WEB_JOBS::_jobs[WEB_JOBS_SIZE];
+uint16_t WEB_JOBS::_last_id = 0;
+
+uint16_t WEB_JOBS::start (const char * cmd, uint8_t client)
+{
+    web_job_t * job = NULL;
+    for (uint8_t i = 0; i < WEB_JOBS_SIZE; i++) {
+        if (_jobs[i].state == JOB_FREE) {
+            job = &_jobs[i];
+            break;
+        }
+    }
+    if (!job) {
+        return 0;
+    }
+    //0 means no job
+    _last_id++;
+    if (_last_id == 0) {
+        _last_id++;
+    }
+    job->id = _last_id;
+    job->state = JOB_SENDING;
+    job->client = client;
+    job->temp_counter = 0;
+    job->last_ticket = 0;
+    job->last_time = millis();
+    job->cmd = cmd;
+    job->answer = "";
+    return job->id;
+}
+
+web_job_state_t WEB_JOBS::fetch (uint16_t id, String & answer)
+{
+    for (uint8_t i = 0; i < WEB_JOBS_SIZE; i++) {
+        web_job_t * job = &_jobs[i];
+        if ((job->state == JOB_FREE) || (job->id != id)) {
+            continue;
+        }
+        web_job_state_t state = (web_job_state_t) job->state;
+        if (state == JOB_DONE) {
+            answer = job->answer;
+            job->state = JOB_FREE;
+            job->cmd = "";
+            job->answer = "";
+        }
+        return state;
+    }
+    return JOB_FREE;
+}
+
+//websocket id may be given to next client
+void WEB_JOBS::drop_client (uint8_t client)
+{
+    for (uint8_t i = 0; i < WEB_JOBS_SIZE; i++) {
+        if (_jobs[i].client == client) {
+            _jobs[i].client = WEB_JOBS_NO_CLIENT;
+        }
+    }
+}
+
+void WEB_JOBS::on_answer (void * ctx, const char * line, size_t len)
+{
+    web_job_t * job = (web_job_t *) ctx;
+    job->last_time = millis();
+    //it is sending too many temp status should be heating
+    if (COMMAND::check_command (line, len, NO_PIPE, false, false)) {
+        job->temp_counter++;
+    }
+    if ((CONFIG::GetFirmwareTarget()  == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV)) {
+        if ((len > 5) && (strncmp (line, "busy:", 5) == 0)) {
+            job->temp_counter++;
+        }
+        if ((len >= 3) && (strncmp (line, "ok ", 3) == 0)) {
+            return;
+        }
+    }
+    if ((job->answer.length() + len + 1) > WEB_JOBS_BUFFER_SIZE) {
+        return;
+    }
+    job->answer += line;
+    job->answer += "\n";
+}
+
+//one line at a time and without waiting printer credits, so loop is never blocked
+bool WEB_JOBS::send_next (web_job_t * job)
+{
+    int end = job->cmd.indexOf ('\n');
+    String line = (end == -1) ? job->cmd : job->cmd.substring (0, end);
+    uint16_t ticket = 0;
+    if (!CMD_QUEUE::send (line.c_str(), ORIGIN_WEB, 0, on_answer, job, &ticket, 0)) {
+        return false;
+    }
+    if (ticket != 0) {
+        job->last_ticket = ticket;
+    }
+    job->cmd = (end == -1) ? "" : job->cmd.substring (end + 1);
+    job->last_time = millis();
+    return true;
+}
+
+void WEB_JOBS::finish (web_job_t * job)
+{
+    //late answers go nowhere, tickets of other jobs and origins are interleaved so only this job ones are released
+    CMD_QUEUE::release_ctx (job);
+    job->cmd = "";
+    job->state = JOB_DONE;
+    job->last_time = millis();
+    if ((job->client != WEB_JOBS_NO_CLIENT) && socket_server) {
+        String s = "JOB:" + String (job->id) + ":" + job->answer;
+        socket_server->sendTXT (job->client, s);
+    }
+}
+
+void WEB_JOBS::handle()
+{
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < WEB_JOBS_SIZE; i++) {
+        web_job_t * job = &_jobs[i];
+        switch (job->state) {
+        case JOB_SENDING:
+            if (send_next (job)) {
+                if (job->cmd.length() == 0) {
+                    job->state = JOB_RUNNING;
+                }
+            } else if ((now - job->last_time) > WEB_JOBS_TIMEOUT) {
+                job->answer += "Printer is busy, retry later!\n";
+                finish (job);
+            }
+            break;
+        case JOB_RUNNING:
+            //wait until ack or no answer for a while
+            if (!CMD_QUEUE::is_pending (job->last_ticket) || ((now - job->last_time) > WEB_JOBS_TIMEOUT) || (job->temp_counter > 5)) {
+                finish (job);
+            }
+            break;
+        case JOB_DONE:
+            if ((now - job->last_time) > WEB_JOBS_KEEP) {
+                job->state = JOB_FREE;
+                job->answer = "";
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+#endif
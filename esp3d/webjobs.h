@@ -0,0 +1,75 @@
+/*
+  webjobs.h - ESP3D web commands jobs class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef WEBJOBS_H
+#define WEBJOBS_H
+#include <Arduino.h>
+#include "config.h"
+
+//number of web commands running or waiting to be fetched
+#define WEB_JOBS_SIZE 4
+//printer answer kept for one job (bytes)
+#define WEB_JOBS_BUFFER_SIZE 1024
+//no printer answer for this time ends the job (ms)
+#define WEB_JOBS_TIMEOUT 2000
+//time a finished job can still be fetched (ms)
+#define WEB_JOBS_KEEP 30000
+//no websocket client to notify
+#define WEB_JOBS_NO_CLIENT 0xFF
+
+typedef enum {
+    JOB_FREE = 0,
+    JOB_SENDING = 1,
+    JOB_RUNNING = 2,
+    JOB_DONE = 3
+} web_job_state_t;
+
+typedef struct {
+    uint16_t id;
+    uint8_t state;
+    uint8_t client;
+    uint8_t temp_counter;
+    uint16_t last_ticket;
+    uint32_t last_time;
+    //lines still to send, then printer answer
+    String cmd;
+    String answer;
+} web_job_t;
+
+//web commands are queued and sent by main loop, so http handler returns at once
+//answer is pushed to websocket client as JOB:<id>:<answer> and can be fetched until it expires
+class WEB_JOBS
+{
+public:
+    //0 if no job is free
+    static uint16_t start (const char * cmd, uint8_t client = WEB_JOBS_NO_CLIENT);
+    //JOB_FREE if unknown or expired, answer is given and job freed once done
+    static web_job_state_t fetch (uint16_t id, String & answer);
+    static void drop_client (uint8_t client);
+    static void handle();
+private:
+    static web_job_t _jobs[WEB_JOBS_SIZE];
+    static uint16_t _last_id;
+    static void on_answer (void * ctx, const char * line, size_t len);
+    static bool send_next (web_job_t * job);
+    static void finish (web_job_t * job);
+};
+
+#endif
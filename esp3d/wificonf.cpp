@@ -579,9 +579,16 @@ bool WIFI_CONFIG::Enable_servers()
 {
     //start web interface
     web_interface = new WEBINTERFACE_CLASS (wifi_config.iweb_port);
-#ifdef AUTHENTICATION_FEATURE
+#if defined (AUTHENTICATION_FEATURE) || !defined (ASYNCWEBSERVER)
     //here the list of headers to be recorded
-    const char * headerkeys[] = {"Cookie"} ;
+    const char * headerkeys[] = {
+#ifdef AUTHENTICATION_FEATURE
+        "Cookie",
+#endif
+#if !defined (ASYNCWEBSERVER)
+        "If-None-Match", "Range", "If-Range"
+#endif
+    } ;
     size_t headerkeyssize = sizeof (headerkeys) / sizeof (char*);
     //ask server to track these headers
     web_interface->web_server.collectHeaders (headerkeys, headerkeyssize );
@@ -602,7 +609,7 @@ bool WIFI_CONFIG::Enable_servers()
     data_server->setNoDelay (true);
 #endif
 #if !defined (ASYNCWEBSERVER)
-    socket_server = new WebSocketsServer (wifi_config.iweb_port+1);
+    socket_server = new WEBSOCKET_SERVER_CLASS (wifi_config.iweb_port+1);
     socket_server->begin();
     socket_server->onEvent(webSocketEvent);
 #endif
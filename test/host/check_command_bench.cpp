@@ -0,0 +1,201 @@
+/*
+  check_command_bench.cpp - lines/sec of printer output parsing (LINE_FRAMER + check_command)
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//compare serial path of COMMAND with the String based one it replaced
+//host String has small string optimization and a faster heap than esp8266,
+//so old path is slower on target than shown here
+#include "config.h"
+#include "command.h"
+#include "command_handlers.h"
+#include <chrono>
+#include <string>
+
+#define LINES_NB 300000
+//serial data are read by blocks
+#define BLOCK_SIZE 64
+
+static uint32_t esp_commands_run = 0;
+static String last_params;
+
+//[ESPxxx] handlers only count calls
+#define HANDLER(nb) bool esp_cmd_##nb (String & cmd_params, const CMD_PARAMS & params, String & parameter, tpipe output, level_authenticate_type auth_type, ESPResponseStream * espresponse) \
+{ \
+    esp_commands_run++; \
+    last_params = cmd_params; \
+    return true; \
+}
+HANDLER (100) HANDLER (101) HANDLER (102) HANDLER (103) HANDLER (104) HANDLER (105) HANDLER (106) HANDLER (107)
+HANDLER (110) HANDLER (111) HANDLER (112) HANDLER (201) HANDLER (290) HANDLER (300) HANDLER (400) HANDLER (401)
+HANDLER (402) HANDLER (410) HANDLER (420) HANDLER (430) HANDLER (444) HANDLER (500) HANDLER (501) HANDLER (502)
+HANDLER (503) HANDLER (600) HANDLER (610) HANDLER (700) HANDLER (710) HANDLER (720) HANDLER (800) HANDLER (801)
+HANDLER (810) HANDLER (900)
+
+uint8_t CONFIG::GetFirmwareTarget()
+{
+    return MARLIN;
+}
+
+void ESPCOM::println (const __FlashStringHelper * data, tpipe output, ESPResponseStream * espresponse) {}
+
+//previous serial path: line grown char by char then copied by value and scanned several times
+static String buffer_serial;
+static uint32_t old_temp_lines = 0;
+
+static bool old_check_command (String buffer, tpipe output)
+{
+    bool is_temp = false;
+    if ( (buffer.indexOf ("T:") > -1 ) || (buffer.indexOf ("B:") > -1 ) ) {
+        is_temp = true;
+    }
+    if (buffer.startsWith ("ok") && buffer.length() < 4) {
+        return false;
+    }
+    int ESPpos = buffer.indexOf ("[ESP");
+    if (ESPpos > -1) {
+        int ESPpos2 = buffer.indexOf ("]", ESPpos);
+        if (ESPpos2 > -1) {
+            String cmd_part1 = buffer.substring (ESPpos + 4, ESPpos2);
+            String cmd_part2 = "";
+            if (ESPpos2 < (int) buffer.length() ) {
+                cmd_part2 = buffer.substring (ESPpos2 + 1);
+            }
+            if (cmd_part1.toInt() != 0) {
+                COMMAND::execute_command (cmd_part1.toInt(), cmd_part2, output);
+            }
+        }
+    }
+    return is_temp;
+}
+
+static void old_read_buffer_serial (uint8_t b)
+{
+    static bool previous_was_char = false;
+    static bool iscomment = false;
+    if (!previous_was_char) {
+        buffer_serial = "";
+        iscomment = false;
+    }
+    if (char (b) == ';') {
+        iscomment = true;
+    }
+    if (isprint (b) ) {
+        previous_was_char = true;
+        if (!iscomment) {
+            buffer_serial += char (b);
+        }
+    } else {
+        previous_was_char = false;
+    }
+    if (b == 13 || b == 10) {
+        iscomment = false;
+        if (buffer_serial.length() > 3) {
+            if (old_check_command (buffer_serial, DEFAULT_PRINTER_PIPE)) {
+                old_temp_lines++;
+            }
+        }
+    }
+}
+
+//a span is not 0 terminated, what follows it must be ignored
+static bool check_spans()
+{
+    bool ok = true;
+    const char line[] = "[ESP800]plain[ESP999]garbage";
+    esp_commands_run = 0;
+    COMMAND::check_command (line, 13, DEFAULT_PRINTER_PIPE);
+    if ((esp_commands_run != 1) || (last_params != "plain")) {
+        printf ("span: parameters are [%s]  FAILED\n", last_params.c_str());
+        ok = false;
+    }
+    static const struct {
+        const char * line;
+        bool is_temp;
+    } lines[] = {
+        {"ok T:210.3 /210.0 B:60.1 /60.0 @:127 B@:0", true},
+        {" T:210.3 /210.0 B:60.1 /60.0 @:127", true},
+        {"ok", false},
+        {"echo:busy: processing", false},
+        {"X:10.00 Y:20.00 Z:0.30 E:0.00 Count X:800", false},
+    };
+    for (size_t i = 0; i < sizeof (lines) / sizeof (lines[0]); i++) {
+        if (COMMAND::check_command (lines[i].line, strlen (lines[i].line), DEFAULT_PRINTER_PIPE) != lines[i].is_temp) {
+            printf ("[%s] is %sa temperature line  FAILED\n", lines[i].line, lines[i].is_temp ? "" : "not ");
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main()
+{
+    bool ok = check_spans();
+    //usual printer output while printing, with some commands for ESP3D
+    static const char * output[] = {
+        "ok T:210.3 /210.0 B:60.1 /60.0 @:127 B@:0\n",
+        "ok\n",
+        "echo:busy: processing\n",
+        "X:10.00 Y:20.00 Z:0.30 E:0.00 Count X:800 Y:1600 Z:120\n",
+        "SD printing byte 123456/987654\n",
+        "ok\n",
+        "echo:M420 S1 ; bed leveling\n",
+        "[ESP800]plain\n",
+    };
+    size_t nb = sizeof (output) / sizeof (output[0]);
+    std::string data;
+    uint32_t expected_cmds = 0;
+    for (int i = 0; i < LINES_NB; i++) {
+        data += output[i % nb];
+        if ((i % nb) == (nb - 1)) {
+            expected_cmds++;
+        }
+    }
+    const uint8_t * d = (const uint8_t *) data.data();
+    size_t size = data.size();
+
+    esp_commands_run = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < size; pos += BLOCK_SIZE) {
+        size_t len = (size - pos < BLOCK_SIZE) ? size - pos : BLOCK_SIZE;
+        for (size_t i = 0; i < len; i++) {
+            old_read_buffer_serial (d[pos + i]);
+        }
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    uint32_t old_cmds = esp_commands_run;
+
+    esp_commands_run = 0;
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < size; pos += BLOCK_SIZE) {
+        size_t len = (size - pos < BLOCK_SIZE) ? size - pos : BLOCK_SIZE;
+        COMMAND::read_buffer_serial ((uint8_t *) &d[pos], len);
+    }
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    uint32_t new_cmds = esp_commands_run;
+
+    double old_s = std::chrono::duration<double> (t1 - t0).count();
+    double new_s = std::chrono::duration<double> (t3 - t2).count();
+    printf ("String path     %9.0f lines/s\n", LINES_NB / old_s);
+    printf ("LINE_FRAMER     %9.0f lines/s  x%.1f\n", LINES_NB / new_s, old_s / new_s);
+    if ((old_cmds != expected_cmds) || (new_cmds != expected_cmds)) {
+        printf ("[ESP] commands run: old %u, new %u, expected %u  FAILED\n", old_cmds, new_cmds, expected_cmds);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/*
+  cmdparams_fuzz.cpp - CMD_PARAMS against previous get_param on random parameters, and lookup time
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//parameters are built from pieces of real [ESP] parameters, every key is looked up with both parsers
+//only allowed difference: previous parser also found a key inside another token (P inside PULLUP=)
+#include "config.h"
+#include "cmdparams.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+#define FUZZ_NB 300000
+#define BENCH_NB 300000
+
+//previous COMMAND::get_param with String semantic
+static int index_of (const std::string & s, const char * sub, size_t from)
+{
+    if (from >= s.size()) {
+        return -1;
+    }
+    const char * p = strstr (s.c_str() + from, sub);
+    return p ? (int) (p - s.c_str()) : -1;
+}
+
+static std::string substring (const std::string & s, unsigned left, unsigned right)
+{
+    if (left > right) {
+        unsigned tmp = left;
+        left = right;
+        right = tmp;
+    }
+    if (left > s.size()) {
+        return "";
+    }
+    if (right > s.size()) {
+        right = s.size();
+    }
+    return s.substr (left, right - left);
+}
+
+static std::string trim (const std::string & s)
+{
+    size_t b = 0;
+    size_t e = s.size();
+    while ((b < e) && isspace ((unsigned char) s[b])) {
+        b++;
+    }
+    while ((e > b) && isspace ((unsigned char) s[e - 1])) {
+        e--;
+    }
+    return s.substr (b, e - b);
+}
+
+static std::string old_get_param (const std::string & cmd_params, const char * id, bool withspace, int * startpos)
+{
+    std::string sid = id;
+    int start;
+    int end = -1;
+    if (strlen (id) == 0) {
+        start = 0;
+    } else {
+        start = index_of (cmd_params, id, 0);
+    }
+    *startpos = start;
+    if (start == -1) {
+        return "";
+    }
+    if (!withspace) {
+        end = index_of (cmd_params, " ", start);
+    }
+#ifdef AUTHENTICATION_FEATURE
+    else if (sid != " pwd=") {
+        end = index_of (cmd_params, " pwd=", start);
+    }
+#endif
+    if (end == -1) {
+        end = cmd_params.size();
+    }
+    return trim (substring (cmd_params, start + strlen (id), end));
+}
+
+//esp8266 String always allocates, host std::string does not for short values
+//so copies done by previous code are added as heap buffers
+static size_t old_get_param_heap (const std::string & cmd_params, const char * id, bool withspace)
+{
+    int start;
+    char * sid = strdup (id);
+    std::string res = old_get_param (cmd_params, id, withspace, &start);
+    char * sub = strdup (res.c_str());
+    char * copy = strdup (sub);
+    char * ret = strdup (copy);
+    size_t len = strlen (ret);
+    free (sid);
+    free (sub);
+    free (copy);
+    free (ret);
+    return len;
+}
+
+static const char * ids[] = {"", "P", "V", "pwd=", "T=", "P=", "V=", "RAW=", "PULLUP=", "ANALOG=", "type=", "T1=", "TS=", "C=", "L="};
+static const char * pieces[] = {"P", "V", "pwd=", "T=", "P=", "V=", "RAW=", "PULLUP=", "YES", "NO", "ANALOG=", "12", "abc", " ", " ", " ", "  ", "\t", "x", "type=", "T1=", "=", "my wifi", "pwd", "p"};
+
+static bool fuzz()
+{
+    std::mt19937 rng (1234);
+    long total = 0;
+    long same = 0;
+    long mid_token = 0;
+    long bugs = 0;
+    for (int n = 0; n < FUZZ_NB; n++) {
+        std::string s;
+        int count = rng() % 10;
+        for (int i = 0; i < count; i++) {
+            s += pieces[rng() % (sizeof (pieces) / sizeof (pieces[0]))];
+        }
+        CMD_PARAMS params (s.c_str(), s.size());
+        for (size_t i = 0; i < sizeof (ids) / sizeof (ids[0]); i++) {
+            for (int withspace = 0; withspace < 2; withspace++) {
+                int start;
+                std::string old_value = old_get_param (s, ids[i], withspace, &start);
+                String value = params.get_string (ids[i], withspace);
+                total++;
+                if (old_value == value.c_str()) {
+                    same++;
+                    continue;
+                }
+                if ((start > 0) && (s[start - 1] != ' ')) {
+                    mid_token++;
+                    continue;
+                }
+                if (bugs < 10) {
+                    printf ("[%s] id=%s withspace=%d old=[%s] new=[%s]  FAILED\n", s.c_str(), ids[i], withspace, old_value.c_str(), value.c_str());
+                }
+                bugs++;
+            }
+        }
+    }
+    printf ("lookups %ld  same %ld  key inside token %ld  differences %ld\n", total, same, mid_token, bugs);
+    return bugs == 0;
+}
+
+//[ESP201] like lookups
+static void bench()
+{
+    std::string cmd = "P2 V1 PULLUP=YES RAW=NO ANALOG=NO ANALOG_RANGE=255 pwd=admin password";
+    static const char * keys[] = {"P", "ANALOG=", "V", "RAW=", "PULLUP=", "ANALOG_RANGE=", "pwd="};
+    size_t nb = sizeof (keys) / sizeof (keys[0]);
+    volatile size_t sink = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int n = 0; n < BENCH_NB; n++) {
+        int start;
+        for (size_t i = 0; i < nb; i++) {
+            sink += old_get_param (cmd, keys[i], !strcmp (keys[i], "pwd="), &start).size();
+        }
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (int n = 0; n < BENCH_NB; n++) {
+        for (size_t i = 0; i < nb; i++) {
+            sink += old_get_param_heap (cmd, keys[i], !strcmp (keys[i], "pwd="));
+        }
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    for (int n = 0; n < BENCH_NB; n++) {
+        CMD_PARAMS params (cmd.c_str(), cmd.size());
+        const char * value;
+        size_t len;
+        for (size_t i = 0; i < nb; i++) {
+            params.get (keys[i], !strcmp (keys[i], "pwd="), value, len);
+            sink += len;
+        }
+    }
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    double old_us = std::chrono::duration<double, std::micro> (t1 - t0).count() / BENCH_NB;
+    double heap_us = std::chrono::duration<double, std::micro> (t2 - t1).count() / BENCH_NB;
+    double new_us = std::chrono::duration<double, std::micro> (t3 - t2).count() / BENCH_NB;
+    printf ("%u lookups  get_param %.3f us  get_param with heap copies %.3f us  CMD_PARAMS %.3f us\n", (unsigned) nb, old_us, heap_us, new_us);
+}
+
+int main()
+{
+    bool ok = fuzz();
+    bench();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/*
+  configjournal_sim.cpp - flash erases of CONFIG_JOURNAL against EEPROM commits, and power cuts
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//each EEPROM commit erases its whole sector, journal only programs SPIFFS pages
+//erases of journal are estimated as programmed pages / pages per block,
+//as SPIFFS must erase a block for each block worth of pages written
+//power cut: SPIFFS stops writing after a random number of bytes, RAM image is lost,
+//after reboot settings must be either the ones before or after the interrupted write
+#include "config.h"
+#include <EEPROM.h>
+#include <FS.h>
+#include "configjournal.h"
+#include "fsindex.h"
+
+#define WRITES_NB 10000
+#define POWER_CUT_NB 2000
+
+void FS_INDEX::update (const char * name) {}
+
+static uint8_t expected[EEPROM_SIZE];
+
+//RAM image is lost and SPIFFS works again
+static void reboot()
+{
+    memset (EEPROM.data, 0xEE, EEPROM_SIZE);
+    host_fs.power_cut = false;
+    host_fs.budget = -1;
+}
+
+//settings changed as [ESP401] / [ESP402] do: a few bytes at once
+static bool writes()
+{
+    memset (EEPROM.data, 0, EEPROM_SIZE);
+    if (!CONFIG_JOURNAL::begin()) {
+        printf ("journal creation  FAILED\n");
+        return false;
+    }
+    uint32_t pages_start = host_fs.pages;
+    for (int i = 0; i < WRITES_NB; i++) {
+        int pos = rand() % (EEPROM_SIZE - 4);
+        int len = 1 + rand() % 4;
+        for (int k = 0; k < len; k++) {
+            EEPROM.write (pos + k, rand());
+        }
+        if (!CONFIG_JOURNAL::append (pos, len)) {
+            printf ("append %d  FAILED\n", i);
+            return false;
+        }
+        CONFIG_JOURNAL::handle();
+    }
+    memcpy (expected, EEPROM.data, EEPROM_SIZE);
+    uint32_t pages = host_fs.pages - pages_start;
+    uint32_t erases = (uint32_t) ((uint64_t) pages * HOST_FS_PAGE_SIZE / HOST_FS_BLOCK_SIZE);
+    printf ("%d writes  appends %u  compactions %u  journal %u bytes\n", WRITES_NB, CONFIG_JOURNAL::appends(), CONFIG_JOURNAL::compactions(), CONFIG_JOURNAL::size());
+    printf ("journal  %u pages programmed  ~%u block erases\n", pages, erases);
+    printf ("EEPROM   %d commits  %d sector erases  x%.1f\n", WRITES_NB, WRITES_NB, erases ? (double) WRITES_NB / erases : 0.0);
+    reboot();
+    CONFIG_JOURNAL::begin();
+    if (memcmp (EEPROM.data, expected, EEPROM_SIZE) != 0) {
+        printf ("reload  FAILED\n");
+        return false;
+    }
+    return true;
+}
+
+static bool power_cuts()
+{
+    int bad = 0;
+    int cuts = 0;
+    for (int r = 0; r < POWER_CUT_NB; r++) {
+        uint8_t before[EEPROM_SIZE];
+        uint8_t after[EEPROM_SIZE];
+        memcpy (before, EEPROM.data, EEPROM_SIZE);
+        int pos = rand() % (EEPROM_SIZE - 24);
+        int len = 1 + rand() % 20;
+        for (int k = 0; k < len; k++) {
+            EEPROM.write (pos + k, rand());
+        }
+        memcpy (after, EEPROM.data, EEPROM_SIZE);
+        //a compaction writes the whole snapshot, an append only a few bytes
+        bool compaction = (r % 3) == 0;
+        host_fs.budget = rand() % (compaction ? 1200 : 40);
+        if (compaction) {
+            CONFIG_JOURNAL::compact();
+        } else {
+            CONFIG_JOURNAL::append (pos, len);
+        }
+        bool cut = host_fs.power_cut;
+        if (cut) {
+            cuts++;
+        }
+        reboot();
+        CONFIG_JOURNAL::begin();
+        bool is_before = memcmp (EEPROM.data, before, EEPROM_SIZE) == 0;
+        bool is_after = memcmp (EEPROM.data, after, EEPROM_SIZE) == 0;
+        if ((!is_before && !is_after) || (!cut && !is_after)) {
+            bad++;
+        }
+        //next write starts from what was reloaded
+    }
+    printf ("%d power cut runs  %d cut  %d corrupted\n", POWER_CUT_NB, cuts, bad);
+    return bad == 0;
+}
+
+//web file manager must not see journal files
+static bool names()
+{
+    std::map<std::string, std::vector<uint8_t> >::iterator it;
+    int journals = 0;
+    for (it = host_fs.files.begin(); it != host_fs.files.end(); ++it) {
+        if (CONFIG_JOURNAL::is_journal (it->first.c_str())) {
+            journals++;
+        }
+    }
+    if ((journals == 0) || CONFIG_JOURNAL::is_journal ("/user/config0.jnl") || CONFIG_JOURNAL::is_journal ("/config0.jnl.gz")) {
+        printf ("journal names  FAILED\n");
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    srand (1);
+    host_fs.budget = -1;
+    bool ok = writes() && names();
+    ok = power_cuts() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/*
+  fsindex_test.cpp - FS_INDEX listings against SPIFFS content
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//listings with index and with SPIFFS scan are compared with what a listing must show
+//heap is set by test to check index is dropped and built again
+#include "config.h"
+#include <FS.h>
+#include "fsindex.h"
+#include "nameset.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+static std::string output;
+
+JSON_WRITER::JSON_WRITER (tpipe output, ESPResponseStream * espresponse) {}
+JSON_WRITER::~JSON_WRITER() {}
+void JSON_WRITER::print (const __FlashStringHelper * data)
+{
+    output += (const char *) data;
+}
+void JSON_WRITER::print (const char * data)
+{
+    output += data;
+}
+void JSON_WRITER::print (char c)
+{
+    output += c;
+}
+
+String CONFIG::formatBytes (uint64_t bytes)
+{
+    return String ((unsigned long) bytes);
+}
+
+void CONFIG::wdtFeed() {}
+
+static void create_file (const std::string & name, size_t size)
+{
+    FS_FILE f = SPIFFS.open (name.c_str(), "w");
+    for (size_t i = 0; i < size; i++) {
+        f.write ((uint8_t) (name[i % name.size()] + i));
+    }
+    f.close();
+    FS_INDEX::update (name.c_str());
+}
+
+static void remove_file (const std::string & name)
+{
+    SPIFFS.remove (name.c_str());
+    FS_INDEX::update (name.c_str());
+}
+
+//"name|size" of each entry, sorted
+static std::vector<std::string> listed (const char * path)
+{
+    output = "";
+    JSON_WRITER writer (WEB_PIPE);
+    FS_INDEX::list (path, writer);
+    std::vector<std::string> entries;
+    size_t pos = 0;
+    while ((pos = output.find ("{\"name\":\"", pos)) != std::string::npos) {
+        pos += 9;
+        size_t end = output.find ('"', pos);
+        std::string name = output.substr (pos, end - pos);
+        pos = output.find ("\"size\":\"", end) + 8;
+        end = output.find ('"', pos);
+        entries.push_back (name + "|" + output.substr (pos, end - pos));
+        pos = end;
+    }
+    std::sort (entries.begin(), entries.end());
+    return entries;
+}
+
+//what listing of path must show
+static std::vector<std::string> expected (const char * path)
+{
+    std::vector<std::string> entries;
+    size_t plen = strlen (path);
+    std::map<std::string, std::vector<uint8_t> >::iterator it;
+    for (it = host_fs.files.begin(); it != host_fs.files.end(); ++it) {
+        if (it->first.compare (0, plen, path) != 0) {
+            continue;
+        }
+        std::string name = it->first.substr (plen);
+        size_t slash = name.find ('/');
+        if (slash != std::string::npos) {
+            std::string dir = name.substr (0, slash) + "|-1";
+            if ((slash > 0) && (std::find (entries.begin(), entries.end(), dir) == entries.end())) {
+                entries.push_back (dir);
+            }
+        } else if (!name.empty() && (name != ".")) {
+            entries.push_back (name + "|" + std::to_string (it->second.size()));
+        }
+    }
+    std::sort (entries.begin(), entries.end());
+    return entries;
+}
+
+static bool check (const char * label, const char * path, bool indexed)
+{
+    std::vector<std::string> l = listed (path);
+    std::vector<std::string> e = expected (path);
+    bool ok = (l == e) && (FS_INDEX::started() == indexed);
+    printf ("%-36s %-6s %4u entries  index %s%s\n", label, path, (unsigned) l.size(), FS_INDEX::started() ? "on " : "off", ok ? "" : "  FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    char name[32];
+    //more files than a fixed 128 entries index
+    for (int i = 0; i < 300; i++) {
+        snprintf (name, sizeof (name), (i < 60) ? "/f%03d.gco" : "/d%02d/f%03d.gco", i % 24, i);
+        create_file (name, i);
+    }
+    create_file ("/empty/.", 0);
+    ok = FS_INDEX::begin() && (FS_INDEX::count() == host_fs.files.size()) && ok;
+    ok = check ("301 files", "/", true) && ok;
+    ok = check ("301 files", "/d07/", true) && ok;
+
+    //no heap for one more block: index dropped, scan is used
+    host_free_heap = 0;
+    for (int i = 0; (i < FS_INDEX_BLOCK) && FS_INDEX::started(); i++) {
+        snprintf (name, sizeof (name), "/new%02d.gco", i);
+        create_file (name, 10);
+    }
+    ok = check ("no heap for new file", "/", false) && ok;
+    //removing the file which did not fit builds index again
+    host_free_heap = 40000;
+    remove_file (name);
+    ok = check ("file removed", "/", true) && ok;
+    ok = (FS_INDEX::count() == host_fs.files.size()) && ok;
+
+    //no heap at boot: index comes back once enough files are removed
+    host_free_heap = 0;
+    FS_INDEX::begin();
+    ok = check ("no heap at boot", "/", false) && ok;
+    host_free_heap = 40000;
+    std::vector<std::string> names;
+    std::map<std::string, std::vector<uint8_t> >::iterator it;
+    for (it = host_fs.files.begin(); it != host_fs.files.end(); ++it) {
+        names.push_back (it->first);
+    }
+    for (size_t i = 0; i + 1 < names.size(); i++) {
+        remove_file (names[i]);
+    }
+    ok = check ("all but one file removed", "/", false) && ok;
+    remove_file (names.back());
+    ok = check ("all files removed", "/", true) && ok;
+    create_file ("/d01/last.gco", 5);
+    ok = check ("file created", "/", true) && ok;
+
+    //web file is hashed while index is built, not on first request
+    create_file ("/index.html.gz", 3000);
+    FS_INDEX::begin();
+    std::vector<uint8_t> content = host_fs.files["/index.html.gz"];
+    //an empty file would be read if hash was not done yet
+    host_fs.files["/index.html.gz"].clear();
+    uint32_t tag = FS_INDEX::etag ("/index.html.gz");
+    host_fs.files["/index.html.gz"] = content;
+    host_fs.files["/index.html.gz"][0]++;
+    FS_INDEX::update ("/index.html.gz");
+    uint32_t tag2 = FS_INDEX::etag ("/index.html.gz");
+    //big file is hashed on first request
+    create_file ("/big.gco", FS_INDEX_ETAG_SIZE + 1);
+    uint32_t tag3 = FS_INDEX::etag ("/big.gco");
+    bool etags = (tag != 0) && (tag != NAME_SET_FNV_BASIS) && (tag2 != 0) && (tag2 != tag) && (tag3 != 0) && (FS_INDEX::etag ("/none.gco") == 0);
+    printf ("%-36s %08x %08x %08x%s\n", "etags", tag, tag2, tag3, etags ? "" : "  FAILED");
+    ok = etags && ok;
+
+    //scan path: more subdirectories than NAME_SET slots, and two names with same hash
+    std::map<uint32_t, std::string> hashes;
+    std::string collision[2];
+    for (int i = 0; collision[0].empty(); i++) {
+        snprintf (name, sizeof (name), "dir%06d", i);
+        uint32_t h = NAME_SET::hash (name, strlen (name));
+        if (hashes.count (h)) {
+            collision[0] = hashes[h];
+            collision[1] = name;
+        }
+        hashes[h] = name;
+    }
+    host_free_heap = 0;
+    FS_INDEX::begin();
+    for (int i = 0; i < 3; i++) {
+        create_file ("/" + collision[0] + "/f" + std::to_string (i) + ".gco", i);
+        create_file ("/" + collision[1] + "/f" + std::to_string (i) + ".gco", i);
+    }
+    ok = check ("same hash subdirectories", "/", false) && ok;
+    for (int i = 0; i < 3 * NAME_SET_SIZE; i++) {
+        for (int j = 0; j < 3; j++) {
+            snprintf (name, sizeof (name), "/sub%03d/f%d.gco", i, j);
+            create_file (name, j);
+        }
+    }
+    ok = check ("192 more subdirectories", "/", false) && ok;
+    return ok ? 0 : 1;
+}
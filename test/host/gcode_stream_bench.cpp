@@ -0,0 +1,402 @@
+/*
+  gcode_stream_bench.cpp - lines/sec of GCODE_STREAM against a simulated printer
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//printer is a Marlin like firmware: RX buffer, BUFSIZE command queue, ok sent once command is done,
+//checksum and line number checked with Resend on error
+//uart time is simulated, so results are lines/sec of simulated time, not host speed
+#include "config.h"
+#include "espcom.h"
+#include "gcode_stream.h"
+#include "cmdqueue.h"
+#include "marlin_binary.h"
+#include "telemetry.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+#define LINES_NB 3000
+#define PRINTER_RX_SIZE 128
+#define PRINTER_BUFSIZE 4
+//time to process one command once in queue (us)
+#define PRINTER_EXEC_US 500
+//esp3d loop time while waiting (us)
+#define LOOP_US 50
+//uart TX fifo of ESP, println only waits when it is full
+#define ESP_TX_FIFO 128
+
+typedef struct {
+    uint64_t time;
+    std::string data;
+} timed_t;
+
+static const uint64_t NEVER = ~(uint64_t) 0;
+
+//simulated printer
+static struct {
+    uint32_t baud;
+    bool advanced_ok;
+    uint32_t corrupt_every;
+    std::deque<timed_t> to_printer;
+    uint64_t to_printer_free;
+    std::deque<std::string> rx;
+    size_t rx_bytes;
+    size_t rx_max;
+    uint32_t overflows;
+    std::deque<std::string> queue;
+    uint64_t exec_end;
+    long last_line;
+    uint32_t received;
+    std::deque<timed_t> to_esp;
+    uint64_t to_esp_free;
+    std::vector<std::string> file;
+} printer;
+
+static uint64_t byte_time (size_t len)
+{
+    return (uint64_t) len * 10000000ULL / printer.baud;
+}
+
+static void answer (uint64_t time, const std::string & s)
+{
+    uint64_t start = (time > printer.to_esp_free) ? time : printer.to_esp_free;
+    printer.to_esp_free = start + byte_time (s.size());
+    timed_t t = {printer.to_esp_free, s};
+    printer.to_esp.push_back (t);
+}
+
+static uint8_t checksum (const char * line, size_t len)
+{
+    uint8_t c = 0;
+    for (size_t i = 0; i < len; i++) {
+        c ^= line[i];
+    }
+    return c;
+}
+
+//N<nb> <gcode>*<crc>
+static void parse_line (uint64_t time, std::string line)
+{
+    printer.received++;
+    if (printer.corrupt_every && ((printer.received % printer.corrupt_every) == 0)) {
+        line[line.size() / 2] ^= 1;
+    }
+    std::string resend = "Resend: " + std::to_string (printer.last_line + 1) + "\nok\n";
+    size_t star = line.rfind ('*');
+    if ((star == std::string::npos) || (checksum (line.c_str(), star) != atoi (line.c_str() + star + 1))) {
+        answer (time, "Error:checksum mismatch, Last Line: " + std::to_string (printer.last_line) + "\n" + resend);
+        return;
+    }
+    long nb = atol (line.c_str() + 1);
+    if (nb != printer.last_line + 1) {
+        answer (time, "Error:Line Number is not Last Line Number+1, Last Line: " + std::to_string (printer.last_line) + "\n" + resend);
+        return;
+    }
+    printer.last_line = nb;
+    size_t space = line.find (' ');
+    printer.queue.push_back (line.substr (space + 1, star - space - 1));
+}
+
+//run printer until time
+static void printer_run (uint64_t now)
+{
+    while (true) {
+        uint64_t arrival = printer.to_printer.empty() ? NEVER : printer.to_printer.front().time;
+        uint64_t done = printer.exec_end;
+        uint64_t time = (arrival < done) ? arrival : done;
+        if (time > now) {
+            return;
+        }
+        if (done <= arrival) {
+            printer.file.push_back (printer.queue.front());
+            printer.queue.pop_front();
+            printer.exec_end = NEVER;
+            if (printer.advanced_ok) {
+                answer (time, "ok N" + std::to_string (printer.last_line) + " P15 B" + std::to_string (PRINTER_BUFSIZE - printer.queue.size()) + "\n");
+            } else {
+                answer (time, "ok\n");
+            }
+        } else {
+            std::string line = printer.to_printer.front().data;
+            printer.to_printer.pop_front();
+            if (printer.rx_bytes + line.size() + 1 > PRINTER_RX_SIZE) {
+                printer.overflows++;
+            } else {
+                printer.rx.push_back (line);
+                printer.rx_bytes += line.size() + 1;
+                if (printer.rx_bytes > printer.rx_max) {
+                    printer.rx_max = printer.rx_bytes;
+                }
+            }
+        }
+        while (!printer.rx.empty() && (printer.queue.size() < PRINTER_BUFSIZE)) {
+            std::string line = printer.rx.front();
+            printer.rx.pop_front();
+            printer.rx_bytes -= line.size() + 1;
+            parse_line (time, line);
+        }
+        if ((printer.exec_end == NEVER) && !printer.queue.empty()) {
+            printer.exec_end = time + PRINTER_EXEC_US;
+        }
+    }
+}
+
+static void printer_reset (uint32_t baud, bool advanced_ok, uint32_t corrupt_every)
+{
+    printer.baud = baud;
+    printer.advanced_ok = advanced_ok;
+    printer.corrupt_every = corrupt_every;
+    printer.to_printer.clear();
+    printer.to_printer_free = 0;
+    printer.rx.clear();
+    printer.rx_bytes = 0;
+    printer.rx_max = 0;
+    printer.overflows = 0;
+    printer.queue.clear();
+    printer.exec_end = NEVER;
+    printer.last_line = 0;
+    printer.received = 0;
+    printer.to_esp.clear();
+    printer.to_esp_free = 0;
+    printer.file.clear();
+    host_time_us = 0;
+}
+
+//ESP3D side
+uint8_t Checksum (const char * line, uint16_t lineSize)
+{
+    return checksum (line, lineSize);
+}
+
+void CONFIG::wait (uint32_t milliseconds)
+{
+    host_time_us += milliseconds ? milliseconds * 1000 : LOOP_US;
+}
+
+bool CONFIG::read_byte (int pos, byte * value)
+{
+    *value = DEFAULT_STREAM_WINDOW;
+    return true;
+}
+
+uint8_t CONFIG::GetFirmwareTarget()
+{
+    return MARLIN;
+}
+
+void ESPCOM::println (const char * data, tpipe output, ESPResponseStream * espresponse)
+{
+    std::string line (data);
+    uint64_t start = (host_time_us > printer.to_printer_free) ? host_time_us : printer.to_printer_free;
+    printer.to_printer_free = start + byte_time (line.size() + 1);
+    timed_t t = {printer.to_printer_free, line};
+    printer.to_printer.push_back (t);
+    //wait room in TX fifo
+    uint64_t fifo_time = byte_time (ESP_TX_FIFO);
+    if (printer.to_printer_free > host_time_us + fifo_time) {
+        host_time_us = printer.to_printer_free - fifo_time;
+    }
+}
+
+size_t ESPCOM::write (tpipe output, uint8_t d)
+{
+    return 1;
+}
+
+size_t ESPCOM::available (tpipe output)
+{
+    printer_run (host_time_us);
+    size_t len = 0;
+    for (size_t i = 0; (i < printer.to_esp.size()) && (printer.to_esp[i].time <= host_time_us); i++) {
+        len += printer.to_esp[i].data.size();
+    }
+    return len;
+}
+
+long ESPCOM::readBytes (tpipe output, uint8_t * sbuf, size_t len)
+{
+    size_t n = 0;
+    while ((n < len) && !printer.to_esp.empty() && (printer.to_esp.front().time <= host_time_us)) {
+        std::string & s = printer.to_esp.front().data;
+        size_t l = (s.size() < len - n) ? s.size() : len - n;
+        memcpy (&sbuf[n], s.data(), l);
+        n += l;
+        s.erase (0, l);
+        if (s.empty()) {
+            printer.to_esp.pop_front();
+        }
+    }
+    return n;
+}
+
+bool ESPCOM::processFromSerial (bool async)
+{
+    return false;
+}
+
+void ESPCOM::poll_urgent() {}
+
+void TELEMETRY::parse (const char * line, size_t len) {}
+
+bool MARLIN_BINARY::_active = false;
+
+static std::string gcode (int i)
+{
+    char line[64];
+    snprintf (line, sizeof (line), "G1 X%d.%03d Y%d.%03d E%d.%05d F1800", i % 200, i % 1000, (i * 7) % 200, (i * 3) % 1000, i % 10, i % 100000);
+    return line;
+}
+
+//old upload: one line, wait its ok, next line (without the 5 ms waits of old code)
+static double stop_and_wait (uint32_t baud)
+{
+    printer_reset (baud, false, 0);
+    for (int i = 0; i < LINES_NB; i++) {
+        std::string line = "N" + std::to_string (i + 1) + " " + gcode (i);
+        line += "*" + std::to_string (checksum (line.c_str(), line.size()));
+        ESPCOM::println (line.c_str(), DEFAULT_PRINTER_PIPE);
+        std::string ans;
+        while (ans.find ("ok") == std::string::npos) {
+            CONFIG::wait (0);
+            uint8_t buf[64];
+            size_t len = ESPCOM::available (DEFAULT_PRINTER_PIPE);
+            if (len > sizeof (buf)) {
+                len = sizeof (buf);
+            }
+            len = ESPCOM::readBytes (DEFAULT_PRINTER_PIPE, buf, len);
+            ans.append ((const char *) buf, len);
+        }
+    }
+    return LINES_NB * 1e6 / host_time_us;
+}
+
+//same file through GCODE_STREAM, false if printer did not get exactly the file
+static bool stream (uint32_t baud, uint8_t window, bool advanced_ok, uint32_t corrupt_every, double & rate)
+{
+    printer_reset (baud, advanced_ok, corrupt_every);
+    GCODE_STREAM::init_credit();
+    GCODE_STREAM::begin (1, window);
+    for (int i = 0; i < LINES_NB; i++) {
+        if (!GCODE_STREAM::push (gcode (i).c_str())) {
+            printf ("push failed at line %d\n", i);
+            return false;
+        }
+    }
+    bool res = GCODE_STREAM::flush();
+    GCODE_STREAM::end();
+    rate = LINES_NB * 1e6 / host_time_us;
+    if (!res || (printer.file.size() != LINES_NB)) {
+        printf ("stream failed, %u lines received\n", (unsigned) printer.file.size());
+        return false;
+    }
+    for (int i = 0; i < LINES_NB; i++) {
+        if (printer.file[i] != gcode (i)) {
+            printf ("line %d differs\n", i);
+            return false;
+        }
+    }
+    if (printer.overflows > 0) {
+        printf ("printer RX buffer overflowed %u times\n", printer.overflows);
+        return false;
+    }
+    return true;
+}
+
+//window 4: a tcp host has 4 raw lines in flight, web has 4 credited lines in flight
+//acks of tcp lines must not free credits, next ack frees exactly one
+static bool credits()
+{
+    printer_reset (115200, false, 0);
+    CMD_QUEUE::clear();
+    GCODE_STREAM::init_credit();
+    const char * raw = "G1 X1\nG1 X2\nG1 X3\nG1 X4\n";
+    CMD_QUEUE::add_raw (ORIGIN_TCP, 0, (const uint8_t *) raw, strlen (raw));
+    int sent = 0;
+    while ((sent < 10) && CMD_QUEUE::send ("G1 Y1", ORIGIN_WEB, 0, NULL, NULL, NULL, 0)) {
+        sent++;
+    }
+    int freed = 0;
+    //as ESPCOM::process_answers does
+    for (int i = 0; i < 4; i++) {
+        bool credit = CMD_QUEUE::on_answer ("ok", 2);
+        GCODE_STREAM::process_answer ("ok", credit);
+        freed += credit ? 1 : 0;
+    }
+    bool full = !GCODE_STREAM::has_credit();
+    bool credit = CMD_QUEUE::on_answer ("ok", 2);
+    GCODE_STREAM::process_answer ("ok", credit);
+    int more = 0;
+    while ((more < 10) && CMD_QUEUE::send ("G1 Y2", ORIGIN_WEB, 0, NULL, NULL, NULL, 0)) {
+        more++;
+    }
+    bool res = (sent == 4) && (freed == 0) && full && credit && (more == 1);
+    printf ("window 4, 4 tcp + %d web lines  tcp acks freed %d credits  next ack freed %d%s\n", sent, freed, more, res ? "" : "  FAILED");
+    return res;
+}
+
+//window 4 with an urgent line written by emergency lane: stream keeps its 4th line until an ok
+static bool urgent_line()
+{
+    printer_reset (115200, false, 0);
+    GCODE_STREAM::begin (1, 4);
+    GCODE_STREAM::count_line (4);
+    for (int i = 0; i < 3; i++) {
+        GCODE_STREAM::push (gcode (i).c_str());
+    }
+    uint32_t sent = GCODE_STREAM::lines_sent;
+    bool full = !GCODE_STREAM::has_credit();
+    GCODE_STREAM::process_answer ("ok");
+    bool freed = GCODE_STREAM::has_credit();
+    GCODE_STREAM::end();
+    bool res = (sent == 3) && full && freed;
+    printf ("window 4, 1 urgent line  %u lines sent, window %s, %s after ok%s\n", sent, full ? "full" : "not full", freed ? "1 free" : "still full", res ? "" : "  FAILED");
+    return res;
+}
+
+int main()
+{
+    static const uint32_t bauds[] = {115200, 250000};
+    bool ok = true;
+    for (size_t b = 0; b < sizeof (bauds) / sizeof (bauds[0]); b++) {
+        uint32_t baud = bauds[b];
+        double base = stop_and_wait (baud);
+        printf ("%6u baud  stop and wait             %6.0f lines/s\n", baud, base);
+        static const struct {
+            const char * label;
+            uint8_t window;
+            bool advanced_ok;
+            uint32_t corrupt_every;
+        } runs[] = {
+            {"window 4                 ", 4, false, 0},
+            {"window 7                 ", 7, false, 0},
+            {"ADVANCED_OK              ", 7, true, 0},
+            {"window 4, 1 error / 50   ", 4, false, 50},
+        };
+        for (size_t r = 0; r < sizeof (runs) / sizeof (runs[0]); r++) {
+            double rate = 0;
+            bool res = stream (baud, runs[r].window, runs[r].advanced_ok, runs[r].corrupt_every, rate);
+            printf ("%6u baud  %s %6.0f lines/s  x%.2f  resent %u  printer RX max %u bytes%s\n", baud, runs[r].label, rate, rate / base,
+                    GCODE_STREAM::lines_resent, (unsigned) printer.rx_max, res ? "" : "  FAILED");
+            ok = ok && res;
+        }
+    }
+    ok = credits() && ok;
+    ok = urgent_line() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/*
+  httprange_test.cpp - Range and If-Range headers of SPIFFS downloads
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//expected answer of each header for a file of 1000 bytes: 200 whole file, 206 part, 416 not satisfiable
+#include "httprange.h"
+
+#define FILE_SIZE 1000
+
+static const struct {
+    const char * header;
+    uint32_t size;
+    int8_t result;
+    uint32_t first;
+    uint32_t last;
+} ranges[] = {
+    {"bytes=0-99", FILE_SIZE, RANGE_PARTIAL, 0, 99},
+    {"bytes=100-100", FILE_SIZE, RANGE_PARTIAL, 100, 100},
+    {"bytes=900-2000", FILE_SIZE, RANGE_PARTIAL, 900, 999},
+    //open ended
+    {"bytes=500-", FILE_SIZE, RANGE_PARTIAL, 500, 999},
+    {"bytes= 999-", FILE_SIZE, RANGE_PARTIAL, 999, 999},
+    //suffix
+    {"bytes=-100", FILE_SIZE, RANGE_PARTIAL, 900, 999},
+    {"bytes=-5000", FILE_SIZE, RANGE_PARTIAL, 0, 999},
+    {"bytes=-0", FILE_SIZE, RANGE_NOT_SATISFIABLE, 0, 0},
+    //start past end of file
+    {"bytes=1000-", FILE_SIZE, RANGE_NOT_SATISFIABLE, 0, 0},
+    {"bytes=1000-1100", FILE_SIZE, RANGE_NOT_SATISFIABLE, 0, 0},
+    {"bytes=99999999999-", FILE_SIZE, RANGE_NOT_SATISFIABLE, 0, 0},
+    {"bytes=0-", 0, RANGE_NOT_SATISFIABLE, 0, 0},
+    {"bytes=-10", 0, RANGE_NOT_SATISFIABLE, 0, 0},
+    //multi range, other unit and malformed headers
+    {"bytes=0-10,20-30", FILE_SIZE, RANGE_WHOLE_FILE, 0, 0},
+    {"bytes=-10, 0-5", FILE_SIZE, RANGE_WHOLE_FILE, 0, 0},
+    {"items=0-10", FILE_SIZE, RANGE_WHOLE_FILE, 0, 0},
+    {"bytes=20-10", FILE_SIZE, RANGE_WHOLE_FILE, 0, 0},
+    {"bytes=abc", FILE_SIZE, RANGE_WHOLE_FILE, 0, 0},
+    {"bytes=-", FILE_SIZE, RANGE_WHOLE_FILE, 0, 0},
+    {"bytes=10", FILE_SIZE, RANGE_WHOLE_FILE, 0, 0},
+};
+
+static const struct {
+    const char * range;
+    const char * if_range;
+    const char * etag;
+    bool applies;
+} conditions[] = {
+    {"bytes=0-9", "", "\"1234abcd\"", true},
+    {"bytes=0-9", "", "", true},
+    {"bytes=0-9", "\"1234abcd\"", "\"1234abcd\"", true},
+    //file changed since client got first part
+    {"bytes=0-9", "\"0badf00d\"", "\"1234abcd\"", false},
+    //file not indexed, no ETag to compare
+    {"bytes=0-9", "\"1234abcd\"", "", false},
+    {"bytes=0-9", "W/\"1234abcd\"", "\"1234abcd\"", false},
+    {"bytes=0-9", "Sat, 17 Oct 2026 10:00:00 GMT", "\"1234abcd\"", false},
+    {"", "", "\"1234abcd\"", false},
+};
+
+static int answer (int8_t result)
+{
+    return (result == RANGE_PARTIAL) ? 206 : (result == RANGE_NOT_SATISFIABLE) ? 416 : 200;
+}
+
+int main()
+{
+    int failed = 0;
+    for (size_t i = 0; i < sizeof (ranges) / sizeof (ranges[0]); i++) {
+        uint32_t first = 0;
+        uint32_t last = 0;
+        int8_t res = HTTP_RANGE::parse (ranges[i].header, ranges[i].size, first, last);
+        bool ok = (res == ranges[i].result) && ((res != RANGE_PARTIAL) || ((first == ranges[i].first) && (last == ranges[i].last)));
+        printf ("%-22s size %4u  %d", ranges[i].header, ranges[i].size, answer (res));
+        if (res == RANGE_PARTIAL) {
+            printf (" %u-%u", first, last);
+        }
+        printf ("%s\n", ok ? "" : "  FAILED");
+        failed += ok ? 0 : 1;
+    }
+    for (size_t i = 0; i < sizeof (conditions) / sizeof (conditions[0]); i++) {
+        bool res = HTTP_RANGE::applies (conditions[i].range, conditions[i].if_range, conditions[i].etag);
+        bool ok = res == conditions[i].applies;
+        printf ("If-Range [%s] ETag [%s]  %s%s\n", conditions[i].if_range, conditions[i].etag, res ? "range" : "whole file", ok ? "" : "  FAILED");
+        failed += ok ? 0 : 1;
+    }
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+/*
+  marlin_binary_bench.cpp - MARLIN_BINARY against a stand-in of Marlin binary file transfer
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//stand-in follows BINARY_FILE_TRANSFER of Marlin: packets with fletcher 16 checksums,
+//ok<sync> / rs<sync> answers, PFT: file commands and heatshrink (8, 4) decoding
+//uart time is simulated, so results are bytes/sec of simulated time, not host speed
+#include "config.h"
+#include "espcom.h"
+#include "marlin_binary.h"
+#include "cmdqueue.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+#define BAUD_RATE 115200
+#define STANDIN_BLOCK_SIZE 512
+//time to write a block on SD card (us)
+#define STANDIN_BLOCK_US 1000
+//esp3d loop time while waiting (us)
+#define LOOP_US 50
+
+typedef struct {
+    uint64_t time;
+    std::string data;
+} timed_t;
+
+//printer stand-in
+static struct {
+    bool supported;
+    bool heatshrink;
+    uint32_t corrupt_every;
+    bool binary;
+    uint8_t sync;
+    uint64_t to_printer_free;
+    uint64_t busy_until;
+    std::string ascii;
+    std::vector<uint8_t> packet;
+    uint32_t packets;
+    uint32_t resends;
+    bool compressed;
+    std::vector<uint8_t> received;
+    std::string file;
+    bool file_closed;
+    std::deque<timed_t> to_esp;
+    uint64_t to_esp_free;
+} printer;
+
+static uint64_t byte_time (size_t len)
+{
+    return (uint64_t) len * 10000000ULL / BAUD_RATE;
+}
+
+static void answer (uint64_t time, const std::string & s)
+{
+    uint64_t start = (time > printer.to_esp_free) ? time : printer.to_esp_free;
+    printer.to_esp_free = start + byte_time (s.size());
+    timed_t t = {printer.to_esp_free, s};
+    printer.to_esp.push_back (t);
+}
+
+static uint16_t fletcher16 (const uint8_t * data, size_t len)
+{
+    uint16_t low = 0;
+    uint16_t high = 0;
+    for (size_t i = 0; i < len; i++) {
+        low = (low + data[i]) % 255;
+        high = (high + low) % 255;
+    }
+    return (high << 8) | low;
+}
+
+//heatshrink decoder, window 8 bits, lookahead 4 bits, written from the format description
+static std::string heatshrink_decode (const std::vector<uint8_t> & in)
+{
+    std::string out;
+    size_t bit = 0;
+    size_t nbits = in.size() * 8;
+    while (true) {
+        uint32_t v[3] = {0, 0, 0};
+        static const uint8_t literal[] = {1, 8};
+        static const uint8_t backref[] = {1, 8, 4};
+        //tag bit 1: literal byte, 0: index and count of back reference
+        if (bit + 1 > nbits) {
+            break;
+        }
+        bool is_literal = (in[bit / 8] >> (7 - (bit % 8))) & 1;
+        const uint8_t * fields = is_literal ? literal : backref;
+        uint8_t nb = is_literal ? 2 : 3;
+        bool complete = true;
+        for (uint8_t f = 0; f < nb; f++) {
+            if (bit + fields[f] > nbits) {
+                complete = false;
+                break;
+            }
+            for (uint8_t i = 0; i < fields[f]; i++, bit++) {
+                v[f] = (v[f] << 1) | ((in[bit / 8] >> (7 - (bit % 8))) & 1);
+            }
+        }
+        if (!complete) {
+            break;
+        }
+        if (is_literal) {
+            out += (char) v[1];
+        } else {
+            size_t offset = v[1] + 1;
+            for (uint32_t i = 0; i <= v[2]; i++) {
+                out += out[out.size() - offset];
+            }
+        }
+    }
+    return out;
+}
+
+static void handle_packet (uint64_t time)
+{
+    const uint8_t * p = printer.packet.data();
+    uint8_t sync = p[2];
+    uint8_t protocol = p[3] >> 4;
+    uint8_t type = p[3] & 0x0F;
+    uint16_t len = p[4] | (p[5] << 8);
+    const uint8_t * data = p + 8;
+    //sync packet is answered whatever the sync number
+    if ((protocol == 0) && (type == 1)) {
+        answer (time, "ss" + std::to_string (printer.sync) + "," + std::to_string (STANDIN_BLOCK_SIZE) + ",0.1.0\n");
+        return;
+    }
+    if (sync != printer.sync) {
+        //already received: ok was lost
+        if (sync == (uint8_t) (printer.sync - 1)) {
+            answer (time, "ok" + std::to_string (sync) + "\n");
+        } else {
+            answer (time, "rs" + std::to_string (printer.sync) + "\n");
+        }
+        return;
+    }
+    printer.sync++;
+    answer (time, "ok" + std::to_string (sync) + "\n");
+    if (protocol == 0) {
+        if (type == 2) {
+            printer.binary = false;
+        }
+        return;
+    }
+    switch (type) {
+    case 0:
+        answer (time, printer.heatshrink ? "PFT:version:0.1.0:compresion:heatshrink,8,4\n" : "PFT:version:0.1.0:compresion:none\n");
+        break;
+    case 1:
+        printer.compressed = (data[1] != 0);
+        printer.received.clear();
+        printer.file.clear();
+        printer.file_closed = false;
+        answer (time, "PFT:success\n");
+        break;
+    case 2:
+        if (printer.compressed) {
+            printer.file = heatshrink_decode (printer.received);
+        } else {
+            printer.file.assign (printer.received.begin(), printer.received.end());
+        }
+        printer.file_closed = true;
+        answer (time, "PFT:success\n");
+        break;
+    case 3:
+        printer.received.insert (printer.received.end(), data, data + len);
+        printer.busy_until = time + STANDIN_BLOCK_US;
+        break;
+    case 4:
+        answer (time, "PFT:success\n");
+        break;
+    default:
+        break;
+    }
+}
+
+static void printer_byte (uint64_t time, uint8_t c)
+{
+    if (!printer.binary) {
+        if (c != '\n') {
+            printer.ascii += c;
+            return;
+        }
+        if (printer.ascii == "M115") {
+            answer (time, printer.supported ? "FIRMWARE_NAME:Marlin\nCap:BINARY_FILE_TRANSFER:1\nok\n" : "FIRMWARE_NAME:Marlin\nok\n");
+        } else if (printer.ascii == "M28B1") {
+            printer.binary = true;
+            printer.sync = 0;
+            answer (time, "echo:Switching to Binary Protocol\nok\n");
+        }
+        printer.ascii.clear();
+        return;
+    }
+    printer.packet.push_back (c);
+    //wait token 0xAD 0xB5
+    if ((printer.packet.size() == 1) && (c != 0xAD)) {
+        printer.packet.clear();
+        return;
+    }
+    if ((printer.packet.size() == 2) && (c != 0xB5)) {
+        printer.packet.clear();
+        return;
+    }
+    if (printer.packet.size() < 8) {
+        return;
+    }
+    const uint8_t * p = printer.packet.data();
+    uint16_t len = p[4] | (p[5] << 8);
+    if ((printer.packet.size() == 8) && (fletcher16 (&p[2], 4) != (p[6] | (p[7] << 8)))) {
+        answer (time, "rs" + std::to_string (printer.sync) + "\n");
+        printer.packet.clear();
+        return;
+    }
+    size_t total = len ? (8 + len + 2) : 8;
+    if (printer.packet.size() < total) {
+        return;
+    }
+    printer.packets++;
+    if (len) {
+        bool corrupted = printer.corrupt_every && ((printer.packets % printer.corrupt_every) == 0);
+        if (corrupted || (fletcher16 (&p[2], 6 + len) != (p[8 + len] | (p[9 + len] << 8)))) {
+            printer.resends++;
+            answer (time, "rs" + std::to_string (printer.sync) + "\n");
+            printer.packet.clear();
+            return;
+        }
+    }
+    //previous block must be on SD before next packet is processed
+    if (printer.busy_until > time) {
+        time = printer.busy_until;
+    }
+    handle_packet (time);
+    printer.packet.clear();
+}
+
+static void printer_reset (bool supported, bool heatshrink, uint32_t corrupt_every)
+{
+    printer.supported = supported;
+    printer.heatshrink = heatshrink;
+    printer.corrupt_every = corrupt_every;
+    printer.binary = false;
+    printer.sync = 0;
+    printer.to_printer_free = 0;
+    printer.busy_until = 0;
+    printer.ascii.clear();
+    printer.packet.clear();
+    printer.packets = 0;
+    printer.resends = 0;
+    printer.received.clear();
+    printer.file.clear();
+    printer.file_closed = false;
+    printer.to_esp.clear();
+    printer.to_esp_free = 0;
+    host_time_us = 0;
+}
+
+//ESP3D side: writes wait for the uart, each byte reaches printer once sent
+bool purge_serial()
+{
+    return true;
+}
+
+void CONFIG::wait (uint32_t milliseconds)
+{
+    host_time_us += milliseconds ? milliseconds * 1000 : LOOP_US;
+}
+
+uint8_t CONFIG::GetFirmwareTarget()
+{
+    return MARLIN;
+}
+
+void CMD_QUEUE::clear() {}
+
+size_t ESPCOM::write (tpipe output, const uint8_t * buf, size_t len)
+{
+    uint64_t time = (host_time_us > printer.to_printer_free) ? host_time_us : printer.to_printer_free;
+    for (size_t i = 0; i < len; i++) {
+        time += byte_time (1);
+        printer_byte (time, buf[i]);
+    }
+    printer.to_printer_free = time;
+    host_time_us = time;
+    return len;
+}
+
+size_t ESPCOM::write (tpipe output, uint8_t d)
+{
+    return write (output, &d, 1);
+}
+
+void ESPCOM::println (const __FlashStringHelper * data, tpipe output, ESPResponseStream * espresponse)
+{
+    std::string line ((const char *) data);
+    line += "\n";
+    write (output, (const uint8_t *) line.data(), line.size());
+}
+
+size_t ESPCOM::available (tpipe output)
+{
+    size_t len = 0;
+    for (size_t i = 0; (i < printer.to_esp.size()) && (printer.to_esp[i].time <= host_time_us); i++) {
+        len += printer.to_esp[i].data.size();
+    }
+    return len;
+}
+
+long ESPCOM::readBytes (tpipe output, uint8_t * sbuf, size_t len)
+{
+    size_t n = 0;
+    while ((n < len) && !printer.to_esp.empty() && (printer.to_esp.front().time <= host_time_us)) {
+        std::string & s = printer.to_esp.front().data;
+        size_t l = (s.size() < len - n) ? s.size() : len - n;
+        memcpy (&sbuf[n], s.data(), l);
+        n += l;
+        s.erase (0, l);
+        if (s.empty()) {
+            printer.to_esp.pop_front();
+        }
+    }
+    return n;
+}
+
+void ESPCOM::poll_urgent() {}
+
+//g-code like file with comments, as sliced files are
+static std::string gcode_file()
+{
+    std::string f;
+    srand (1);
+    for (int i = 0; i < 20000; i++) {
+        char line[80];
+        snprintf (line, sizeof (line), "G1 X%d.%03d Y%d.%03d E%d.%05d F%d\n", rand() % 200, rand() % 1000, rand() % 200, rand() % 1000, rand() % 100, rand() % 100000, 1200 + 600 * (rand() % 4));
+        f += line;
+        if ((i % 50) == 0) {
+            f += ";LAYER:" + std::to_string (i / 50) + "\n";
+        }
+    }
+    return f;
+}
+
+//wire bytes of same file with N<line> <gcode>*<crc> lines, comments are not sent
+static size_t ascii_size (const std::string & f)
+{
+    size_t size = 0;
+    long nb = 1;
+    size_t start = 0;
+    while (start < f.size()) {
+        size_t end = f.find ('\n', start);
+        if (f[start] != ';') {
+            size += (end - start) + std::to_string (nb).size() + 2 + 4 + 1;
+            nb++;
+        }
+        start = end + 1;
+    }
+    return size;
+}
+
+int main()
+{
+    std::string f = gcode_file();
+    bool ok = true;
+    double ascii_time = ascii_size (f) * 10.0 / BAUD_RATE;
+    printf ("%u bytes at %d baud, ascii lines need at least %.1f s (%.0f bytes/s)\n", (unsigned) f.size(), BAUD_RATE, ascii_time, f.size() / ascii_time);
+    static const struct {
+        const char * label;
+        bool supported;
+        bool heatshrink;
+        uint32_t corrupt_every;
+    } runs[] = {
+        {"heatshrink                ", true, true, 0},
+        {"no compression            ", true, false, 0},
+        {"heatshrink, 1 error / 7   ", true, true, 7},
+        {"not supported by firmware ", false, true, 0},
+    };
+    for (size_t r = 0; r < sizeof (runs) / sizeof (runs[0]); r++) {
+        printer_reset (runs[r].supported, runs[r].heatshrink, runs[r].corrupt_every);
+        if (!MARLIN_BINARY::begin ("test.gco")) {
+            //upload falls back to ascii lines
+            bool expected = !runs[r].supported;
+            printf ("%s begin refused%s\n", runs[r].label, expected ? ", line protocol is used" : "  FAILED");
+            ok = ok && expected;
+            continue;
+        }
+        bool res = true;
+        for (size_t pos = 0; res && (pos < f.size()); pos += 2048) {
+            size_t len = (f.size() - pos < 2048) ? f.size() - pos : 2048;
+            res = MARLIN_BINARY::write ((const uint8_t *) f.data() + pos, len);
+        }
+        res = MARLIN_BINARY::end() && res;
+        res = res && printer.file_closed && (printer.file == f) && !printer.binary && !MARLIN_BINARY::is_active();
+        double seconds = host_time_us / 1e6;
+        printf ("%s %6.0f bytes/s  x%.2f  wire %u bytes (%.2f)  resends %u%s\n", runs[r].label, f.size() / seconds, ascii_time / seconds,
+                MARLIN_BINARY::bytes_sent, (double) MARLIN_BINARY::bytes_sent / f.size(), printer.resends, res ? "" : "  FAILED");
+        ok = ok && res;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,283 @@
+/*
+  Arduino.h - host build stand-in for the Arduino core
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//only what tested modules use, time is simulated (see host_time_us)
+#ifndef ARDUINO_H
+#define ARDUINO_H
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define PGM_P const char *
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+#define FPSTR(p) ((const __FlashStringHelper *)(p))
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define strlen_P strlen
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+
+//simulated time, tests move it forward
+extern uint64_t host_time_us;
+unsigned long millis();
+unsigned long micros();
+void delay (unsigned long ms);
+void yield();
+
+class String
+{
+public:
+    String (const char * s = "") : _s (s ? s : "") {}
+    String (const __FlashStringHelper * s) : _s ((const char *) s) {}
+    String (char c) : _s (1, c) {}
+    String (int v) : _s (std::to_string (v)) {}
+    String (unsigned int v) : _s (std::to_string (v)) {}
+    String (long v) : _s (std::to_string (v)) {}
+    String (unsigned long v) : _s (std::to_string (v)) {}
+    String (float v, int decimals = 2)
+    {
+        char b[32];
+        snprintf (b, sizeof (b), "%.*f", decimals, v);
+        _s = b;
+    }
+    const char * c_str() const
+    {
+        return _s.c_str();
+    }
+    unsigned int length() const
+    {
+        return _s.size();
+    }
+    bool reserve (unsigned int size)
+    {
+        _s.reserve (size);
+        return true;
+    }
+    char operator[] (unsigned int i) const
+    {
+        return (i < _s.size()) ? _s[i] : 0;
+    }
+    int indexOf (char c, unsigned int from = 0) const
+    {
+        return find (_s.find (c, from));
+    }
+    int indexOf (const char * s, unsigned int from = 0) const
+    {
+        return find (_s.find (s, from));
+    }
+    int indexOf (const String & s, unsigned int from = 0) const
+    {
+        return indexOf (s.c_str(), from);
+    }
+    int lastIndexOf (char c) const
+    {
+        return find (_s.rfind (c));
+    }
+    String substring (unsigned int from, unsigned int to) const
+    {
+        if (from > to) {
+            unsigned int t = from;
+            from = to;
+            to = t;
+        }
+        if (from > _s.size()) {
+            return String();
+        }
+        return String (_s.substr (from, to - from).c_str());
+    }
+    String substring (unsigned int from) const
+    {
+        return substring (from, _s.size());
+    }
+    bool startsWith (const String & s) const
+    {
+        return _s.compare (0, s._s.size(), s._s) == 0;
+    }
+    bool endsWith (const String & s) const
+    {
+        return (_s.size() >= s._s.size()) && (_s.compare (_s.size() - s._s.size(), s._s.size(), s._s) == 0);
+    }
+    void trim()
+    {
+        size_t b = 0;
+        size_t e = _s.size();
+        while ((b < e) && isspace ((unsigned char) _s[b])) {
+            b++;
+        }
+        while ((e > b) && isspace ((unsigned char) _s[e - 1])) {
+            e--;
+        }
+        _s = _s.substr (b, e - b);
+    }
+    void remove (unsigned int index, unsigned int count = (unsigned int) -1)
+    {
+        if (index < _s.size()) {
+            _s.erase (index, count);
+        }
+    }
+    long toInt() const
+    {
+        return atol (_s.c_str());
+    }
+    void toUpperCase()
+    {
+        for (size_t i = 0; i < _s.size(); i++) {
+            _s[i] = toupper ((unsigned char) _s[i]);
+        }
+    }
+    bool concat (const String & s)
+    {
+        _s += s._s;
+        return true;
+    }
+    String & operator+= (const String & s)
+    {
+        _s += s._s;
+        return *this;
+    }
+    String & operator+= (const char * s)
+    {
+        _s += s;
+        return *this;
+    }
+    String & operator+= (char c)
+    {
+        _s += c;
+        return *this;
+    }
+    bool operator== (const String & s) const
+    {
+        return _s == s._s;
+    }
+    bool operator== (const char * s) const
+    {
+        return _s == s;
+    }
+    bool operator!= (const String & s) const
+    {
+        return _s != s._s;
+    }
+    bool operator!= (const char * s) const
+    {
+        return _s != s;
+    }
+private:
+    std::string _s;
+    static int find (size_t pos)
+    {
+        return (pos == std::string::npos) ? -1 : (int) pos;
+    }
+};
+
+inline String operator+ (const String & a, const String & b)
+{
+    String s (a);
+    s += b;
+    return s;
+}
+inline String operator+ (const String & a, const char * b)
+{
+    String s (a);
+    s += b;
+    return s;
+}
+inline String operator+ (const char * a, const String & b)
+{
+    String s (a);
+    s += b;
+    return s;
+}
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write (uint8_t c) = 0;
+    virtual size_t write (const uint8_t * buf, size_t len)
+    {
+        size_t n = 0;
+        while ((n < len) && write (buf[n])) {
+            n++;
+        }
+        return n;
+    }
+    size_t print (const char * s)
+    {
+        return write ((const uint8_t *) s, strlen (s));
+    }
+    size_t print (const String & s)
+    {
+        return print (s.c_str());
+    }
+    size_t println (const char * s)
+    {
+        return print (s) + print ("\r\n");
+    }
+    size_t println (const String & s)
+    {
+        return println (s.c_str());
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available()
+    {
+        return 0;
+    }
+    virtual int read()
+    {
+        return -1;
+    }
+};
+
+//free heap is set by tests
+extern uint32_t host_free_heap;
+class EspClass
+{
+public:
+    uint32_t getFreeHeap()
+    {
+        return host_free_heap;
+    }
+};
+extern EspClass ESP;
+
+//serial output is not used by tested modules
+class HardwareSerial : public Stream
+{
+public:
+    size_t write (uint8_t c)
+    {
+        return 1;
+    }
+    void flush() {}
+};
+extern HardwareSerial Serial;
+
+#endif
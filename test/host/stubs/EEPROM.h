@@ -0,0 +1,35 @@
+//host build stand-in: RAM image of emulated EEPROM, commits are counted
+#ifndef EEPROM_H
+#define EEPROM_H
+#include <Arduino.h>
+
+#define HOST_EEPROM_SIZE 4096
+
+class EEPROMClass
+{
+public:
+    EEPROMClass() : commits (0)
+    {
+        memset (data, 0xFF, sizeof (data));
+    }
+    void begin (size_t size) {}
+    uint8_t read (int pos)
+    {
+        return data[pos];
+    }
+    void write (int pos, uint8_t value)
+    {
+        data[pos] = value;
+    }
+    //each commit erases and writes the whole flash sector
+    bool commit()
+    {
+        commits++;
+        return true;
+    }
+    uint8_t data[HOST_EEPROM_SIZE];
+    uint32_t commits;
+};
+extern EEPROMClass EEPROM;
+
+#endif
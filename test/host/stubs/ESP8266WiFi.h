@@ -0,0 +1,26 @@
+//host build stand-in, wifi is not used by tested modules
+#ifndef ESP8266WIFI_H
+#define ESP8266WIFI_H
+#include <Arduino.h>
+#include "IPAddress.h"
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} WiFiMode_t;
+
+class ESP8266WiFiClass
+{
+public:
+    WiFiMode_t getMode()
+    {
+        return WIFI_OFF;
+    }
+};
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,9 @@
+//host build stand-in, mdns is not used by tested modules
+#ifndef ESP8266MDNS_H
+#define ESP8266MDNS_H
+
+class MDNSResponder
+{
+};
+
+#endif
@@ -0,0 +1,128 @@
+//host build stand-in for SPIFFS: files are kept in memory
+//flash use is counted and a power cut can be simulated after a number of written bytes
+#ifndef FS_H
+#define FS_H
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+//SPIFFS geometry used to count flash work
+#define HOST_FS_PAGE_SIZE 256
+#define HOST_FS_BLOCK_SIZE 4096
+
+typedef struct {
+    std::map<std::string, std::vector<uint8_t> > files;
+    //bytes which can still be written before power cut, -1 = no cut
+    long budget;
+    bool power_cut;
+    //flash pages programmed (data and index) since start
+    uint32_t pages;
+} host_fs_t;
+extern host_fs_t host_fs;
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+namespace fs
+{
+
+class File : public Stream
+{
+public:
+    File() : _open (false), _pos (0), _written (0) {}
+    size_t write (uint8_t c)
+    {
+        return write (&c, 1);
+    }
+    size_t write (const uint8_t * buf, size_t len);
+    size_t read (uint8_t * buf, size_t len);
+    int read()
+    {
+        uint8_t c;
+        return (read (&c, 1) == 1) ? c : -1;
+    }
+    int available()
+    {
+        return _open ? (int) (host_fs.files[_name].size() - _pos) : 0;
+    }
+    bool seek (uint32_t pos, SeekMode mode = SeekSet);
+    size_t size()
+    {
+        return _open ? host_fs.files[_name].size() : 0;
+    }
+    void close();
+    operator bool() const
+    {
+        return _open;
+    }
+private:
+    friend class FS;
+    bool _open;
+    std::string _name;
+    size_t _pos;
+    size_t _written;
+};
+
+//names starting with path, as they were when directory was opened
+class Dir
+{
+public:
+    Dir() : _next (0) {}
+    bool next()
+    {
+        if (_next >= _names.size()) {
+            return false;
+        }
+        _current = _names[_next++];
+        return true;
+    }
+    String fileName()
+    {
+        return String (_current.c_str());
+    }
+    size_t fileSize()
+    {
+        return host_fs.files.count (_current) ? host_fs.files[_current].size() : 0;
+    }
+private:
+    friend class FS;
+    std::vector<std::string> _names;
+    size_t _next;
+    std::string _current;
+};
+
+class FS
+{
+public:
+    bool begin()
+    {
+        return !host_fs.power_cut;
+    }
+    File open (const char * path, const char * mode);
+    bool exists (const char * path)
+    {
+        return host_fs.files.count (path) > 0;
+    }
+    bool exists (const String & path)
+    {
+        return exists (path.c_str());
+    }
+    bool remove (const char * path);
+    Dir openDir (const String & path);
+};
+
+}
+
+#ifndef FS_NO_GLOBALS
+using fs::FS;
+using fs::File;
+using fs::Dir;
+#endif
+
+extern fs::FS SPIFFS;
+
+#endif
@@ -0,0 +1,18 @@
+//host build stand-in, addresses are not used by tested modules
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+#include <Arduino.h>
+
+class IPAddress
+{
+public:
+    IPAddress (uint32_t address = 0) : _address (address) {}
+    uint8_t operator[] (int i) const
+    {
+        return (_address >> (8 * i)) & 0xFF;
+    }
+private:
+    uint32_t _address;
+};
+
+#endif
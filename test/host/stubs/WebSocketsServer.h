@@ -0,0 +1,33 @@
+//host build stand-in, texts sent to clients are kept for tests
+#ifndef WEBSOCKETSSERVER_H
+#define WEBSOCKETSSERVER_H
+#include <Arduino.h>
+#include <vector>
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN
+} WStype_t;
+
+typedef struct {
+    uint8_t num;
+    std::string text;
+} host_ws_text_t;
+
+class WebSocketsServer
+{
+public:
+    WebSocketsServer (uint16_t port) {}
+    bool sendTXT (uint8_t num, const String & payload)
+    {
+        host_ws_text_t t = {num, payload.c_str()};
+        texts.push_back (t);
+        return true;
+    }
+    std::vector<host_ws_text_t> texts;
+};
+
+#endif
@@ -0,0 +1,29 @@
+//host build stand-in, tcp clients are not used by tested modules
+#ifndef WIFICLIENT_H
+#define WIFICLIENT_H
+#include <Arduino.h>
+#include "IPAddress.h"
+
+class WiFiClient : public Stream
+{
+public:
+    size_t write (uint8_t c)
+    {
+        return 0;
+    }
+    bool connected()
+    {
+        return false;
+    }
+    void stop() {}
+    int availableForWrite()
+    {
+        return 0;
+    }
+    operator bool()
+    {
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,20 @@
+//host build stand-in, tcp server is not used by tested modules
+#ifndef WIFISERVER_H
+#define WIFISERVER_H
+#include "WiFiClient.h"
+
+class WiFiServer
+{
+public:
+    WiFiServer (uint16_t port) {}
+    bool hasClient()
+    {
+        return false;
+    }
+    WiFiClient available()
+    {
+        return WiFiClient();
+    }
+};
+
+#endif
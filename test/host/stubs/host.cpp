@@ -0,0 +1,162 @@
+/*
+  host.cpp - host build stand-in for the Arduino core
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <EEPROM.h>
+#include <FS.h>
+
+uint64_t host_time_us = 0;
+HardwareSerial Serial;
+ESP8266WiFiClass WiFi;
+EEPROMClass EEPROM;
+EspClass ESP;
+uint32_t host_free_heap = 40000;
+host_fs_t host_fs = {std::map<std::string, std::vector<uint8_t> >(), -1, false, 0};
+fs::FS SPIFFS;
+
+unsigned long millis()
+{
+    return host_time_us / 1000;
+}
+
+unsigned long micros()
+{
+    return host_time_us;
+}
+
+void delay (unsigned long ms)
+{
+    host_time_us += (uint64_t) ms * 1000;
+}
+
+void yield() {}
+
+namespace fs
+{
+
+//bytes go to flash page by page, nothing is written after power cut
+size_t File::write (const uint8_t * buf, size_t len)
+{
+    if (!_open || host_fs.power_cut) {
+        return 0;
+    }
+    std::vector<uint8_t> & data = host_fs.files[_name];
+    size_t n = 0;
+    while (n < len) {
+        if (host_fs.budget == 0) {
+            host_fs.power_cut = true;
+            break;
+        }
+        if (host_fs.budget > 0) {
+            host_fs.budget--;
+        }
+        //a new page is programmed each time a page boundary is crossed
+        if ((data.size() % HOST_FS_PAGE_SIZE) == 0) {
+            host_fs.pages++;
+        }
+        data.push_back (buf[n++]);
+    }
+    _written += n;
+    return n;
+}
+
+size_t File::read (uint8_t * buf, size_t len)
+{
+    if (!_open) {
+        return 0;
+    }
+    std::vector<uint8_t> & data = host_fs.files[_name];
+    size_t n = 0;
+    while ((n < len) && (_pos < data.size())) {
+        buf[n++] = data[_pos++];
+    }
+    return n;
+}
+
+bool File::seek (uint32_t pos, SeekMode mode)
+{
+    if (!_open) {
+        return false;
+    }
+    size_t size = host_fs.files[_name].size();
+    if (mode == SeekCur) {
+        pos += _pos;
+    } else if (mode == SeekEnd) {
+        pos += size;
+    }
+    if (pos > size) {
+        return false;
+    }
+    _pos = pos;
+    return true;
+}
+
+//file index page is written again when written file is closed
+void File::close()
+{
+    if (_open && (_written > 0) && !host_fs.power_cut) {
+        host_fs.pages++;
+    }
+    _open = false;
+}
+
+//modes "r", "w" and "a" like SPIFFS
+File FS::open (const char * path, const char * mode)
+{
+    File f;
+    if (host_fs.power_cut) {
+        return f;
+    }
+    std::string name (path);
+    if (mode[0] == 'r') {
+        if (host_fs.files.count (name) == 0) {
+            return f;
+        }
+    } else if (mode[0] == 'w') {
+        host_fs.files[name].clear();
+    } else {
+        host_fs.files[name];
+    }
+    f._open = true;
+    f._name = name;
+    return f;
+}
+
+Dir FS::openDir (const String & path)
+{
+    Dir d;
+    std::map<std::string, std::vector<uint8_t> >::iterator it;
+    for (it = host_fs.files.begin(); it != host_fs.files.end(); ++it) {
+        if (it->first.compare (0, path.length(), path.c_str()) == 0) {
+            d._names.push_back (it->first);
+        }
+    }
+    return d;
+}
+
+bool FS::remove (const char * path)
+{
+    if (host_fs.power_cut) {
+        return false;
+    }
+    return host_fs.files.erase (path) > 0;
+}
+
+}
@@ -0,0 +1 @@
+//host build stand-in, sdk is not used by tested modules
@@ -0,0 +1,192 @@
+/*
+  webjobs_sim.cpp - web command jobs with real CMD_QUEUE and a scripted printer
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+//GCODE_STREAM is replaced by a credit counter which never waits, as send_line does with timeout 0
+//printer answers are given by each scenario, then WEB_JOBS::handle() runs like main loop does
+#include "config.h"
+#include "webjobs.h"
+#include "cmdqueue.h"
+#include "command.h"
+#include "gcode_stream.h"
+#include "syncwebserver.h"
+#include <string>
+#include <vector>
+
+#define PRINTER_WINDOW 2
+
+static int in_flight = 0;
+static std::vector<std::string> sent;
+
+bool GCODE_STREAM::send_line (const char * line, uint32_t timeout)
+{
+    if ((in_flight >= PRINTER_WINDOW) || !CMD_QUEUE::can_add_line()) {
+        return false;
+    }
+    CMD_QUEUE::add_line();
+    in_flight++;
+    sent.push_back (line);
+    return true;
+}
+
+bool COMMAND::check_command (const char * line, size_t len, tpipe output, bool handlelockserial, bool executecmd)
+{
+    std::string s (line, len);
+    return (s.find ("T:") != std::string::npos) || (s.find ("B:") != std::string::npos);
+}
+
+uint8_t CONFIG::GetFirmwareTarget()
+{
+    return MARLIN;
+}
+
+WEBSOCKET_SERVER_CLASS * socket_server = NULL;
+
+static void printer (const char * line)
+{
+    if (CMD_QUEUE::on_answer (line, strlen (line))) {
+        in_flight--;
+    }
+}
+
+static void reset()
+{
+    CMD_QUEUE::clear();
+    in_flight = 0;
+    sent.clear();
+    socket_server->texts.clear();
+    host_time_us += (WEB_JOBS_KEEP + 1) * 1000ULL;
+    WEB_JOBS::handle();
+}
+
+static bool check (const char * label, bool res)
+{
+    printf ("%-52s %s\n", label, res ? "ok" : "FAILED");
+    return res;
+}
+
+//lines go one per loop pass and only when printer has credit
+static bool credits()
+{
+    reset();
+    uint16_t id = WEB_JOBS::start ("G28\nG1 X1\nG1 X2\nG1 X3");
+    for (int i = 0; i < 5; i++) {
+        WEB_JOBS::handle();
+    }
+    bool ok = sent.size() == PRINTER_WINDOW;
+    printer ("ok");
+    WEB_JOBS::handle();
+    ok = ok && (sent.size() == PRINTER_WINDOW + 1);
+    printer ("ok");
+    printer ("ok");
+    WEB_JOBS::handle();
+    printer ("ok");
+    WEB_JOBS::handle();
+    String answer;
+    ok = ok && (sent.size() == 4) && (WEB_JOBS::fetch (id, answer) == JOB_DONE) && (answer == "ok\nok\nok\nok\n");
+    return check ("window of 2 credits, 4 lines, 1 line per pass", ok);
+}
+
+//two jobs interleaved, first one ends on temperatures while second is in flight
+static bool routing()
+{
+    reset();
+    uint16_t a = WEB_JOBS::start ("M105");
+    uint16_t b = WEB_JOBS::start ("M503");
+    WEB_JOBS::handle();
+    for (int i = 0; i < 6; i++) {
+        printer ("T:20.1 /0.0 B:19.8 /0.0 @:0 B@:0");
+    }
+    WEB_JOBS::handle();
+    String answer_a;
+    bool ok = (WEB_JOBS::fetch (a, answer_a) == JOB_DONE) && (answer_a.indexOf ("T:20.1") == 0);
+    printer ("ok");
+    WEB_JOBS::handle();
+    printer ("echo:M92 X80");
+    printer ("ok");
+    WEB_JOBS::handle();
+    String answer_b;
+    ok = ok && (WEB_JOBS::fetch (b, answer_b) == JOB_DONE) && (answer_b == "echo:M92 X80\nok\n");
+    return check ("answers go to their job only", ok);
+}
+
+//answer is pushed once to websocket client, and can be fetched once
+static bool push_and_fetch()
+{
+    reset();
+    uint16_t id = WEB_JOBS::start ("M114", 3);
+    WEB_JOBS::handle();
+    String answer;
+    bool ok = WEB_JOBS::fetch (id, answer) == JOB_RUNNING;
+    printer ("X:0.00 Y:0.00 Z:0.00");
+    printer ("ok");
+    WEB_JOBS::handle();
+    WEB_JOBS::handle();
+    std::string expected = "JOB:" + std::to_string (id) + ":X:0.00 Y:0.00 Z:0.00\nok\n";
+    ok = ok && (socket_server->texts.size() == 1) && (socket_server->texts[0].num == 3) && (socket_server->texts[0].text == expected);
+    ok = ok && (WEB_JOBS::fetch (id, answer) == JOB_DONE) && (WEB_JOBS::fetch (id, answer) == JOB_FREE);
+    return check ("websocket push, fetch once", ok);
+}
+
+//printer silent or busy: job ends after timeout, finished job expires
+static bool timeouts()
+{
+    reset();
+    uint16_t id = WEB_JOBS::start ("G29");
+    WEB_JOBS::handle();
+    printer ("echo:busy: processing");
+    host_time_us += (WEB_JOBS_TIMEOUT - 100) * 1000ULL;
+    WEB_JOBS::handle();
+    String answer;
+    bool ok = WEB_JOBS::fetch (id, answer) == JOB_RUNNING;
+    host_time_us += (WEB_JOBS_TIMEOUT + 100) * 1000ULL;
+    WEB_JOBS::handle();
+    ok = ok && (WEB_JOBS::fetch (id, answer) == JOB_DONE) && (answer == "echo:busy: processing\n");
+    uint16_t id2 = WEB_JOBS::start ("M105");
+    WEB_JOBS::handle();
+    host_time_us += (WEB_JOBS_TIMEOUT + 100) * 1000ULL;
+    WEB_JOBS::handle();
+    host_time_us += (WEB_JOBS_KEEP + 100) * 1000ULL;
+    WEB_JOBS::handle();
+    ok = ok && (WEB_JOBS::fetch (id2, answer) == JOB_FREE);
+    return check ("no answer timeout, finished job expires", ok);
+}
+
+//no free slot: start fails
+static bool slots()
+{
+    reset();
+    bool ok = true;
+    for (int i = 0; i < WEB_JOBS_SIZE; i++) {
+        ok = ok && (WEB_JOBS::start ("M105") != 0);
+    }
+    ok = ok && (WEB_JOBS::start ("M105") == 0);
+    return check ("all slots used", ok);
+}
+
+int main()
+{
+    socket_server = new WEBSOCKET_SERVER_CLASS (81);
+    bool ok = credits();
+    ok = routing() && ok;
+    ok = push_and_fetch() && ok;
+    ok = timeouts() && ok;
+    ok = slots() && ok;
+    return ok ? 0 : 1;
+}